@@ -20,7 +20,7 @@
 int get_sign(s21_decimal val) {
   int sign = 1;
 
-  if ((val.bits[3] & (1 << 31)) == 0) {
+  if ((val.bits[3] & (1u << 31)) == 0) {
     sign = 0;
   }
 
@@ -37,9 +37,9 @@ int get_bits(s21_decimal value, int index) {
 
 void set_sign(s21_decimal *val, int sign) {
   if (sign == 0) {
-    val->bits[3] = val->bits[3] & ~(1 << 31);
+    val->bits[3] = val->bits[3] & ~(1u << 31);
   } else {
-    val->bits[3] = val->bits[3] | (1 << 31);
+    val->bits[3] = val->bits[3] | (1u << 31);
   }
 }
 
@@ -112,6 +112,8 @@ int div_full_bits(s21_decimal value_1, s21_decimal value_2,
     if (!err) {
       exp++;
       value_1 = div_simple(value_1, value_2, &tmp);  // остаток
+      // tmp - очередная цифра частного
+      err = add_simple(*result, tmp, result);
       while (mul_simple(value_1, (s21_decimal){{10, 0, 0, 0}}, &value_1)) {
         // остаток нельзя mul на 10
         div_simple(value_1, (s21_decimal){{2, 0, 0, 0}}, &value_1);
@@ -235,12 +237,12 @@ int add_simple(s21_decimal value_1, s21_decimal value_2, s21_decimal *result) {
 }
 
 int shift_left(s21_decimal *dec) {
-  int flag = (dec->bits[2] & (1 << 31))
+  int flag = (dec->bits[2] & (1u << 31))
                  ? 1
                  : 0;  // 1 - будет переполнение сдвиг невозможен
   if (!flag) {
     for (int byte = 0; byte < 3; byte++) {
-      int flagn = (dec->bits[byte] & (1 << 31)) ? 1 : 0;
+      int flagn = (dec->bits[byte] & (1u << 31)) ? 1 : 0;
       dec->bits[byte] <<= 1;
       dec->bits[byte] += flag;
       flag = flagn;
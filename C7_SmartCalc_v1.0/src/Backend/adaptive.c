@@ -0,0 +1,163 @@
+#include "smartCalc.h"
+
+/// @brief Состояние адаптивного построения
+typedef struct {
+  const program *prog;
+  double tolerance;
+  double y_low;  // видимая область по y
+  double y_high;
+  int limit;  // предел количества точек для текущего начального отрезка
+  samples *out;
+  int error;
+} adaptive_state;
+
+static void append_sample(adaptive_state *state, double x, double y) {
+  samples *out = state->out;
+  if (out->size == out->capacity) {
+    int capacity = out->capacity ? out->capacity * 2 : 256;
+    double *xs = realloc(out->x, sizeof(double) * capacity);
+    if (xs != NULL) out->x = xs;
+    double *ys = realloc(out->y, sizeof(double) * capacity);
+    if (ys != NULL) out->y = ys;
+    if (xs == NULL || ys == NULL) {
+      state->error = CALCULATION_ERROR;
+      return;
+    }
+    out->capacity = capacity;
+  }
+  out->x[out->size] = x;
+  // бесконечности заменяются разрывом, график их не рисует
+  out->y[out->size] = isfinite(y) ? y : NAN;
+  out->size++;
+}
+
+/// @brief Нужно ли делить отрезок: середина далеко от хорды или отрезок
+/// пересекает границу области определения
+static int needs_split(double ya, double ym, double yb, double tolerance) {
+  int finite = isfinite(ya) + isfinite(ym) + isfinite(yb);
+  int result = 0;
+  if (finite == 3)
+    result = fabs(ym - (ya + yb) / 2) > tolerance;
+  else
+    result = finite > 0;
+  return result;
+}
+
+/// @brief Разрыв на отрезке предельной глубины: середина вышла за значения на
+/// концах (полюс) или почти весь перепад приходится на одну половину (скачок).
+/// У крутой, но непрерывной функции половины меняются примерно одинаково.
+static int is_break(double ya, double ym, double yb, double tolerance) {
+  int result = 1;
+  if (isfinite(ya) && isfinite(ym) && isfinite(yb)) {
+    double low = fmin(ya, yb), high = fmax(ya, yb);
+    double smaller = fmin(fabs(ym - ya), fabs(yb - ym));
+    result = ym < low || ym > high ||
+             (high - low > ADAPTIVE_JUMP * tolerance &&
+              smaller * ADAPTIVE_JUMP < high - low);
+  }
+  return result;
+}
+
+/// @brief Полюс со сменой знака на отрезке любой длины: концы разного знака,
+/// а середина далеко вышла за значения на концах
+static int is_pole(double ya, double ym, double yb, double tolerance) {
+  int result = 0;
+  if (isfinite(ya) && isfinite(yb) && ya * yb < 0) {
+    double low = fmin(ya, yb), high = fmax(ya, yb);
+    result = !isfinite(ym) || ym - high > ADAPTIVE_JUMP * tolerance ||
+             low - ym > ADAPTIVE_JUMP * tolerance;
+  }
+  return result;
+}
+
+/// @brief Бисекция к разрыву: каждый раз берется половина с большим перепадом
+static double locate_break(const program *prog, double a, double ya, double b,
+                           double yb, int depth) {
+  double m = (a + b) / 2;
+  for (; depth < ADAPTIVE_MAX_DEPTH; depth++) {
+    double ym = evaluate(prog, m);
+    if (!isfinite(ym)) break;
+    if (fabs(ym - ya) > fabs(yb - ym)) {
+      b = m;
+      yb = ym;
+    } else {
+      a = m;
+      ya = ym;
+    }
+    m = (a + b) / 2;
+  }
+  return m;
+}
+
+/// @brief Добавляет точки отрезка (a, b], a уже добавлена
+static void subdivide(adaptive_state *state, double a, double ya, double b,
+                      double yb, int depth) {
+  double m = (a + b) / 2;
+  double ym = evaluate(state->prog, m);
+  int split = needs_split(ya, ym, yb, state->tolerance);
+  if (split && (isfinite(state->y_low) || isfinite(state->y_high))) {
+    // отрезок целиком вне экрана не уточняется, его точки не видны
+    interval y = evaluate_interval(state->prog, (interval){a, b});
+    if (y.low > state->y_high || y.high < state->y_low) split = 0;
+  }
+  if (split && depth < ADAPTIVE_MAX_DEPTH &&
+      state->out->size + 4 <= state->limit) {
+    subdivide(state, a, ya, m, ym, depth + 1);
+    subdivide(state, m, ym, b, yb, depth + 1);
+  } else if (split && depth >= ADAPTIVE_MAX_DEPTH &&
+             is_break(ya, ym, yb, state->tolerance)) {
+    // линия рвется, соседние ветви не соединяются
+    append_sample(state, m, NAN);
+    append_sample(state, b, yb);
+  } else if (split && is_pole(ya, ym, yb, state->tolerance)) {
+    // точки кончились раньше глубины: полюс ищется бисекцией, это
+    // еще не больше ADAPTIVE_MAX_DEPTH вычислений без новых точек
+    append_sample(state, locate_break(state->prog, a, ya, b, yb, depth), NAN);
+    append_sample(state, b, yb);
+  } else {
+    append_sample(state, m, ym);
+    append_sample(state, b, yb);
+  }
+}
+
+int sample_adaptive(const program *prog, double left, double right,
+                    int initial, int max_samples, double tolerance,
+                    samples *out) {
+  return sample_adaptive_view(prog, left, right, -INFINITY, INFINITY, initial,
+                              max_samples, tolerance, out);
+}
+
+int sample_adaptive_view(const program *prog, double left, double right,
+                         double y_low, double y_high, int initial,
+                         int max_samples, double tolerance, samples *out) {
+  out->x = out->y = NULL;
+  out->size = out->capacity = 0;
+  if (!(right > left) || initial < 1 || max_samples < 2 * initial + 1 ||
+      !(tolerance > 0))
+    return CALCULATION_ERROR;
+
+  adaptive_state state = {prog, tolerance, y_low, y_high, 0, out, OK};
+  // бюджет делится между начальными отрезками, чтобы левые отрезки
+  // не забирали все точки у правых
+  int budget = (max_samples - 1) / initial;
+  double step = (right - left) / initial;
+  double a = left, ya = evaluate(prog, a);
+  append_sample(&state, a, ya);
+  for (int i = 1; i <= initial && state.error == OK; i++) {
+    double b = i == initial ? right : left + i * step;
+    double yb = evaluate(prog, b);
+    state.limit = 1 + i * budget;
+    subdivide(&state, a, ya, b, yb, 0);
+    a = b;
+    ya = yb;
+  }
+  if (state.error != OK) free_samples(out);
+  return state.error;
+}
+
+void free_samples(samples *out) {
+  free(out->x);
+  free(out->y);
+  out->x = out->y = NULL;
+  out->size = out->capacity = 0;
+}
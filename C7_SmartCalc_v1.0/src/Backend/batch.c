@@ -0,0 +1,151 @@
+#include "smartCalc.h"
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+/// @brief Бинарная операция над блоком: a[j] = a[j] op b[j]
+static void batch_binary(opcode op, double *restrict a,
+                         const double *restrict b, int m) {
+  // switch вынесен из циклов, чтобы каждый цикл векторизовался компилятором
+  switch (op) {
+    case OP_ADD:
+      for (int j = 0; j < m; j++) a[j] += b[j];
+      break;
+    case OP_SUB:
+      for (int j = 0; j < m; j++) a[j] -= b[j];
+      break;
+    case OP_MUL:
+      for (int j = 0; j < m; j++) a[j] *= b[j];
+      break;
+    case OP_DIV:
+      for (int j = 0; j < m; j++) a[j] /= b[j];
+      break;
+    case OP_POW:
+      for (int j = 0; j < m; j++) a[j] = pow(a[j], b[j]);
+      break;
+    case OP_MOD:
+      for (int j = 0; j < m; j++) a[j] = fmod(a[j], b[j]);
+      break;
+    default:
+      break;
+  }
+}
+
+/// @brief Квадратный корень блока; sqrt из libm не векторизуется из-за errno
+static void batch_sqrt(double *a, int m) {
+  int j = 0;
+#if defined(__SSE2__)
+  for (; j + 2 <= m; j += 2)
+    _mm_storeu_pd(a + j, _mm_sqrt_pd(_mm_loadu_pd(a + j)));
+#endif
+  for (; j < m; j++) a[j] = sqrt(a[j]);
+}
+
+/// @brief Функция над блоком: a[j] = f(a[j])
+static void batch_unary(opcode op, double *a, int m) {
+  double (*f)(double) = NULL;
+  switch (op) {
+    case OP_SQRT:
+      batch_sqrt(a, m);
+      break;
+    case OP_SQUARE:
+      for (int j = 0; j < m; j++) a[j] *= a[j];
+      break;
+    case OP_SIN:
+      f = sin;
+      break;
+    case OP_COS:
+      f = cos;
+      break;
+    case OP_TAN:
+      f = tan;
+      break;
+    case OP_ASIN:
+      f = asin;
+      break;
+    case OP_ACOS:
+      f = acos;
+      break;
+    case OP_ATAN:
+      f = atan;
+      break;
+    case OP_LN:
+      f = log;
+      break;
+    case OP_LOG:
+      f = log10;
+      break;
+    default:
+      break;
+  }
+  if (f != NULL)
+    for (int j = 0; j < m; j++) a[j] = f(a[j]);
+}
+
+void evaluate_batch_outputs(const program *prog, int outputs, const double *x,
+                            double **y, int n) {
+  // стек хранится по столбцам: у каждого уровня свой блок из BATCH_SIZE чисел
+  // за уровнями стека лежат ячейки общих подвыражений, тоже по блоку
+  int depth = prog->depth > 0 ? prog->depth : 1;
+  double *stack = malloc(sizeof(double) * BATCH_SIZE * (depth + prog->slots));
+  if (stack == NULL) {
+    // evaluate возвращает только первый результат
+    for (int k = 0; k < outputs; k++)
+      for (int i = 0; i < n; i++) y[k][i] = k == 0 ? evaluate(prog, x[i]) : NAN;
+    return;
+  }
+  double *slots = stack + BATCH_SIZE * depth;
+  for (int first = 0; first < n; first += BATCH_SIZE) {
+    int m = n - first < BATCH_SIZE ? n - first : BATCH_SIZE;
+    const double *block = x + first;
+    int top = 0;
+    for (int i = 0; i < prog->size; i++) {
+      const instruction *ins = &prog->code[i];
+      double *level = stack + top * BATCH_SIZE;
+      switch (ins->op) {
+        case OP_NUM:
+          for (int j = 0; j < m; j++) level[j] = ins->value;
+          top++;
+          break;
+        case OP_X:
+          memcpy(level, block, sizeof(double) * m);
+          top++;
+          break;
+        case OP_NEG_X:
+          for (int j = 0; j < m; j++) level[j] = -block[j];
+          top++;
+          break;
+        case OP_STORE:
+          memcpy(slots + ins->slot * BATCH_SIZE, level - BATCH_SIZE,
+                 sizeof(double) * m);
+          break;
+        case OP_LOAD:
+          memcpy(level, slots + ins->slot * BATCH_SIZE, sizeof(double) * m);
+          top++;
+          break;
+        case OP_ADD:
+        case OP_SUB:
+        case OP_MUL:
+        case OP_DIV:
+        case OP_POW:
+        case OP_MOD:
+          top--;
+          batch_binary(ins->op, stack + (top - 1) * BATCH_SIZE,
+                       stack + top * BATCH_SIZE, m);
+          break;
+        default:
+          batch_unary(ins->op, stack + (top - 1) * BATCH_SIZE, m);
+          break;
+      }
+    }
+    // результаты программ остаются на нижних уровнях стека по порядку
+    for (int k = 0; k < outputs; k++)
+      memcpy(y[k] + first, stack + k * BATCH_SIZE, sizeof(double) * m);
+  }
+  free(stack);
+}
+
+void evaluate_batch(const program *prog, const double *x, double *y, int n) {
+  evaluate_batch_outputs(prog, 1, x, &y, n);
+}
@@ -0,0 +1,122 @@
+#include "smartCalc.h"
+
+/// @brief Ключ кэша: лексемы через один пробел. "|" и пробелы только
+/// разделяют лексемы, поэтому "sin|(|x|)" и " sin ( x ) " дают один ключ
+static void normalize(const char *expression, char *key) {
+  size_t len = 0;
+  int separator = 0;
+  for (const char *p = expression; *p; p++) {
+    if (*p == '|' || *p == ' ') {
+      separator = len > 0;
+    } else {
+      if (separator) key[len++] = ' ';
+      key[len++] = *p;
+      separator = 0;
+    }
+  }
+  key[len] = '\0';
+}
+
+static unsigned long hash_key(const char *key) {
+  unsigned long hash = 14695981039346656037UL;  // FNV-1a
+  for (; *key; key++) {
+    hash ^= (unsigned char)*key;
+    hash *= 1099511628211UL;
+  }
+  return hash;
+}
+
+static void unlink_entry(program_cache *cache, cache_entry *e) {
+  if (e->prev) e->prev->next = e->next;
+  if (e->next) e->next->prev = e->prev;
+  if (cache->head == e) cache->head = e->next;
+  if (cache->tail == e) cache->tail = e->prev;
+  e->prev = e->next = NULL;
+}
+
+static void push_front(program_cache *cache, cache_entry *e) {
+  e->next = cache->head;
+  if (cache->head) cache->head->prev = e;
+  cache->head = e;
+  if (cache->tail == NULL) cache->tail = e;
+}
+
+/// @brief Убирает давно не использованное выражение
+static void evict(program_cache *cache) {
+  cache_entry *e = cache->tail;
+  cache_entry **link = &cache->buckets[e->hash % cache->bucket_count];
+  while (*link != e) link = &(*link)->chain;
+  *link = e->chain;
+  unlink_entry(cache, e);
+  free_program(&e->prog);
+  free(e->key);
+  free(e);
+  cache->size--;
+}
+
+int cache_init(program_cache *cache, int capacity) {
+  cache->head = cache->tail = NULL;
+  cache->size = 0;
+  cache->capacity = capacity;
+  cache->hits = cache->misses = 0;
+  cache->symbols = NULL;
+  // корзин вдвое больше записей, цепочки остаются короткими
+  cache->bucket_count = capacity > 0 ? 2 * capacity : 1;
+  cache->buckets = calloc(cache->bucket_count, sizeof(cache_entry *));
+  return cache->buckets != NULL && capacity > 0 ? OK : CALCULATION_ERROR;
+}
+
+const program *cache_get(program_cache *cache, const char *expression,
+                         int *flag) {
+  char *key = malloc(strlen(expression) + 1);
+  if (key == NULL) {
+    *flag = CALCULATION_ERROR;
+    return NULL;
+  }
+  normalize(expression, key);
+  unsigned long hash = hash_key(key);
+  cache_entry **bucket = &cache->buckets[hash % cache->bucket_count];
+  cache_entry *e = *bucket;
+  while (e != NULL && (e->hash != hash || strcmp(e->key, key))) e = e->chain;
+
+  unsigned long version = cache->symbols ? cache->symbols->version : 0;
+  if (e != NULL) {
+    cache->hits++;
+    free(key);
+    unlink_entry(cache, e);
+    if (e->version != version) {
+      // имена переопределены: подставленные тела устарели
+      if (e->error == OK) free_program(&e->prog);
+      e->error = compile_symbols(e->key, cache->symbols, &e->prog);
+      e->version = version;
+    }
+  } else {
+    cache->misses++;
+    e = malloc(sizeof(cache_entry));
+    if (e == NULL) {
+      free(key);
+      *flag = CALCULATION_ERROR;
+      return NULL;
+    }
+    if (cache->size == cache->capacity) evict(cache);
+    // ошибки тоже запоминаются, неправильное выражение не разбирается снова
+    e->error = compile_symbols(key, cache->symbols, &e->prog);
+    e->version = version;
+    e->key = key;
+    e->hash = hash;
+    e->prev = e->next = NULL;
+    e->chain = *bucket;
+    *bucket = e;
+    cache->size++;
+  }
+  push_front(cache, e);
+  *flag = e->error;
+  return e->error == OK ? &e->prog : NULL;
+}
+
+void cache_free(program_cache *cache) {
+  while (cache->tail != NULL) evict(cache);
+  free(cache->buckets);
+  cache->buckets = NULL;
+  cache->bucket_count = 0;
+}
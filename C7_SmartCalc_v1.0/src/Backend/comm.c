@@ -26,12 +26,98 @@ int check_brackets_result(char *input_str, int *quantity) {
 }
 
 void to_lexems(char *input_str, char **lexems) {
+  // строка режется на месте без strtok, у которого общее скрытое состояние
   int lexcount = 0;
-  char *del = strtok(input_str, "|");
-  while (del != NULL) {
-    lexems[lexcount++] = del;
-    del = strtok(NULL, "|");
+  char *start = input_str;
+  for (char *p = input_str;; p++) {
+    if (*p == '|' || *p == '\0') {
+      int end = *p == '\0';
+      *p = '\0';
+      if (p > start) lexems[lexcount++] = start;
+      if (end) break;
+      start = p + 1;
+    }
+  }
+}
+
+/// @brief Узел стека операций; свободный узел хранит ссылку на следующий
+/// свободный
+typedef union stack_node {
+  stack_char action;
+  union stack_node *free;
+} stack_node;
+
+typedef struct stack_block {
+  struct stack_block *next;
+  stack_node nodes[STACK_POOL_BLOCK];
+} stack_block;
+
+/// @brief Пул узлов стеков потока: освобожденные узлы идут в список
+/// свободных, новые берутся подряд из блоков. Когда занятых узлов не
+/// остается, пул целиком возвращается к началу первого блока, блоки остаются
+/// для следующих вычислений. Пулом пользуется только стек lexems_to_RPN,
+/// который вызывают тесты и bench: калькулятор, графики, CLI и перебор
+/// считают скомпилированные выражения на стеке в массиве и пул не трогают
+typedef struct {
+  stack_block *first;
+  stack_block *current;
+  int used;  // занято узлов в current
+  int live;  // узлов во всех стеках
+  stack_node *free;
+} stack_pool;
+
+static _Thread_local stack_pool pool;
+
+static void *take_node(void) {
+  stack_node *node = pool.free;
+  if (node != NULL) {
+    pool.free = node->free;
+  } else {
+    if (pool.current == NULL || pool.used == STACK_POOL_BLOCK) {
+      stack_block *next = pool.current ? pool.current->next : pool.first;
+      if (next == NULL) {
+        next = malloc(sizeof(stack_block));
+        if (next != NULL) {
+          next->next = NULL;
+          if (pool.current != NULL)
+            pool.current->next = next;
+          else
+            pool.first = next;
+        }
+      }
+      if (next != NULL) {
+        pool.current = next;
+        pool.used = 0;
+      }
+    }
+    if (pool.current != NULL && pool.used < STACK_POOL_BLOCK)
+      node = &pool.current->nodes[pool.used++];
   }
+  if (node != NULL) pool.live++;
+  return node;
+}
+
+static void give_node(void *node) {
+  stack_node *free_node = node;
+  free_node->free = pool.free;
+  pool.free = free_node;
+  if (--pool.live == 0) {
+    pool.free = NULL;
+    pool.current = pool.first;
+    pool.used = 0;
+  }
+}
+
+void free_stack_pool(void) {
+  while (pool.first != NULL) {
+    stack_block *next = pool.first->next;
+    free(pool.first);
+    pool.first = next;
+  }
+  pool.current = NULL;
+  pool.used = 0;
+  pool.live = 0;
+  pool.free = NULL;
 }
 
 char *look_last_char(stack_char **head) {
@@ -40,7 +126,7 @@ char *look_last_char(stack_char **head) {
 }
 
 void creating_top_stack_char(stack_char **head, char *value) {
-  stack_char *node = malloc(sizeof(stack_char));
+  stack_char *node = take_node();
 
   if (node != NULL) {
     node->action = value;
@@ -53,7 +139,7 @@ char *use_top_stack_char(stack_char **head) {
   stack_char *top = *head;
   char *value = top->action;
   *head = top->next;
-  free(top);
+  give_node(top);
   return value;
 }
 
@@ -84,61 +170,19 @@ int is_number(char *number) {
 }
 
 int is_function(char *string) {
-  int flag = 0;
-  if (!strcmp(string, "sin") || !strcmp(string, "cos") ||
-      !strcmp(string, "tan") || !strcmp(string, "asin") ||
-      !strcmp(string, "acos") || !strcmp(string, "atan") ||
-      !strcmp(string, "sqrt") || !strcmp(string, "ln") ||
-      !strcmp(string, "log")) {
-    flag = 1;
-  }
-
-  return flag;
+  opcode op;
+  return resolve_operation(string, strlen(string), &op) == 1;
 }
 
 int is_operator(char *string) {
-  int flag = 0;
-  if (!strcmp(string, "+") || !strcmp(string, "-") || !strcmp(string, "*") ||
-      !strcmp(string, "/") || !strcmp(string, "^") || !strcmp(string, "mod")) {
-    flag = 1;
-  }
-
-  return flag;
+  opcode op;
+  return resolve_operation(string, strlen(string), &op) == 2;
 }
 
 int priority(char *string) {
+  opcode op;
   int result = 0;
-  if (!strcmp(string, "-") || !strcmp(string, "+")) result = 1;
-  if (!strcmp(string, "/") || !strcmp(string, "*") || !strcmp(string, "mod"))
-    result = 2;
-  if (!strcmp(string, "^")) result = 3;
-  if (!strcmp(string, "sin") || !strcmp(string, "cos") ||
-      !strcmp(string, "tan") || !strcmp(string, "asin") ||
-      !strcmp(string, "acos") || !strcmp(string, "atan") ||
-      !strcmp(string, "sqrt") || !strcmp(string, "ln") ||
-      !strcmp(string, "log")) {
-    result = 5;
-  }
+  if (resolve_operation(string, strlen(string), &op))
+    result = operation_priority(op);
   return result;
 }
-
-void creating_top_stack_num(stack_num **head, long double value) {
-  stack_num *node = malloc(sizeof(stack_num));
-
-  if (node != NULL) {
-    node->data = value;
-    node->next = *head;
-    *head = node;
-  }
-}
-
-long double use_top_stack_num(stack_num **head) {
-  long double value = 0;
-  if (*head != NULL) {
-    stack_num *top = *head;
-    value = top->data;
-    *head = top->next;
-    free(top);
-  }
-  return value;
-}
@@ -0,0 +1,293 @@
+#include "smartCalc.h"
+
+/// @brief Перевод операнда в инструкцию, разбор числа происходит здесь один раз
+static instruction compile_operand(const char *token) {
+  instruction result = {.op = OP_NUM};
+  if (!strcmp(token, "x")) {
+    result.op = OP_X;
+  } else if (!strcmp(token, "-x")) {
+    result.op = OP_NEG_X;
+  } else if (!strcmp(token, "pi")) {
+    result.value = M_PI;
+  } else if (!strcmp(token, "-pi")) {
+    result.value = -M_PI;
+  } else {
+    result.value = atof(token);
+  }
+  return result;
+}
+
+/// @brief Проверяет глубину стека собранной программы и оптимизирует ее
+/// @param optimize 0 для программ, которые считаются не в double
+static int finish_program(program *prog, int optimize) {
+  // глубина стека считается при компиляции, поэтому evaluate не проверяет ее
+  int flag = OK;
+  int depth = 0;
+  for (int i = 0; i < prog->size && flag == OK; i++) {
+    int arity = operation_arity(prog->code[i].op);
+    if (depth < arity) flag = CALCULATION_ERROR;
+    depth += arity == 0 ? 1 : 1 - arity;
+    if (depth > prog->depth) prog->depth = depth;
+    if (prog->depth > PROGRAM_STACK_SIZE) flag = CALCULATION_ERROR;
+  }
+  if (flag != OK || depth != 1) {
+    free_program(prog);
+    flag = CALCULATION_ERROR;
+  } else if (optimize) {
+    // без оптимизации программа остается верной, только медленнее
+    optimize_program(prog);
+  }
+  return flag;
+}
+
+int compile_RPN(char **RPN, program *prog) {
+  int flag = OK;
+  int size = 0;
+  while (RPN[size]) size++;
+
+  prog->code = malloc(sizeof(instruction) * (size > 0 ? size : 1));
+  prog->size = 0;
+  prog->depth = 0;
+  prog->slots = 0;
+  if (prog->code == NULL) return CALCULATION_ERROR;
+
+  for (int i = 0; i < size && flag == OK; i++) {
+    opcode op;
+    if (is_number(RPN[i]))
+      prog->code[prog->size++] = compile_operand(RPN[i]);
+    else if (resolve_operation(RPN[i], strlen(RPN[i]), &op))
+      prog->code[prog->size++] = (instruction){.op = op};
+    else
+      flag = CALCULATION_ERROR;
+  }
+  if (flag == OK) {
+    flag = finish_program(prog, 1);
+  } else {
+    free_program(prog);
+  }
+  return flag;
+}
+
+/// @brief Перенос операции со стека операций в программу
+static void emit_operation(program *prog, const token *t) {
+  if (t->type == TOKEN_NEGATE) {
+    // -f(x) считается как f(x) * -1, константа потом сворачивается
+    prog->code[prog->size++] = (instruction){.op = OP_NUM, .value = -1};
+    prog->code[prog->size++] = (instruction){.op = OP_MUL};
+  } else {
+    prog->code[prog->size++] = (instruction){.op = t->op};
+  }
+}
+
+static int token_priority(const token *t) {
+  return t->type == TOKEN_NEGATE ? 5 : operation_priority(t->op);
+}
+
+/// @brief Сортировочная станция по готовым лексемам
+/// @param flag Код ошибки разбора строки на лексемы
+/// @param tokens Лексемы, освобождаются здесь
+/// @param literals NULL - программа оптимизируется; иначе остается как есть,
+/// а сюда сохраняются лексемы чисел по номерам инструкций
+static int compile_tokens(int flag, token_list *tokens, program *prog,
+                          token **literals) {
+  token *stack = NULL;
+  int top = 0;
+  prog->code = NULL;
+  prog->size = 0;
+  prog->depth = 0;
+  prog->slots = 0;
+  if (literals != NULL) *literals = NULL;
+  if (flag == OK) {
+    // каждая лексема дает не больше двух инструкций
+    prog->code = malloc(sizeof(instruction) * (2 * tokens->size + 1));
+    stack = malloc(sizeof(token) * (tokens->size + 1));
+    if (prog->code == NULL || stack == NULL) flag = CALCULATION_ERROR;
+  }
+  if (flag == OK && literals != NULL) {
+    // -1 унарного минуса остается без лексемы, у него text == NULL
+    *literals = calloc(2 * tokens->size + 1, sizeof(token));
+    if (*literals == NULL) flag = CALCULATION_ERROR;
+  }
+
+  for (int i = 0; i < tokens->size && flag == OK; i++) {
+    const token *t = &tokens->items[i];
+    switch (t->type) {
+      case TOKEN_OPERAND:
+        if (literals != NULL) (*literals)[prog->size] = *t;
+        prog->code[prog->size++] =
+            (instruction){.op = t->op, .value = t->value};
+        break;
+      case TOKEN_FUNCTION:
+      case TOKEN_NEGATE:
+      case TOKEN_LEFT:
+        stack[top++] = *t;
+        break;
+      case TOKEN_RIGHT:
+        while (top > 0 && stack[top - 1].type != TOKEN_LEFT)
+          emit_operation(prog, &stack[--top]);
+        if (top > 0)
+          top--;
+        else
+          flag = CALCULATION_ERROR;
+        break;
+      case TOKEN_OPERATOR:
+        // ^ правоассоциативна: 2^3^2 = 2^(3^2)
+        while (top > 0 && stack[top - 1].type != TOKEN_LEFT &&
+               !(t->op == OP_POW && stack[top - 1].op == OP_POW &&
+                 stack[top - 1].type == TOKEN_OPERATOR) &&
+               token_priority(&stack[top - 1]) >= operation_priority(t->op))
+          emit_operation(prog, &stack[--top]);
+        stack[top++] = *t;
+        break;
+    }
+  }
+  while (top > 0 && flag == OK) {
+    if (stack[top - 1].type == TOKEN_LEFT)
+      flag = CALCULATION_ERROR;
+    else
+      emit_operation(prog, &stack[--top]);
+  }
+  free(stack);
+  free_tokens(tokens);
+  if (flag == OK) {
+    flag = finish_program(prog, literals == NULL);
+  } else {
+    free_program(prog);
+  }
+  if (flag != OK && literals != NULL) {
+    free(*literals);
+    *literals = NULL;
+  }
+  return flag;
+}
+
+int compile_expression(const char *input, program *prog) {
+  token_list tokens;
+  int flag = tokenize(input, &tokens);
+  return compile_tokens(flag, &tokens, prog, NULL);
+}
+
+int compile_symbols(const char *input, const symbol_table *table,
+                    program *prog) {
+  token_list tokens;
+  int flag = tokenize_symbols(input, table, &tokens);
+  return compile_tokens(flag, &tokens, prog, NULL);
+}
+
+int compile_plain(const char *input, const symbol_table *table,
+                  program *prog, token **literals) {
+  token_list tokens;
+  int flag = tokenize_symbols(input, table, &tokens);
+  return compile_tokens(flag, &tokens, prog, literals);
+}
+
+double evaluate(const program *prog, double x) {
+  double stack[PROGRAM_STACK_SIZE];
+  double slots[PROGRAM_STACK_SIZE];
+  int top = 0;
+  const instruction *code = prog->code;
+  for (int i = 0; i < prog->size; i++) {
+    switch (code[i].op) {
+      case OP_NUM:
+        stack[top++] = code[i].value;
+        break;
+      case OP_X:
+        stack[top++] = x;
+        break;
+      case OP_NEG_X:
+        stack[top++] = -x;
+        break;
+      case OP_ADD:
+        top--;
+        stack[top - 1] += stack[top];
+        break;
+      case OP_SUB:
+        top--;
+        stack[top - 1] -= stack[top];
+        break;
+      case OP_MUL:
+        top--;
+        stack[top - 1] *= stack[top];
+        break;
+      case OP_DIV:
+        top--;
+        stack[top - 1] /= stack[top];
+        break;
+      case OP_POW:
+        top--;
+        stack[top - 1] = pow(stack[top - 1], stack[top]);
+        break;
+      case OP_MOD:
+        top--;
+        stack[top - 1] = fmod(stack[top - 1], stack[top]);
+        break;
+      case OP_SIN:
+        stack[top - 1] = sin(stack[top - 1]);
+        break;
+      case OP_COS:
+        stack[top - 1] = cos(stack[top - 1]);
+        break;
+      case OP_TAN:
+        stack[top - 1] = tan(stack[top - 1]);
+        break;
+      case OP_ASIN:
+        stack[top - 1] = asin(stack[top - 1]);
+        break;
+      case OP_ACOS:
+        stack[top - 1] = acos(stack[top - 1]);
+        break;
+      case OP_ATAN:
+        stack[top - 1] = atan(stack[top - 1]);
+        break;
+      case OP_SQRT:
+        stack[top - 1] = sqrt(stack[top - 1]);
+        break;
+      case OP_LN:
+        stack[top - 1] = log(stack[top - 1]);
+        break;
+      case OP_LOG:
+        stack[top - 1] = log10(stack[top - 1]);
+        break;
+      case OP_SQUARE:
+        stack[top - 1] *= stack[top - 1];
+        break;
+      case OP_STORE:
+        slots[code[i].slot] = stack[top - 1];
+        break;
+      case OP_LOAD:
+        stack[top++] = slots[code[i].slot];
+        break;
+    }
+  }
+  return top > 0 ? stack[0] : 0;
+}
+
+double evaluate_operation(opcode op, double a, double b) {
+  // тем же evaluate, что и при вычислении, чтобы результат совпадал до бита
+  instruction code[3];
+  int size = 0;
+  code[size++] = (instruction){.op = OP_NUM, .value = a};
+  if (operation_arity(op) == 2)
+    code[size++] = (instruction){.op = OP_NUM, .value = b};
+  code[size++] = (instruction){.op = op};
+  program prog = {code, size, 2, 0};
+  return evaluate(&prog, 0);
+}
+
+int copy_program(const program *src, program *dst) {
+  *dst = *src;
+  dst->code = malloc(sizeof(instruction) * (src->size > 0 ? src->size : 1));
+  if (dst->code != NULL)
+    memcpy(dst->code, src->code, sizeof(instruction) * src->size);
+  else
+    dst->size = 0;
+  return dst->code != NULL ? OK : CALCULATION_ERROR;
+}
+
+void free_program(program *prog) {
+  free(prog->code);
+  prog->code = NULL;
+  prog->size = 0;
+  prog->depth = 0;
+  prog->slots = 0;
+}
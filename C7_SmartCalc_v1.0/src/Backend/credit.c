@@ -0,0 +1,140 @@
+#include "decimal.h"
+
+/// @brief Один блок памяти на все столбцы графика
+static int allocate(credit_schedule *s, int size) {
+  size_t row = 4 * sizeof(double) + sizeof(int);
+  double *block = malloc(row * size);
+  s->payment = block;
+  s->principal = block + size;
+  s->interest = block + 2 * size;
+  s->balance = block + 3 * size;
+  s->date = (int *)(block + 4 * size);
+  s->size = block != NULL ? size : 0;
+  return block != NULL ? OK : CALCULATION_ERROR;
+}
+
+/// @brief Считает итоги и, если выделены строки, заполняет их
+static void fill(double sum, int months, double rate, int type, int start,
+                 credit_schedule *s) {
+  double monthly = rate / 100 / 12;
+  double annuity = sum / months;
+  if (monthly > 0)
+    annuity = sum * monthly / (1 - pow(1 + monthly, -months));
+  double balance = sum;
+  s->overpayment = 0;
+  s->total = 0;
+  for (int i = 0; i < months; i++) {
+    double interest = balance * monthly;
+    // дифференцированный: основной долг делится поровну
+    double principal = sum / months;
+    if (type == CREDIT_ANNUITY) principal = annuity - interest;
+    balance -= principal;
+    if (i == 0) s->first_payment = principal + interest;
+    s->last_payment = principal + interest;
+    s->overpayment += interest;
+    s->total += principal + interest;
+    if (s->size > 0) {
+      s->payment[i] = principal + interest;
+      s->principal[i] = principal;
+      s->interest[i] = interest;
+      s->balance[i] = balance;
+      // дата считается от начала, 31 число не сползает на 28
+      s->date[i] = add_months(start, i + 1);
+    }
+  }
+}
+
+/// @brief fill в s21_decimal: проценты, остаток и итоги считаются с 28
+/// знаками и переводятся в double только при записи
+static int fill_decimal(double sum_value, int months, double rate_value,
+                        int type, int start, credit_schedule *s) {
+  s21_decimal one = {{1, 0, 0, 0}}, sum, rate, count, power;
+  s21_decimal zero = {{0, 0, 0, 0}}, overpayment = zero, total = zero;
+  int error = decimal_from_double(sum_value, &sum);
+  error |= decimal_from_double(rate_value, &rate);
+  error |= s21_from_int_to_decimal(months, &count);
+  s21_decimal monthly, equal, annuity;
+  error |= s21_div(rate, (s21_decimal){{1200, 0, 0, 0}}, &monthly);
+  error |= s21_div(sum, count, &equal);
+  annuity = equal;
+  if (!error && s21_is_greater(monthly, zero)) {
+    // sum * monthly / (1 - (1 + monthly)^-months)
+    s21_decimal base, exponent, divisor;
+    error |= s21_add(one, monthly, &base);
+    error |= s21_negate(count, &exponent);
+    error |= decimal_power(base, exponent, &power);
+    error |= s21_sub(one, power, &divisor);
+    error |= s21_mul(sum, monthly, &annuity);
+    error |= s21_div(annuity, divisor, &annuity);
+  }
+  s21_decimal balance = sum;
+  for (int i = 0; i < months && !error; i++) {
+    s21_decimal interest, principal = equal, payment;
+    error |= s21_mul(balance, monthly, &interest);
+    if (type == CREDIT_ANNUITY) error |= s21_sub(annuity, interest, &principal);
+    error |= s21_sub(balance, principal, &balance);
+    error |= s21_add(principal, interest, &payment);
+    error |= s21_add(overpayment, interest, &overpayment);
+    error |= s21_add(total, payment, &total);
+    if (i == 0) s->first_payment = decimal_to_double(payment);
+    s->last_payment = decimal_to_double(payment);
+    if (s->size > 0) {
+      s->payment[i] = decimal_to_double(payment);
+      s->principal[i] = decimal_to_double(principal);
+      s->interest[i] = decimal_to_double(interest);
+      s->balance[i] = decimal_to_double(balance);
+      s->date[i] = add_months(start, i + 1);
+    }
+  }
+  s->overpayment = decimal_to_double(overpayment);
+  s->total = decimal_to_double(total);
+  return error ? CALCULATION_ERROR : OK;
+}
+
+static int valid(double sum, int months, double rate) {
+  return sum > 0 && months > 0 && rate >= 0;
+}
+
+int credit_calculate(double sum, int months, double rate, int type, int start,
+                     credit_schedule *s) {
+  s->size = 0;
+  s->payment = NULL;
+  int flag = CALCULATION_ERROR;
+  if (valid(sum, months, rate) && allocate(s, months) == OK) {
+    fill(sum, months, rate, type, start, s);
+    flag = OK;
+  }
+  return flag;
+}
+
+int credit_calculate_decimal(double sum, int months, double rate, int type,
+                             int start, credit_schedule *s) {
+  s->size = 0;
+  s->payment = NULL;
+  int flag = CALCULATION_ERROR;
+  if (valid(sum, months, rate) && allocate(s, months) == OK) {
+    flag = fill_decimal(sum, months, rate, type, start, s);
+    if (flag != OK) free_credit_schedule(s);
+  }
+  return flag;
+}
+
+int credit_summary(double sum, int months, double rate, int type,
+                   credit_schedule *s) {
+  s->size = 0;
+  s->payment = s->principal = s->interest = s->balance = NULL;
+  s->date = NULL;
+  int flag = CALCULATION_ERROR;
+  if (valid(sum, months, rate)) {
+    fill(sum, months, rate, type, 0, s);
+    flag = OK;
+  }
+  return flag;
+}
+
+void free_credit_schedule(credit_schedule *s) {
+  free(s->payment);
+  s->payment = s->principal = s->interest = s->balance = NULL;
+  s->date = NULL;
+  s->size = 0;
+}
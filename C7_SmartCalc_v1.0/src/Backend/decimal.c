@@ -0,0 +1,249 @@
+#include "decimal.h"
+
+// pi с 28 знаками после точки
+#define DECIMAL_PI "3.1415926535897932384626433833"
+
+/// @brief Дописывает цифру к мантиссе: мантисса * 10 + digit
+/// @return Код ошибки при переполнении 96 бит, тогда число не меняется
+static int push_digit(s21_decimal *value, int digit) {
+  unsigned long long carry = digit;
+  unsigned int bits[3];
+  for (int i = 0; i < 3; i++) {
+    carry += (unsigned long long)value->bits[i] * 10;
+    bits[i] = (unsigned int)carry;
+    carry >>= 32;
+  }
+  if (carry == 0) memcpy(value->bits, bits, sizeof(bits));
+  return carry == 0 ? OK : CALCULATION_ERROR;
+}
+
+/// @brief Делит мантиссу на 10
+/// @return Отброшенная цифра
+static int pop_digit(s21_decimal *value) {
+  unsigned long long rest = 0;
+  for (int i = 2; i >= 0; i--) {
+    rest = rest << 32 | value->bits[i];
+    value->bits[i] = (unsigned int)(rest / 10);
+    rest %= 10;
+  }
+  return (int)rest;
+}
+
+static int add_one(s21_decimal *value) {
+  int i = 0;
+  while (i < 3 && ++value->bits[i] == 0) i++;
+  return i < 3 ? OK : CALCULATION_ERROR;
+}
+
+static int is_digit(char c) { return c >= '0' && c <= '9'; }
+
+/// @brief Порядок после "e": знак и цифры
+static const char *read_exponent(const char *p, int *exponent, int *flag) {
+  int sign = *p == '-' ? -1 : 1;
+  if (*p == '-' || *p == '+') p++;
+  if (!is_digit(*p)) *flag = CALCULATION_ERROR;
+  for (*exponent = 0; is_digit(*p); p++)
+    if (*exponent < 1000) *exponent = *exponent * 10 + *p - '0';
+  *exponent *= sign;
+  return p;
+}
+
+int decimal_from_string(const char *text, s21_decimal *out) {
+  s21_decimal result = {{0, 0, 0, 0}};
+  const char *p = text;
+  int negative = *p == '-';
+  if (*p == '-' || *p == '+') p++;
+  int flag = OK;
+  int digits = 0;
+  int fraction = -1;  // цифр после точки, -1 без точки
+  int rest = -1;      // первая отброшенная цифра
+  for (; is_digit(*p) || (*p == '.' && fraction < 0); p++) {
+    if (*p == '.') {
+      fraction = 0;
+    } else {
+      digits++;
+      if (rest < 0 && push_digit(&result, *p - '0') == OK) {
+        if (fraction >= 0) fraction++;
+      } else if (fraction >= 0) {
+        if (rest < 0) rest = *p - '0';
+      } else {
+        flag = CALCULATION_ERROR;  // целая часть не помещается
+      }
+    }
+  }
+  int exponent = 0;
+  if (digits > 0 && (*p == 'e' || *p == 'E'))
+    p = read_exponent(p + 1, &exponent, &flag);
+  if (digits == 0 || *p != '\0') flag = CALCULATION_ERROR;
+
+  int point = (fraction > 0 ? fraction : 0) - exponent;
+  for (; flag == OK && point < 0; point++) flag = push_digit(&result, 0);
+  for (; point > DECIMAL_MAX_SCALE; point--) rest = pop_digit(&result);
+  if (flag == OK && rest >= 5) flag = add_one(&result);
+  if (flag == OK) {
+    result.bits[3] = (unsigned int)point << 16;
+    set_sign(&result, negative);
+    *out = result;
+  }
+  return flag;
+}
+
+void decimal_to_string(s21_decimal value, char *text) {
+  int point = (value.bits[3] >> 16) & 0xff;
+  int negative =
+      get_sign(value) && (value.bits[0] || value.bits[1] || value.bits[2]);
+  char digits[DECIMAL_TEXT_SIZE];
+  int count = 0;
+  // цифры с младшей; не меньше, чем знаков после точки, и одна перед ней
+  while (value.bits[0] || value.bits[1] || value.bits[2] || count <= point)
+    digits[count++] = '0' + pop_digit(&value);
+  int skip = 0;  // нули в конце дробной части
+  while (skip < point && digits[skip] == '0') skip++;
+  char *p = text;
+  if (negative) *p++ = '-';
+  for (int i = count - 1; i >= skip; i--) {
+    *p++ = digits[i];
+    if (i == point && i > skip) *p++ = '.';
+  }
+  *p = '\0';
+}
+
+/// @brief Константа из своей записи во входной строке, pi - с 28 знаками
+static int decimal_constant(const token *literal, double value,
+                            s21_decimal *out) {
+  char text[NUMBER_TEXT_SIZE];
+  literal_text(literal, value, text);
+  const char *digits = text + (*text == '-' || *text == '+');
+  if (!strcmp(digits, "pi"))
+    strcpy(text, *text == '-' ? "-" DECIMAL_PI : DECIMAL_PI);
+  return decimal_from_string(text, out);
+}
+
+int compile_decimal(const char *input, const symbol_table *table,
+                    decimal_program *out) {
+  token *literals = NULL;
+  out->constants = NULL;
+  int flag = compile_plain(input, table, &out->prog, &literals);
+  if (flag == OK) {
+    out->constants = malloc(sizeof(s21_decimal) * out->prog.size);
+    if (out->constants == NULL) flag = CALCULATION_ERROR;
+  }
+  for (int i = 0; flag == OK && i < out->prog.size; i++)
+    if (out->prog.code[i].op == OP_NUM)
+      flag = decimal_constant(&literals[i], out->prog.code[i].value,
+                              &out->constants[i]);
+  free(literals);
+  if (flag != OK) free_decimal_program(out);
+  return flag;
+}
+
+/// @brief Коды s21_decimal (переполнение, деление на ноль) в код ошибки
+static int checked(int code) { return code == 0 ? OK : CALCULATION_ERROR; }
+
+/// @brief Остаток как у fmod: a - trunc(a / b) * b, знак как у a
+static int decimal_mod(s21_decimal a, s21_decimal b, s21_decimal *result) {
+  s21_decimal quotient, product;
+  int flag = checked(s21_div(a, b, &quotient));
+  if (flag == OK) {
+    s21_truncate(quotient, &quotient);
+    flag = checked(s21_mul(quotient, b, &product));
+  }
+  if (flag == OK) flag = checked(s21_sub(a, product, result));
+  return flag;
+}
+
+int decimal_from_double(double value, s21_decimal *out) {
+  char text[DECIMAL_TEXT_SIZE];
+  snprintf(text, sizeof(text), "%.15g", value);
+  return decimal_from_string(text, out);
+}
+
+double decimal_to_double(s21_decimal value) {
+  char text[DECIMAL_TEXT_SIZE];
+  decimal_to_string(value, text);
+  return strtod(text, NULL);
+}
+
+int decimal_power(s21_decimal base, s21_decimal exponent,
+                  s21_decimal *result) {
+  s21_decimal whole;
+  s21_decimal power = {{1, 0, 0, 0}};
+  int n = 0;
+  s21_truncate(exponent, &whole);
+  int flag = s21_is_equal(whole, exponent) &&
+                     s21_from_decimal_to_int(whole, &n) == CONVERTATION_OK
+                 ? OK
+                 : CALCULATION_ERROR;
+  unsigned int e = n < 0 ? 0u - n : (unsigned int)n;
+  while (flag == OK && e > 0) {
+    if (e & 1) flag = checked(s21_mul(power, base, &power));
+    e >>= 1;
+    if (flag == OK && e > 0) flag = checked(s21_mul(base, base, &base));
+  }
+  if (flag == OK && n < 0)
+    flag = checked(s21_div((s21_decimal){{1, 0, 0, 0}}, power, &power));
+  if (flag == OK) *result = power;
+  return flag;
+}
+
+/// @brief Бинарная операция над десятичными числами
+static int decimal_operation(opcode op, s21_decimal a, s21_decimal b,
+                             s21_decimal *result) {
+  int flag = CALCULATION_ERROR;
+  switch (op) {
+    case OP_ADD:
+      flag = checked(s21_add(a, b, result));
+      break;
+    case OP_SUB:
+      flag = checked(s21_sub(a, b, result));
+      break;
+    case OP_MUL:
+      flag = checked(s21_mul(a, b, result));
+      break;
+    case OP_DIV:
+      flag = checked(s21_div(a, b, result));
+      break;
+    case OP_MOD:
+      flag = decimal_mod(a, b, result);
+      break;
+    case OP_POW:
+      flag = decimal_power(a, b, result);
+      break;
+    default:
+      break;
+  }
+  return flag;
+}
+
+int evaluate_decimal(const decimal_program *prog, s21_decimal x,
+                     s21_decimal *result) {
+  s21_decimal stack[PROGRAM_STACK_SIZE];
+  int size = 0;
+  int flag = OK;
+  const instruction *code = prog->prog.code;
+  for (int i = 0; i < prog->prog.size && flag == OK; i++) {
+    opcode op = code[i].op;
+    if (op == OP_NUM) {
+      stack[size++] = prog->constants[i];
+    } else if (op == OP_X) {
+      stack[size++] = x;
+    } else if (op == OP_NEG_X) {
+      s21_negate(x, &stack[size++]);
+    } else if (operation_arity(op) == 2) {
+      size--;
+      flag = decimal_operation(op, stack[size - 1], stack[size],
+                               &stack[size - 1]);
+    } else {
+      // функции и sqrt дают бесконечные дроби
+      flag = CALCULATION_ERROR;
+    }
+  }
+  if (flag == OK) *result = stack[0];
+  return flag;
+}
+
+void free_decimal_program(decimal_program *prog) {
+  free_program(&prog->prog);
+  free(prog->constants);
+  prog->constants = NULL;
+}
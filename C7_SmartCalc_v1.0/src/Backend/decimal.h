@@ -0,0 +1,75 @@
+#ifndef DECIMAL_H
+#define DECIMAL_H
+
+#include "../../../C5_s21_decimal/src/s21_decimal.h"
+#include "smartCalc.h"
+
+#define DECIMAL_MAX_SCALE 28
+#define DECIMAL_TEXT_SIZE 32
+
+/// @brief Выражение для точного вычисления в 96-битных десятичных числах
+/// s21_decimal: инструкции без оптимизации и числа, прочитанные заново из
+/// своей десятичной записи
+typedef struct {
+  program prog;
+  s21_decimal *constants;  // значение OP_NUM по номеру инструкции
+} decimal_program;
+
+/// @brief Читает десятичное число: знак, цифры с точкой и порядок "e-3".
+/// Цифры дробной части, которые не помещаются в 96 бит или дальше 28 знака
+/// после точки, округляются
+/// @param text Строка
+/// @param out Число
+/// @return Код ошибки, если строка не число или целая часть не помещается
+int decimal_from_string(const char *text, s21_decimal *out);
+
+/// @brief Записывает число без лишних нулей дробной части
+/// @param value Число
+/// @param text Строка не короче DECIMAL_TEXT_SIZE
+void decimal_to_string(s21_decimal value, char *text);
+
+/// @brief Переводит double через запись с 15 значащими цифрами: число,
+/// введенное десятичной дробью, переводится точно, без хвоста двоичной дроби
+/// @param value Число
+/// @param out Десятичное число
+/// @return Код ошибки для NAN, бесконечности и слишком больших чисел
+int decimal_from_double(double value, s21_decimal *out);
+
+/// @brief Ближайший к десятичному числу double
+/// @param value Число
+/// @return double
+double decimal_to_double(s21_decimal value);
+
+/// @brief Целая степень возведением в квадрат, отрицательная - через деление
+/// @param base Основание
+/// @param exponent Показатель, должен быть целым
+/// @param result Степень
+/// @return Код ошибки для дробного показателя и переполнения
+int decimal_power(s21_decimal base, s21_decimal exponent,
+                  s21_decimal *result);
+
+/// @brief Компилирует строку для точного вычисления; константы, которые не
+/// помещаются в s21_decimal, дают ошибку
+/// @param input Входная строка
+/// @param table Таблица имен или NULL
+/// @param out Выражение, освобождается через free_decimal_program
+/// @return Код ошибки, при ошибке out пуст
+int compile_decimal(const char *input, const symbol_table *table,
+                    decimal_program *out);
+
+/// @brief Вычисляет выражение через s21_add, s21_sub, s21_mul и s21_div.
+/// mod считается как у fmod, ^ - только в целой степени; функции точно не
+/// считаются и дают ошибку
+/// @param prog Выражение
+/// @param x Значение переменной х
+/// @param result Результат вычисления
+/// @return Код ошибки: переполнение, деление на ноль, функция или дробная
+/// степень
+int evaluate_decimal(const decimal_program *prog, s21_decimal x,
+                     s21_decimal *result);
+
+/// @brief Освобождает выражение для десятичных чисел
+/// @param prog Выражение
+void free_decimal_program(decimal_program *prog);
+
+#endif  // DECIMAL_H
@@ -0,0 +1,84 @@
+#include "smartCalc.h"
+
+/// @brief Точки одного столбца: индексы первой, наименьшей, наибольшей и
+/// последней, или -1, если столбец пуст
+typedef struct {
+  int first, low, high, last;
+} bucket;
+
+static int append_point(samples *out, double x, double y) {
+  int flag = OK;
+  if (out->size == out->capacity) {
+    int capacity = out->capacity ? out->capacity * 2 : 256;
+    double *xs = realloc(out->x, sizeof(double) * capacity);
+    if (xs != NULL) out->x = xs;
+    double *ys = realloc(out->y, sizeof(double) * capacity);
+    if (ys != NULL) out->y = ys;
+    if (xs == NULL || ys == NULL)
+      flag = CALCULATION_ERROR;
+    else
+      out->capacity = capacity;
+  }
+  if (flag == OK) {
+    out->x[out->size] = x;
+    out->y[out->size++] = y;
+  }
+  return flag;
+}
+
+/// @brief Выводит точки столбца в исходном порядке без повторов
+static int flush(bucket *b, const double *x, const double *y, samples *out) {
+  int flag = OK;
+  if (b->first >= 0) {
+    int order[4] = {b->first, b->low, b->high, b->last};
+    // четыре индекса сортируются вставками
+    for (int i = 1; i < 4; i++)
+      for (int j = i; j > 0 && order[j - 1] > order[j]; j--) {
+        int tmp = order[j];
+        order[j] = order[j - 1];
+        order[j - 1] = tmp;
+      }
+    for (int i = 0; i < 4 && flag == OK; i++)
+      if (i == 0 || order[i] != order[i - 1])
+        flag = append_point(out, x[order[i]], y[order[i]]);
+  }
+  b->first = b->low = b->high = b->last = -1;
+  return flag;
+}
+
+int decimate(const double *x, const double *y, int n, int buckets,
+             samples *out) {
+  out->x = out->y = NULL;
+  out->size = out->capacity = 0;
+  if (n < 1 || buckets < 1) return CALCULATION_ERROR;
+  double left = x[0];
+  double width = x[n - 1] > x[0] ? (x[n - 1] - x[0]) / buckets : 1;
+  bucket b = {-1, -1, -1, -1};
+  int current = -1;
+  int gap = 0;  // последней выведена точка разрыва
+  int flag = OK;
+  for (int i = 0; i < n && flag == OK; i++) {
+    int index = (int)((x[i] - left) / width);
+    if (index >= buckets) index = buckets - 1;
+    if (index != current) {
+      flag = flush(&b, x, y, out);
+      current = index;
+    }
+    if (!isfinite(y[i])) {
+      // разрыв линии сохраняется одной точкой NAN
+      if (flag == OK) flag = flush(&b, x, y, out);
+      if (flag == OK && !gap && out->size > 0)
+        flag = append_point(out, x[i], NAN);
+      gap = 1;
+    } else {
+      if (b.first < 0) b.first = b.low = b.high = i;
+      if (y[i] < y[b.low]) b.low = i;
+      if (y[i] > y[b.high]) b.high = i;
+      b.last = i;
+      gap = 0;
+    }
+  }
+  if (flag == OK) flag = flush(&b, x, y, out);
+  if (flag != OK) free_samples(out);
+  return flag;
+}
@@ -0,0 +1,335 @@
+#include "decimal.h"
+
+// даты - номера дней от 1970-01-01, перевод по алгоритму Ховарда Хиннанта
+
+int date_from_civil(int year, int month, int day) {
+  year -= month <= 2;
+  int era = (year >= 0 ? year : year - 399) / 400;
+  int year_of_era = year - era * 400;
+  int day_of_year =
+      (153 * (month > 2 ? month - 3 : month + 9) + 2) / 5 + day - 1;
+  int day_of_era = year_of_era * 365 + year_of_era / 4 - year_of_era / 100 +
+                   day_of_year;
+  return era * 146097 + day_of_era - 719468;
+}
+
+void civil_from_date(int date, int *year, int *month, int *day) {
+  date += 719468;
+  int era = (date >= 0 ? date : date - 146096) / 146097;
+  int day_of_era = date - era * 146097;
+  int year_of_era = (day_of_era - day_of_era / 1460 + day_of_era / 36524 -
+                     day_of_era / 146096) /
+                    365;
+  int day_of_year =
+      day_of_era - (365 * year_of_era + year_of_era / 4 - year_of_era / 100);
+  int shifted_month = (5 * day_of_year + 2) / 153;
+  *day = day_of_year - (153 * shifted_month + 2) / 5 + 1;
+  *month = shifted_month < 10 ? shifted_month + 3 : shifted_month - 9;
+  *year = year_of_era + era * 400 + (*month <= 2);
+}
+
+static int is_leap(int year) {
+  return (year % 4 == 0 && year % 100 != 0) || year % 400 == 0;
+}
+
+static int days_in_month(int year, int month) {
+  static const int days[] = {31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31};
+  return month == 2 && is_leap(year) ? 29 : days[month - 1];
+}
+
+int add_months(int date, int months) {
+  int year, month, day;
+  civil_from_date(date, &year, &month, &day);
+  int index = year * 12 + month - 1 + months;
+  year = index / 12;
+  month = index % 12 + 1;
+  // 31 января + месяц = 28 или 29 февраля, как у QDate::addMonths
+  if (day > days_in_month(year, month)) day = days_in_month(year, month);
+  return date_from_civil(year, month, day);
+}
+
+int deposit_end_date(int start, int term, int term_type) {
+  int result = start + term;
+  if (term_type == DEPOSIT_TERM_MONTHS)
+    result = add_months(start, term);
+  else if (term_type == DEPOSIT_TERM_YEARS)
+    result = add_months(start, 12 * term);
+  return result;
+}
+
+/// @brief Следующая дата пополнения или частичного снятия; разовое остается на
+/// месте и больше не наступает
+static int next_operation(int date, int period) {
+  static const int months[] = {0, 1, 2, 3, 6, 12};
+  return period > 0 && period < 6 ? add_months(date, months[period]) : date;
+}
+
+static int next_payment(int date, int period, int end) {
+  int result = end;  // выплата в конце срока
+  if (period == DEPOSIT_DAILY)
+    result = date + 1;
+  else if (period == 1)
+    result = date + 7;
+  else if (period == 2)
+    result = add_months(date, 1);
+  else if (period == 3)
+    result = add_months(date, 3);
+  else if (period == 4)
+    result = add_months(date, 6);
+  else if (period == 5)
+    result = add_months(date, 12);
+  return result;
+}
+
+/// @brief Ближайшая из дат, еще не прошедших к дню date
+static int earliest(int current, int candidate, int date) {
+  return candidate >= date && candidate < current ? candidate : current;
+}
+
+int deposit_calculate(const deposit_params *p, deposit_result *r) {
+  if (!(p->sum > 0) || p->term <= 0 || !(p->rate > 0))
+    return CALCULATION_ERROR;
+  int end = deposit_end_date(p->start, p->term, p->term_type);
+  double rate = p->rate / 100;
+  double tax_free = DEPOSIT_TAX_FREE * p->key_rate / 100;
+  double sum = p->sum;
+  double period = 0;  // начислено с последней выплаты
+  double year = 0;    // выплачено в текущем году, облагается налогом
+  double total = 0;
+  double tax = 0;
+
+  int replenishment = p->replenishment_date;
+  if (p->replenishment != 0 && replenishment == p->start)
+    replenishment = next_operation(replenishment, p->replenishment_period);
+  int withdrawal = p->withdrawal_date;
+  if (p->withdrawal != 0 && withdrawal == p->start)
+    withdrawal = next_operation(withdrawal, p->withdrawal_period);
+  int payment = next_payment(p->start, p->payment_period, end);
+  int y, m, d;
+  civil_from_date(p->start + 1, &y, &m, &d);
+  int new_year = date_from_civil(y, 12, 31);
+  r->finish = end;
+
+  for (int date = p->start + 1; date <= end && sum != 0;) {
+    civil_from_date(date, &y, &m, &d);
+    double daily_rate = rate / (is_leap(y) ? 366 : 365);
+    // события, кроме выплат: после них меняется сумма или налог
+    int other = end;
+    if (p->replenishment != 0) other = earliest(other, replenishment, date);
+    if (p->withdrawal != 0) other = earliest(other, withdrawal, date);
+    if (p->taxed) other = earliest(other, new_year, date);
+    // с нового года меняется число дней в году
+    int next = earliest(earliest(other, payment, date),
+                        date_from_civil(y + 1, 1, 1), date);
+
+    if (next > date) {
+      // дни без событий: проценты только начисляются
+      double interest = (next - date) * (sum * daily_rate);
+      period += interest;
+      total += interest;
+      date = next;
+      continue;
+    }
+    if (p->payment_period == DEPOSIT_DAILY && date == payment &&
+        date != other) {
+      // ежедневные выплаты до следующего события считаются сразу
+      int days = earliest(other, date_from_civil(y + 1, 1, 1), date) - date;
+      if (p->capitalization) {
+        sum += period;
+        year += period;
+        double interest = sum * (pow(1 + daily_rate, days) - 1);
+        sum += interest;
+        year += interest;
+        total += interest;
+      } else {
+        double interest = days * (sum * daily_rate);
+        year += period + interest;
+        total += interest;
+      }
+      period = 0;
+      date += days;
+      payment = date;
+      continue;
+    }
+
+    if (p->replenishment != 0 && date == replenishment) {
+      sum += p->replenishment;
+      replenishment = next_operation(replenishment, p->replenishment_period);
+    }
+    if (p->withdrawal != 0 && date == withdrawal) {
+      sum -= p->withdrawal;
+      withdrawal = next_operation(withdrawal, p->withdrawal_period);
+      if (sum <= 0) {
+        // вклад закрыт досрочно
+        sum = 0;
+        r->finish = date;
+        break;
+      }
+    }
+    if (p->capitalization && date == payment && date != end) {
+      sum += period;
+      year += period;
+      period = 0;
+    }
+    double interest = sum * daily_rate;
+    period += interest;
+    total += interest;
+    if (date == payment || date == end) {
+      if (p->capitalization) sum += period;
+      year += period;
+      period = 0;
+      payment = next_payment(date, p->payment_period, end);
+    }
+    if (p->taxed && (date == new_year || date == end)) {
+      if (year > tax_free) tax += (year - tax_free) * DEPOSIT_TAX_RATE;
+      year = 0;
+      new_year = add_months(new_year, 12);
+    }
+    date++;
+  }
+
+  // капитализированные проценты уже в сумме вклада
+  if (sum != 0) sum += (p->capitalization ? 0 : total) - tax;
+  r->interest = total;
+  r->tax = tax;
+  r->sum = sum;
+  return OK;
+}
+
+/// @brief Неотрицательное целое как десятичное число
+static s21_decimal whole(int n) { return (s21_decimal){{n, 0, 0, 0}}; }
+
+int deposit_calculate_decimal(const deposit_params *p, deposit_result *r) {
+  if (!(p->sum > 0) || p->term <= 0 || !(p->rate > 0))
+    return CALCULATION_ERROR;
+  int end = deposit_end_date(p->start, p->term, p->term_type);
+  s21_decimal zero = whole(0), one = whole(1);
+  s21_decimal rate, tax_free, tax_rate, key_rate, sum, replenishment,
+      withdrawal;
+  int error = decimal_from_double(p->rate, &rate);
+  error |= s21_div(rate, whole(100), &rate);
+  error |= decimal_from_double(DEPOSIT_TAX_FREE, &tax_free);
+  error |= decimal_from_double(p->key_rate, &key_rate);
+  error |= s21_mul(tax_free, key_rate, &tax_free);
+  error |= s21_div(tax_free, whole(100), &tax_free);
+  error |= decimal_from_double(DEPOSIT_TAX_RATE, &tax_rate);
+  error |= decimal_from_double(p->sum, &sum);
+  error |= decimal_from_double(p->replenishment, &replenishment);
+  error |= decimal_from_double(p->withdrawal, &withdrawal);
+  s21_decimal period = zero;  // начислено с последней выплаты
+  s21_decimal year = zero;    // выплачено в текущем году, облагается налогом
+  s21_decimal total = zero;
+  s21_decimal tax = zero;
+
+  int replenishment_date = p->replenishment_date;
+  if (p->replenishment != 0 && replenishment_date == p->start)
+    replenishment_date =
+        next_operation(replenishment_date, p->replenishment_period);
+  int withdrawal_date = p->withdrawal_date;
+  if (p->withdrawal != 0 && withdrawal_date == p->start)
+    withdrawal_date = next_operation(withdrawal_date, p->withdrawal_period);
+  int payment = next_payment(p->start, p->payment_period, end);
+  int y, m, d;
+  civil_from_date(p->start + 1, &y, &m, &d);
+  int new_year = date_from_civil(y, 12, 31);
+  r->finish = end;
+
+  // шаги те же, что в deposit_calculate
+  for (int date = p->start + 1;
+       date <= end && !error && s21_is_not_equal(sum, zero);) {
+    civil_from_date(date, &y, &m, &d);
+    s21_decimal daily_rate, interest;
+    error |= s21_div(rate, whole(is_leap(y) ? 366 : 365), &daily_rate);
+    int other = end;
+    if (p->replenishment != 0)
+      other = earliest(other, replenishment_date, date);
+    if (p->withdrawal != 0) other = earliest(other, withdrawal_date, date);
+    if (p->taxed) other = earliest(other, new_year, date);
+    int next = earliest(earliest(other, payment, date),
+                        date_from_civil(y + 1, 1, 1), date);
+
+    if (next > date) {
+      error |= s21_mul(sum, daily_rate, &interest);
+      error |= s21_mul(whole(next - date), interest, &interest);
+      error |= s21_add(period, interest, &period);
+      error |= s21_add(total, interest, &total);
+      date = next;
+      continue;
+    }
+    if (p->payment_period == DEPOSIT_DAILY && date == payment &&
+        date != other) {
+      int days = earliest(other, date_from_civil(y + 1, 1, 1), date) - date;
+      if (p->capitalization) {
+        s21_decimal growth;
+        error |= s21_add(sum, period, &sum);
+        error |= s21_add(year, period, &year);
+        error |= s21_add(one, daily_rate, &growth);
+        error |= decimal_power(growth, whole(days), &growth);
+        error |= s21_sub(growth, one, &growth);
+        error |= s21_mul(sum, growth, &interest);
+        error |= s21_add(sum, interest, &sum);
+        error |= s21_add(year, interest, &year);
+        error |= s21_add(total, interest, &total);
+      } else {
+        error |= s21_mul(sum, daily_rate, &interest);
+        error |= s21_mul(whole(days), interest, &interest);
+        error |= s21_add(year, period, &year);
+        error |= s21_add(year, interest, &year);
+        error |= s21_add(total, interest, &total);
+      }
+      period = zero;
+      date += days;
+      payment = date;
+      continue;
+    }
+
+    if (p->replenishment != 0 && date == replenishment_date) {
+      error |= s21_add(sum, replenishment, &sum);
+      replenishment_date =
+          next_operation(replenishment_date, p->replenishment_period);
+    }
+    if (p->withdrawal != 0 && date == withdrawal_date) {
+      error |= s21_sub(sum, withdrawal, &sum);
+      withdrawal_date = next_operation(withdrawal_date, p->withdrawal_period);
+      if (s21_is_less_or_equal(sum, zero)) {
+        sum = zero;
+        r->finish = date;
+        break;
+      }
+    }
+    if (p->capitalization && date == payment && date != end) {
+      error |= s21_add(sum, period, &sum);
+      error |= s21_add(year, period, &year);
+      period = zero;
+    }
+    error |= s21_mul(sum, daily_rate, &interest);
+    error |= s21_add(period, interest, &period);
+    error |= s21_add(total, interest, &total);
+    if (date == payment || date == end) {
+      if (p->capitalization) error |= s21_add(sum, period, &sum);
+      error |= s21_add(year, period, &year);
+      period = zero;
+      payment = next_payment(date, p->payment_period, end);
+    }
+    if (p->taxed && (date == new_year || date == end)) {
+      if (s21_is_greater(year, tax_free)) {
+        s21_decimal taxed;
+        error |= s21_sub(year, tax_free, &taxed);
+        error |= s21_mul(taxed, tax_rate, &taxed);
+        error |= s21_add(tax, taxed, &tax);
+      }
+      year = zero;
+      new_year = add_months(new_year, 12);
+    }
+    date++;
+  }
+
+  if (s21_is_not_equal(sum, zero)) {
+    if (!p->capitalization) error |= s21_add(sum, total, &sum);
+    error |= s21_sub(sum, tax, &sum);
+  }
+  r->interest = decimal_to_double(total);
+  r->tax = decimal_to_double(tax);
+  r->sum = decimal_to_double(sum);
+  return error ? CALCULATION_ERROR : OK;
+}
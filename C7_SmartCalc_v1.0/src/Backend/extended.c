@@ -0,0 +1,143 @@
+#include "smartCalc.h"
+
+#define PI_LONG 3.141592653589793238462643383279502884L
+
+/// @brief Кратчайшая десятичная запись, которая читается обратно в то же
+/// число
+static void shortest_number(double value, char *text) {
+  // 17 значащих цифр читаются обратно в то же double всегда
+  for (int digits = 1; digits <= 17; digits++) {
+    snprintf(text, NUMBER_TEXT_SIZE, "%.*g", digits, value);
+    if (strtod(text, NULL) == value) break;
+  }
+}
+
+void literal_text(const token *literal, double value, char *text) {
+  if (literal->text != NULL) {
+    memcpy(text, literal->text, literal->length);
+    text[literal->length] = '\0';
+  } else {
+    shortest_number(value, text);
+  }
+}
+
+/// @brief Константа в точности long double: pi берется точным, числа
+/// читаются из своей записи
+static long double long_constant(const token *literal, double value) {
+  char text[NUMBER_TEXT_SIZE];
+  literal_text(literal, value, text);
+  const char *digits = text + (*text == '-' || *text == '+');
+  long double result = 0;
+  if (!strcmp(digits, "pi"))
+    result = *text == '-' ? -PI_LONG : PI_LONG;
+  else
+    result = strtold(text, NULL);
+  return result;
+}
+
+int compile_long(const char *input, const symbol_table *table,
+                 long_program *out) {
+  token *literals = NULL;
+  out->constants = NULL;
+  int flag = compile_plain(input, table, &out->prog, &literals);
+  if (flag == OK) {
+    out->constants = malloc(sizeof(long double) * out->prog.size);
+    if (out->constants == NULL) {
+      free_program(&out->prog);
+      flag = CALCULATION_ERROR;
+    }
+  }
+  for (int i = 0; flag == OK && i < out->prog.size; i++)
+    if (out->prog.code[i].op == OP_NUM)
+      out->constants[i] =
+          long_constant(&literals[i], out->prog.code[i].value);
+  free(literals);
+  return flag;
+}
+
+long double evaluate_long(const long_program *prog, long double x) {
+  long double stack[PROGRAM_STACK_SIZE];
+  long double slots[PROGRAM_STACK_SIZE];
+  int top = 0;
+  const instruction *code = prog->prog.code;
+  for (int i = 0; i < prog->prog.size; i++) {
+    switch (code[i].op) {
+      case OP_NUM:
+        stack[top++] = prog->constants[i];
+        break;
+      case OP_X:
+        stack[top++] = x;
+        break;
+      case OP_NEG_X:
+        stack[top++] = -x;
+        break;
+      case OP_ADD:
+        top--;
+        stack[top - 1] += stack[top];
+        break;
+      case OP_SUB:
+        top--;
+        stack[top - 1] -= stack[top];
+        break;
+      case OP_MUL:
+        top--;
+        stack[top - 1] *= stack[top];
+        break;
+      case OP_DIV:
+        top--;
+        stack[top - 1] /= stack[top];
+        break;
+      case OP_POW:
+        top--;
+        stack[top - 1] = powl(stack[top - 1], stack[top]);
+        break;
+      case OP_MOD:
+        top--;
+        stack[top - 1] = fmodl(stack[top - 1], stack[top]);
+        break;
+      case OP_SIN:
+        stack[top - 1] = sinl(stack[top - 1]);
+        break;
+      case OP_COS:
+        stack[top - 1] = cosl(stack[top - 1]);
+        break;
+      case OP_TAN:
+        stack[top - 1] = tanl(stack[top - 1]);
+        break;
+      case OP_ASIN:
+        stack[top - 1] = asinl(stack[top - 1]);
+        break;
+      case OP_ACOS:
+        stack[top - 1] = acosl(stack[top - 1]);
+        break;
+      case OP_ATAN:
+        stack[top - 1] = atanl(stack[top - 1]);
+        break;
+      case OP_SQRT:
+        stack[top - 1] = sqrtl(stack[top - 1]);
+        break;
+      case OP_LN:
+        stack[top - 1] = logl(stack[top - 1]);
+        break;
+      case OP_LOG:
+        stack[top - 1] = log10l(stack[top - 1]);
+        break;
+      case OP_SQUARE:
+        stack[top - 1] *= stack[top - 1];
+        break;
+      case OP_STORE:
+        slots[code[i].slot] = stack[top - 1];
+        break;
+      case OP_LOAD:
+        stack[top++] = slots[code[i].slot];
+        break;
+    }
+  }
+  return top > 0 ? stack[0] : 0;
+}
+
+void free_long_program(long_program *prog) {
+  free_program(&prog->prog);
+  free(prog->constants);
+  prog->constants = NULL;
+}
@@ -0,0 +1,255 @@
+#include "smartCalc.h"
+
+// пустой интервал: выражение не определено ни в одной точке
+static const interval EMPTY = {NAN, NAN};
+static const interval WHOLE = {-INFINITY, INFINITY};
+
+static int is_empty(interval a) { return isnan(a.low) || isnan(a.high); }
+
+static interval make(double a, double b) {
+  interval result = {fmin(a, b), fmax(a, b)};
+  // inf - inf и подобное дают NAN, хотя значения выражения существуют
+  if (isnan(a) || isnan(b)) result = WHOLE;
+  return result;
+}
+
+/// @brief Наименьший интервал, содержащий четыре значения
+static interval hull4(double a, double b, double c, double d) {
+  interval result = {fmin(fmin(a, b), fmin(c, d)),
+                     fmax(fmax(a, b), fmax(c, d))};
+  if (isnan(a) || isnan(b) || isnan(c) || isnan(d)) result = WHOLE;
+  return result;
+}
+
+static interval multiply(interval a, interval b) {
+  return hull4(a.low * b.low, a.low * b.high, a.high * b.low,
+               a.high * b.high);
+}
+
+static interval divide(interval a, interval b) {
+  interval result = WHOLE;
+  // через ноль в знаменателе функция уходит в бесконечность
+  if (b.low > 0 || b.high < 0)
+    result = hull4(a.low / b.low, a.low / b.high, a.high / b.low,
+                   a.high / b.high);
+  return result;
+}
+
+static interval square(interval a) {
+  double low = a.low * a.low, high = a.high * a.high;
+  interval result = make(low, high);
+  if (a.low <= 0 && a.high >= 0) result.low = 0;
+  return result;
+}
+
+static interval power(interval a, interval b) {
+  interval result = WHOLE;
+  if (b.low == b.high && b.low == floor(b.low) && fabs(b.low) < 1e9) {
+    // целая степень: четная не монотонна через ноль, отрицательная
+    // уходит в бесконечность в нуле
+    double n = b.low;
+    int even = fmod(n, 2) == 0;
+    int crosses = a.low <= 0 && a.high >= 0;
+    if (n < 0 && crosses) {
+      result = WHOLE;
+    } else if (even) {
+      result = make(pow(a.low, n), pow(a.high, n));
+      if (crosses && n > 0) result.low = 0;
+    } else {
+      result = make(pow(a.low, n), pow(a.high, n));
+    }
+  } else if (a.low > 0) {
+    // при положительном основании pow монотонна по каждому аргументу
+    result = hull4(pow(a.low, b.low), pow(a.low, b.high), pow(a.high, b.low),
+                   pow(a.high, b.high));
+  }
+  return result;
+}
+
+/// @brief pow(x, 0) и pow(1, y) равны 1 и для NAN в другом аргументе, так
+/// что степень определена везде, где основание 1 или показатель 0
+static int power_is_one(interval a, interval b) {
+  int one = a.low == 1 && a.high == 1;
+  int zero = b.low == 0 && b.high == 0;
+  // пустой аргумент нигде не определен, значение есть только там, где
+  // другой аргумент равен 1 или 0
+  if (is_empty(b) && a.low <= 1 && a.high >= 1) one = 1;
+  if (is_empty(a) && b.low <= 0 && b.high >= 0) zero = 1;
+  return one || zero;
+}
+
+static interval modulo(interval a, interval b) {
+  // |fmod(a, b)| < |b|, а знак совпадает со знаком a
+  double m = fmax(fabs(b.low), fabs(b.high));
+  interval result = {fmax(a.low, -m), fmin(a.high, m)};
+  if (a.low >= 0) result.low = 0;
+  if (a.high <= 0) result.high = 0;
+  return result;
+}
+
+/// @brief Синус на интервале: на концах или в точках pi/2 + pi*k внутри
+static interval sine(interval a) {
+  interval result = {-1, 1};
+  if (a.high - a.low < 2 * M_PI) {
+    result = make(sin(a.low), sin(a.high));
+    // максимум в pi/2 + 2*pi*k, минимум в -pi/2 + 2*pi*k
+    double k = ceil((a.low - M_PI / 2) / (2 * M_PI));
+    if (M_PI / 2 + 2 * M_PI * k <= a.high) result.high = 1;
+    k = ceil((a.low + M_PI / 2) / (2 * M_PI));
+    if (-M_PI / 2 + 2 * M_PI * k <= a.high) result.low = -1;
+  }
+  return result;
+}
+
+static interval tangent(interval a) {
+  interval result = WHOLE;
+  // без полюса pi/2 + pi*k внутри тангенс возрастает
+  if (a.high - a.low < M_PI &&
+      floor((a.low - M_PI / 2) / M_PI) == floor((a.high - M_PI / 2) / M_PI))
+    result = make(tan(a.low), tan(a.high));
+  return result;
+}
+
+/// @brief Возрастающая функция на области [from, to]
+static interval increasing(double (*f)(double), interval a, double from,
+                           double to) {
+  interval result = EMPTY;
+  if (a.high >= from && a.low <= to)
+    result = make(f(fmax(a.low, from)), f(fmin(a.high, to)));
+  return result;
+}
+
+static interval unary(opcode op, interval a) {
+  interval result = EMPTY;
+  switch (op) {
+    case OP_SIN:
+      result = sine(a);
+      break;
+    case OP_COS: {
+      interval shifted = {a.low + M_PI / 2, a.high + M_PI / 2};
+      result = sine(shifted);
+      break;
+    }
+    case OP_TAN:
+      result = tangent(a);
+      break;
+    case OP_ASIN:
+      result = increasing(asin, a, -1, 1);
+      break;
+    case OP_ACOS:
+      // acos(x) = pi/2 - asin(x)
+      result = increasing(asin, a, -1, 1);
+      if (!is_empty(result))
+        result = make(M_PI / 2 - result.low, M_PI / 2 - result.high);
+      break;
+    case OP_ATAN:
+      result = increasing(atan, a, -INFINITY, INFINITY);
+      break;
+    case OP_SQRT:
+      result = increasing(sqrt, a, 0, INFINITY);
+      break;
+    case OP_LN:
+      result = increasing(log, a, 0, INFINITY);
+      break;
+    case OP_LOG:
+      result = increasing(log10, a, 0, INFINITY);
+      break;
+    case OP_SQUARE:
+      result = square(a);
+      break;
+    default:
+      break;
+  }
+  return result;
+}
+
+static interval binary(opcode op, interval a, interval b) {
+  interval result = EMPTY;
+  switch (op) {
+    case OP_ADD:
+      result = make(a.low + b.low, a.high + b.high);
+      break;
+    case OP_SUB:
+      result = make(a.low - b.high, a.high - b.low);
+      break;
+    case OP_MUL:
+      result = multiply(a, b);
+      break;
+    case OP_DIV:
+      result = divide(a, b);
+      break;
+    case OP_POW:
+      result = power(a, b);
+      break;
+    case OP_MOD:
+      result = modulo(a, b);
+      break;
+    default:
+      break;
+  }
+  return result;
+}
+
+interval evaluate_interval(const program *prog, interval x) {
+  interval stack[PROGRAM_STACK_SIZE];
+  interval slots[PROGRAM_STACK_SIZE];
+  int top = 0;
+  for (int i = 0; i < prog->size; i++) {
+    const instruction *ins = &prog->code[i];
+    int arity = operation_arity(ins->op);
+    if (ins->op == OP_NUM) {
+      stack[top++] = make(ins->value, ins->value);
+    } else if (ins->op == OP_X) {
+      stack[top++] = x;
+    } else if (ins->op == OP_NEG_X) {
+      stack[top++] = make(-x.high, -x.low);
+    } else if (ins->op == OP_STORE) {
+      slots[ins->slot] = stack[top - 1];
+    } else if (ins->op == OP_LOAD) {
+      stack[top++] = slots[ins->slot];
+    } else if (arity == 2) {
+      top--;
+      if (ins->op == OP_POW && power_is_one(stack[top - 1], stack[top]))
+        stack[top - 1] = make(1, 1);
+      else if (is_empty(stack[top - 1]) || is_empty(stack[top]))
+        stack[top - 1] = EMPTY;
+      else
+        stack[top - 1] = binary(ins->op, stack[top - 1], stack[top]);
+    } else if (!is_empty(stack[top - 1])) {
+      stack[top - 1] = unary(ins->op, stack[top - 1]);
+    }
+  }
+  return top > 0 ? stack[0] : EMPTY;
+}
+
+int interval_range(const program *prog, double left, double right, int parts,
+                   double *low, double *high) {
+  if (!(right > left) || parts < 1) return CALCULATION_ERROR;
+  interval *pieces = malloc(sizeof(interval) * parts);
+  if (pieces == NULL) return CALCULATION_ERROR;
+  double step = (right - left) / parts;
+  for (int i = 0; i < parts; i++) {
+    interval x = {left + i * step,
+                  i == parts - 1 ? right : left + (i + 1) * step};
+    pieces[i] = evaluate_interval(prog, x);
+  }
+  int flag = CALCULATION_ERROR;
+  *low = INFINITY;
+  *high = -INFINITY;
+  for (int i = 0; i < parts; i++) {
+    // часть с бесконечной оценкой содержит асимптоту; у соседних частей
+    // функция уже очень велика, поэтому они тоже не входят в диапазон
+    int pole = 0;
+    for (int j = i - 1; j <= i + 1; j++)
+      if (j >= 0 && j < parts && !is_empty(pieces[j]) &&
+          (isinf(pieces[j].low) || isinf(pieces[j].high)))
+        pole = 1;
+    if (!pole && !is_empty(pieces[i])) {
+      *low = fmin(*low, pieces[i].low);
+      *high = fmax(*high, pieces[i].high);
+      flag = OK;
+    }
+  }
+  free(pieces);
+  return flag;
+}
@@ -0,0 +1,376 @@
+#define _DEFAULT_SOURCE  // MAP_ANONYMOUS при -std=c11
+
+#include "smartCalc.h"
+
+#if defined(__x86_64__) && !defined(_WIN32)
+#include <stdint.h>
+#include <sys/mman.h>
+
+// регистры общего назначения в кодировке x86-64
+#define RBX 3
+#define RBP 5
+
+// кадр стека: аргументы вызова libm, сохраненные регистры стека выражения и
+// ячейки общих подвыражений, по 16 байт (две дорожки) на значение
+#define FRAME_ARGS 0
+#define FRAME_SPILL 32
+#define FRAME_SLOTS (FRAME_SPILL + 16 * NATIVE_REGISTERS)
+
+/// @brief Буфер, в который собирается машинный код
+typedef struct {
+  unsigned char *code;
+  size_t size;
+  size_t capacity;
+  int error;
+  const double *constants;
+} assembler;
+
+static void put(assembler *a, const void *bytes, size_t n) {
+  if (a->size + n > a->capacity) {
+    size_t capacity = a->capacity ? a->capacity * 2 : 4096;
+    while (capacity < a->size + n) capacity *= 2;
+    unsigned char *code = realloc(a->code, capacity);
+    if (code == NULL) {
+      a->error = CALCULATION_ERROR;
+      return;
+    }
+    a->code = code;
+    a->capacity = capacity;
+  }
+  memcpy(a->code + a->size, bytes, n);
+  a->size += n;
+}
+
+static void byte(assembler *a, unsigned value) {
+  unsigned char b = value;
+  put(a, &b, 1);
+}
+
+static void dword(assembler *a, int32_t value) { put(a, &value, 4); }
+
+/// @brief mov rax, imm64
+static void mov_rax(assembler *a, const void *value) {
+  uint64_t imm = (uintptr_t)value;
+  byte(a, 0x48);
+  byte(a, 0xB8);
+  put(a, &imm, 8);
+}
+
+/// @brief Префикс SSE-инструкции: 0x66 для упакованных (pd), 0xF2 для
+/// скалярных (sd), затем REX для xmm8-xmm15 и r13
+static void sse_prefix(assembler *a, int prefix, int reg, int index, int base) {
+  byte(a, prefix);
+  int rex = 0x40 | (reg >> 3) << 2 | index << 1 | base;
+  if (rex != 0x40) byte(a, rex);
+  byte(a, 0x0F);
+}
+
+/// @brief op xmm(reg), xmm(rm)
+static void sse_reg(assembler *a, int prefix, int op, int reg, int rm) {
+  sse_prefix(a, prefix, reg, 0, rm >> 3);
+  byte(a, op);
+  byte(a, 0xC0 | (reg & 7) << 3 | (rm & 7));
+}
+
+/// @brief op xmm(reg), [rsp + disp]
+static void sse_frame(assembler *a, int prefix, int op, int reg, int disp) {
+  sse_prefix(a, prefix, reg, 0, 0);
+  byte(a, op);
+  byte(a, 0x84 | (reg & 7) << 3);
+  byte(a, 0x24);
+  dword(a, disp);
+}
+
+/// @brief op xmm(reg), [rax]
+static void sse_rax(assembler *a, int prefix, int op, int reg) {
+  sse_prefix(a, prefix, reg, 0, 0);
+  byte(a, op);
+  byte(a, (reg & 7) << 3);
+}
+
+/// @brief op xmm(reg), [base + r13 * 8]: элемент массива x или y
+static void sse_element(assembler *a, int prefix, int op, int reg, int base) {
+  sse_prefix(a, prefix, reg, 1, 0);
+  byte(a, op);
+  byte(a, 0x44 | (reg & 7) << 3);
+  byte(a, 0xE8 | base);
+  byte(a, 0);
+}
+
+static void *library_function(opcode op) {
+  double (*f)(double) = NULL;
+  double (*g)(double, double) = NULL;
+  switch (op) {
+    case OP_POW:
+      g = pow;
+      break;
+    case OP_MOD:
+      g = fmod;
+      break;
+    case OP_SIN:
+      f = sin;
+      break;
+    case OP_COS:
+      f = cos;
+      break;
+    case OP_TAN:
+      f = tan;
+      break;
+    case OP_ASIN:
+      f = asin;
+      break;
+    case OP_ACOS:
+      f = acos;
+      break;
+    case OP_ATAN:
+      f = atan;
+      break;
+    case OP_LN:
+      f = log;
+      break;
+    default:
+      f = log10;
+      break;
+  }
+  return f != NULL ? (void *)(uintptr_t)f : (void *)(uintptr_t)g;
+}
+
+/// @brief Вызов функции libm для каждой дорожки верхних значений стека.
+/// Все xmm-регистры при вызове портятся, поэтому нижние значения стека
+/// сохраняются в кадр и потом загружаются обратно
+static void emit_call(assembler *a, opcode op, int top, int lanes) {
+  int arity = operation_arity(op);
+  int first = top - arity;
+  for (int k = 0; k < arity; k++)
+    sse_frame(a, 0x66, 0x11, 2 + first + k, FRAME_ARGS + 16 * k);
+  for (int e = 0; e < first; e++)
+    sse_frame(a, 0x66, 0x11, 2 + e, FRAME_SPILL + 16 * e);
+  for (int lane = 0; lane < lanes; lane++) {
+    sse_frame(a, 0xF2, 0x10, 0, FRAME_ARGS + 8 * lane);
+    if (arity == 2) sse_frame(a, 0xF2, 0x10, 1, FRAME_ARGS + 16 + 8 * lane);
+    mov_rax(a, library_function(op));
+    byte(a, 0xFF);  // call rax
+    byte(a, 0xD0);
+    sse_frame(a, 0xF2, 0x11, 0, FRAME_ARGS + 8 * lane);
+  }
+  for (int e = 0; e < first; e++)
+    sse_frame(a, 0x66, 0x10, 2 + e, FRAME_SPILL + 16 * e);
+  sse_frame(a, 0x66, 0x10, 2 + first, FRAME_ARGS);
+}
+
+/// @brief Тело цикла для двух значений x (lanes = 2) или одного последнего.
+/// Значение стека выражения с номером k лежит в xmm(2 + k)
+static void emit_body(assembler *a, const program *prog, int lanes) {
+  int load = lanes == 2 ? 0x66 : 0xF2;  // movupd или movsd
+  int top = 0;
+  for (int i = 0; i < prog->size; i++) {
+    const instruction *ins = &prog->code[i];
+    int r = 2 + top;
+    switch (ins->op) {
+      case OP_NUM:
+        mov_rax(a, a->constants + 2 * i);
+        sse_rax(a, 0x66, 0x10, r);
+        top++;
+        break;
+      case OP_X:
+      case OP_NEG_X:
+        sse_element(a, load, 0x10, r, RBX);
+        if (ins->op == OP_NEG_X) {
+          mov_rax(a, a->constants + 2 * prog->size);
+          sse_rax(a, 0x66, 0x57, r);  // xorpd со знаковым битом
+        }
+        top++;
+        break;
+      case OP_ADD:
+        sse_reg(a, 0x66, 0x58, r - 2, r - 1);
+        top--;
+        break;
+      case OP_SUB:
+        sse_reg(a, 0x66, 0x5C, r - 2, r - 1);
+        top--;
+        break;
+      case OP_MUL:
+        sse_reg(a, 0x66, 0x59, r - 2, r - 1);
+        top--;
+        break;
+      case OP_DIV:
+        sse_reg(a, 0x66, 0x5E, r - 2, r - 1);
+        top--;
+        break;
+      case OP_SQRT:
+        sse_reg(a, 0x66, 0x51, r - 1, r - 1);
+        break;
+      case OP_SQUARE:
+        sse_reg(a, 0x66, 0x59, r - 1, r - 1);
+        break;
+      case OP_STORE:
+        sse_frame(a, 0x66, 0x11, r - 1, FRAME_SLOTS + 16 * ins->slot);
+        break;
+      case OP_LOAD:
+        sse_frame(a, 0x66, 0x10, r, FRAME_SLOTS + 16 * ins->slot);
+        top++;
+        break;
+      default:
+        emit_call(a, ins->op, top, lanes);
+        top -= operation_arity(ins->op) - 1;
+        break;
+    }
+  }
+  sse_element(a, load, 0x11, 2, RBP);
+}
+
+static void patch(assembler *a, size_t at, size_t target) {
+  if (a->error == OK) {
+    int32_t rel = (int32_t)(target - (at + 4));
+    memcpy(a->code + at, &rel, 4);
+  }
+}
+
+/// @brief Собирает функцию void f(const double *x, double *y, long n)
+static void emit_function(assembler *a, const program *prog) {
+  int frame = FRAME_SLOTS + 16 * prog->slots + 8;  // rsp кратен 16 в теле
+  static const unsigned char prologue[] = {
+      0x53,              // push rbx
+      0x55,              // push rbp
+      0x41, 0x54,        // push r12
+      0x41, 0x55,        // push r13
+      0x48, 0x89, 0xFB,  // mov rbx, rdi
+      0x48, 0x89, 0xF5,  // mov rbp, rsi
+      0x49, 0x89, 0xD4,  // mov r12, rdx
+      0x45, 0x31, 0xED,  // xor r13d, r13d
+      0x48, 0x81, 0xEC,  // sub rsp, imm32
+  };
+  put(a, prologue, sizeof(prologue));
+  dword(a, frame);
+
+  // пары значений: while (i + 2 <= n)
+  size_t pairs = a->size;
+  static const unsigned char pair_check[] = {
+      0x49, 0x8D, 0x45, 0x02,  // lea rax, [r13 + 2]
+      0x4C, 0x39, 0xE0,        // cmp rax, r12
+      0x0F, 0x8F,              // jg rel32
+  };
+  put(a, pair_check, sizeof(pair_check));
+  size_t to_tail = a->size;
+  dword(a, 0);
+  emit_body(a, prog, 2);
+  static const unsigned char pair_next[] = {
+      0x49, 0x83, 0xC5, 0x02,  // add r13, 2
+      0xE9,                    // jmp rel32
+  };
+  put(a, pair_next, sizeof(pair_next));
+  size_t to_pairs = a->size;
+  dword(a, 0);
+
+  // нечетное последнее значение
+  size_t tail = a->size;
+  static const unsigned char tail_check[] = {
+      0x4D, 0x39, 0xE5,  // cmp r13, r12
+      0x0F, 0x8D,        // jge rel32
+  };
+  put(a, tail_check, sizeof(tail_check));
+  size_t to_done = a->size;
+  dword(a, 0);
+  emit_body(a, prog, 1);
+
+  size_t done = a->size;
+  byte(a, 0x48);  // add rsp, imm32
+  byte(a, 0x81);
+  byte(a, 0xC4);
+  dword(a, frame);
+  static const unsigned char epilogue[] = {
+      0x41, 0x5D,  // pop r13
+      0x41, 0x5C,  // pop r12
+      0x5D,        // pop rbp
+      0x5B,        // pop rbx
+      0xC3,        // ret
+  };
+  put(a, epilogue, sizeof(epilogue));
+
+  patch(a, to_tail, tail);
+  patch(a, to_pairs, pairs);
+  patch(a, to_done, done);
+}
+
+int compile_native(const program *prog, native_program *out) {
+  out->code = NULL;
+  out->size = 0;
+  out->constants = NULL;
+  if (prog->size == 0 || prog->depth > NATIVE_REGISTERS ||
+      prog->slots > PROGRAM_STACK_SIZE)
+    return CALCULATION_ERROR;
+
+  // константы лежат парами, чтобы загружаться сразу в обе дорожки;
+  // последняя пара - маска знака для -x
+  double *constants = malloc(sizeof(double) * 2 * (prog->size + 1));
+  if (constants == NULL) return CALCULATION_ERROR;
+  for (int i = 0; i < prog->size; i++)
+    constants[2 * i] = constants[2 * i + 1] = prog->code[i].value;
+  constants[2 * prog->size] = constants[2 * prog->size + 1] = -0.0;
+
+  assembler a = {NULL, 0, 0, OK, constants};
+  emit_function(&a, prog);
+  void *code = MAP_FAILED;
+  if (a.error == OK)
+    code = mmap(NULL, a.size, PROT_READ | PROT_WRITE,
+                MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  int flag = CALCULATION_ERROR;
+  if (code != MAP_FAILED) {
+    memcpy(code, a.code, a.size);
+    // страница не бывает одновременно записываемой и исполняемой
+    if (mprotect(code, a.size, PROT_READ | PROT_EXEC) == 0) {
+      out->code = code;
+      out->size = a.size;
+      out->constants = constants;
+      flag = OK;
+    } else {
+      munmap(code, a.size);
+    }
+  }
+  free(a.code);
+  if (flag != OK) free(constants);
+  return flag;
+}
+
+void evaluate_native(const native_program *native, const double *x, double *y,
+                     int n) {
+  void (*f)(const double *, double *, long) = NULL;
+  memcpy(&f, &native->code, sizeof(f));
+  f(x, y, n);
+}
+
+void free_native(native_program *native) {
+  if (native->code != NULL) munmap(native->code, native->size);
+  free(native->constants);
+  native->code = NULL;
+  native->size = 0;
+  native->constants = NULL;
+}
+
+#else
+
+// на других архитектурах машинный код не собирается, вызывающий код
+// считает через evaluate_batch
+int compile_native(const program *prog, native_program *out) {
+  (void)prog;
+  out->code = NULL;
+  out->size = 0;
+  out->constants = NULL;
+  return CALCULATION_ERROR;
+}
+
+void evaluate_native(const native_program *native, const double *x, double *y,
+                     int n) {
+  (void)native;
+  (void)x;
+  (void)y;
+  (void)n;
+}
+
+void free_native(native_program *native) {
+  native->code = NULL;
+  native->size = 0;
+  native->constants = NULL;
+}
+
+#endif
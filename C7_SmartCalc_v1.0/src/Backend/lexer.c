@@ -0,0 +1,202 @@
+#include "smartCalc.h"
+
+int resolve_operation(const char *name, size_t len, opcode *op) {
+  // ветвление по длине и первой букве вместо перебора strcmp по всем именам
+  int arity = 0;
+  switch (len) {
+    case 1:
+      arity = 2;
+      switch (name[0]) {
+        case '+':
+          *op = OP_ADD;
+          break;
+        case '-':
+          *op = OP_SUB;
+          break;
+        case '*':
+          *op = OP_MUL;
+          break;
+        case '/':
+          *op = OP_DIV;
+          break;
+        case '^':
+          *op = OP_POW;
+          break;
+        default:
+          arity = 0;
+          break;
+      }
+      break;
+    case 2:
+      if (!memcmp(name, "ln", 2)) {
+        *op = OP_LN;
+        arity = 1;
+      }
+      break;
+    case 3:
+      arity = 1;
+      if (!memcmp(name, "mod", 3)) {
+        *op = OP_MOD;
+        arity = 2;
+      } else if (!memcmp(name, "sin", 3)) {
+        *op = OP_SIN;
+      } else if (!memcmp(name, "cos", 3)) {
+        *op = OP_COS;
+      } else if (!memcmp(name, "tan", 3)) {
+        *op = OP_TAN;
+      } else if (!memcmp(name, "log", 3)) {
+        *op = OP_LOG;
+      } else {
+        arity = 0;
+      }
+      break;
+    case 4:
+      arity = 1;
+      if (name[0] == 'a' && !memcmp(name + 1, "sin", 3)) {
+        *op = OP_ASIN;
+      } else if (name[0] == 'a' && !memcmp(name + 1, "cos", 3)) {
+        *op = OP_ACOS;
+      } else if (name[0] == 'a' && !memcmp(name + 1, "tan", 3)) {
+        *op = OP_ATAN;
+      } else if (!memcmp(name, "sqrt", 4)) {
+        *op = OP_SQRT;
+      } else {
+        arity = 0;
+      }
+      break;
+  }
+  return arity;
+}
+
+int operation_arity(opcode op) {
+  int result = 1;
+  if (op == OP_NUM || op == OP_X || op == OP_NEG_X || op == OP_LOAD ||
+      op == OP_STORE)
+    result = 0;
+  else if (op >= OP_ADD && op <= OP_MOD)
+    result = 2;
+  return result;
+}
+
+int operation_priority(opcode op) {
+  int result = 5;
+  if (op == OP_ADD || op == OP_SUB)
+    result = 1;
+  else if (op == OP_MUL || op == OP_DIV || op == OP_MOD)
+    result = 2;
+  else if (op == OP_POW)
+    result = 3;
+  return result;
+}
+
+int append_token(token_list *tokens, token t) {
+  if (tokens->size == tokens->capacity) {
+    int capacity = tokens->capacity ? tokens->capacity * 2 : 32;
+    token *items = realloc(tokens->items, sizeof(token) * capacity);
+    if (items == NULL) return CALCULATION_ERROR;
+    tokens->items = items;
+    tokens->capacity = capacity;
+  }
+  tokens->items[tokens->size++] = t;
+  return OK;
+}
+
+static int is_letter(char c) { return c >= 'a' && c <= 'z'; }
+
+static int is_digit(char c) { return (c >= '0' && c <= '9') || c == '.'; }
+
+/// @brief Разбор операнда со знаком или без: число, x или pi
+/// @return Длина операнда или 0
+static size_t read_operand(const char *p, token *t) {
+  size_t len = 0;
+  double sign = 1;
+  if (*p == '-' || *p == '+') {
+    sign = *p == '-' ? -1 : 1;
+    len++;
+  }
+  t->type = TOKEN_OPERAND;
+  t->op = OP_NUM;
+  t->value = 0;
+  t->text = p;
+  if (is_digit(p[len])) {
+    char number[NUMBER_SIZE];
+    size_t start = len;
+    while (is_digit(p[len])) len++;
+    if (len - start >= NUMBER_SIZE) return 0;
+    memcpy(number, p + start, len - start);
+    number[len - start] = '\0';
+    t->value = sign * atof(number);
+  } else if (p[len] == 'x' && !is_letter(p[len + 1])) {
+    t->op = sign < 0 ? OP_NEG_X : OP_X;
+    len++;
+  } else if (p[len] == 'p' && p[len + 1] == 'i' && !is_letter(p[len + 2])) {
+    t->value = sign * M_PI;
+    len += 2;
+  } else {
+    len = 0;
+  }
+  t->length = (int)len;
+  return len;
+}
+
+size_t read_token(const char *p, int operand_expected, token *t) {
+  size_t len = 0;
+  int sign = *p == '-' || *p == '+';
+  *t = (token){TOKEN_OPERAND, OP_NUM, 0, NULL, 0};
+  if ((is_digit(*p) || is_letter(*p) || sign) && (operand_expected || !sign))
+    len = read_operand(p, t);
+  if (len == 0) {
+    if (*p == '-' && operand_expected) {
+      t->type = TOKEN_NEGATE;
+      len = 1;
+    } else if (*p == '(' || *p == ')') {
+      t->type = *p == '(' ? TOKEN_LEFT : TOKEN_RIGHT;
+      len = 1;
+    } else if (*p != '+' || !operand_expected) {
+      const char *end = p;
+      if (is_letter(*end))
+        while (is_letter(*end)) end++;
+      else
+        end++;
+      int arity = resolve_operation(p, end - p, &t->op);
+      t->type = arity == 2 ? TOKEN_OPERATOR : TOKEN_FUNCTION;
+      if (arity > 0) len = end - p;
+    }
+  }
+  return len;
+}
+
+int tokenize(const char *input, token_list *tokens) {
+  tokens->items = NULL;
+  tokens->size = tokens->capacity = 0;
+  int flag = OK;
+  const char *p = input;
+  while (*p && flag == OK) {
+    if (*p == '|' || *p == ' ') {
+      p++;
+      continue;
+    }
+    // знак относится к числу, если перед ним нет операнда или ")"
+    token_type last = tokens->size ? tokens->items[tokens->size - 1].type
+                                   : TOKEN_LEFT;
+    int operand_expected = last != TOKEN_OPERAND && last != TOKEN_RIGHT;
+    token t;
+    size_t len = read_token(p, operand_expected, &t);
+    if (len > 0) {
+      p += len;
+      flag = append_token(tokens, t);
+    } else if (*p == '+' && operand_expected) {
+      p++;  // унарный плюс ничего не меняет
+    } else {
+      flag = CALCULATION_ERROR;
+    }
+  }
+  if (flag != OK) free_tokens(tokens);
+  return flag;
+}
+
+void free_tokens(token_list *tokens) {
+  free(tokens->items);
+  tokens->items = NULL;
+  tokens->size = tokens->capacity = 0;
+}
@@ -0,0 +1,252 @@
+#include "smartCalc.h"
+
+#define LIVE_CAPACITY 32
+
+static const token NO_TOKEN = {TOKEN_OPERAND, OP_NUM, 0, NULL, 0};
+
+/// @brief Увеличивает массив вдвое, пока в нем не поместятся need элементов
+/// @return Новый массив или NULL, тогда старый остается на месте
+static void *reserve(void *items, int *capacity, int need, size_t size) {
+  void *result = items;
+  if (need > *capacity) {
+    int grown = *capacity ? *capacity : LIVE_CAPACITY;
+    while (grown < need) grown *= 2;
+    result = realloc(items, size * grown);
+    if (result != NULL) *capacity = grown;
+  }
+  return result;
+}
+
+/// @brief Место для одной лексемы: на стеке может добавиться одно значение и
+/// одна операция, каждая свертка пишет в журнал не больше четырех записей
+static int reserve_lexem(live_expression *e) {
+  int flag = CALCULATION_ERROR;
+  live_lexem *lexems =
+      reserve(e->lexems, &e->capacity, e->size + 1, sizeof(live_lexem));
+  if (lexems != NULL) e->lexems = lexems;
+  double *values = reserve(e->values, &e->values_capacity,
+                           e->values_size + 1, sizeof(double));
+  if (values != NULL) e->values = values;
+  token *stack =
+      reserve(e->stack, &e->stack_capacity, e->stack_size + 1, sizeof(token));
+  if (stack != NULL) e->stack = stack;
+  live_change *log =
+      reserve(e->log, &e->log_capacity, e->log_size + 4 * e->stack_size + 4,
+              sizeof(live_change));
+  if (log != NULL) e->log = log;
+  if (lexems != NULL && values != NULL && stack != NULL && log != NULL)
+    flag = OK;
+  return flag;
+}
+
+static void log_change(live_expression *e, live_change_kind kind, token t,
+                       double value) {
+  e->log[e->log_size++] = (live_change){kind, t, value};
+}
+
+static void push_value(live_expression *e, double value) {
+  e->values[e->values_size++] = value;
+  log_change(e, LIVE_PUSH_VALUE, NO_TOKEN, value);
+}
+
+static double pop_value(live_expression *e) {
+  double value = e->values[--e->values_size];
+  log_change(e, LIVE_POP_VALUE, NO_TOKEN, value);
+  return value;
+}
+
+static void push_token(live_expression *e, token t) {
+  e->stack[e->stack_size++] = t;
+  log_change(e, LIVE_PUSH_TOKEN, t, 0);
+}
+
+static token pop_token(live_expression *e) {
+  token t = e->stack[--e->stack_size];
+  log_change(e, LIVE_POP_TOKEN, t, 0);
+  return t;
+}
+
+/// @brief Возвращает стеки к состоянию до записи журнала mark
+static void undo(live_expression *e, int mark) {
+  while (e->log_size > mark) {
+    const live_change *c = &e->log[--e->log_size];
+    switch (c->kind) {
+      case LIVE_PUSH_VALUE:
+        e->values_size--;
+        break;
+      case LIVE_POP_VALUE:
+        e->values[e->values_size++] = c->value;
+        break;
+      case LIVE_PUSH_TOKEN:
+        e->stack_size--;
+        break;
+      case LIVE_POP_TOKEN:
+        e->stack[e->stack_size++] = c->t;
+        break;
+    }
+  }
+}
+
+static int token_priority(const token *t) {
+  return t->type == TOKEN_NEGATE ? 5 : operation_priority(t->op);
+}
+
+/// @brief Сворачивает верхнюю операцию стека с ее аргументами
+static void reduce(live_expression *e) {
+  token t = pop_token(e);
+  double b = pop_value(e);
+  double result;
+  if (t.type == TOKEN_NEGATE) {
+    // как в compile_expression: -f(x) = f(x) * -1
+    result = evaluate_operation(OP_MUL, b, -1);
+  } else if (t.type == TOKEN_FUNCTION) {
+    result = evaluate_operation(t.op, b, 0);
+  } else {
+    double a = pop_value(e);
+    result = evaluate_operation(t.op, a, b);
+  }
+  push_value(e, result);
+}
+
+/// @brief Шаг сортировочной станции compile_expression, только вместо
+/// записи инструкций операции сразу считаются
+static int apply(live_expression *e, token t, int operand_expected) {
+  int flag = OK;
+  int operand = t.type == TOKEN_OPERAND;
+  int prefix = t.type == TOKEN_FUNCTION || t.type == TOKEN_NEGATE ||
+               t.type == TOKEN_LEFT;
+  // операнд, функция и "(" стоят там, где ждется операнд, бинарная операция
+  // и ")" - после операнда
+  if ((operand || prefix) != operand_expected) {
+    flag = CALCULATION_ERROR;
+  } else if (operand) {
+    double value = t.value;
+    if (t.op == OP_X) value = e->x;
+    if (t.op == OP_NEG_X) value = -e->x;
+    push_value(e, value);
+  } else if (prefix) {
+    push_token(e, t);
+  } else if (t.type == TOKEN_RIGHT) {
+    while (e->stack_size > 0 && e->stack[e->stack_size - 1].type != TOKEN_LEFT)
+      reduce(e);
+    if (e->stack_size > 0)
+      pop_token(e);
+    else
+      flag = CALCULATION_ERROR;
+  } else {
+    const token *top;
+    // ^ правоассоциативна: 2^3^2 = 2^(3^2)
+    while (e->stack_size > 0 &&
+           (top = &e->stack[e->stack_size - 1])->type != TOKEN_LEFT &&
+           !(t.op == OP_POW && top->op == OP_POW &&
+             top->type == TOKEN_OPERATOR) &&
+           token_priority(top) >= operation_priority(t.op))
+      reduce(e);
+    push_token(e, t);
+  }
+  return flag;
+}
+
+void live_init(live_expression *e, double x) {
+  *e = (live_expression){.text = NULL, .error = OK, .x = x};
+}
+
+int live_set(live_expression *e, const char *input) {
+  size_t same = 0;
+  while (same < e->length && e->text[same] == input[same]) same++;
+  // лексема, которая кончается на первом отличии, могла удлиниться: 12 -> 123
+  while (e->size > 0 && e->lexems[e->size - 1].end >= same)
+    undo(e, e->lexems[--e->size].mark);
+  size_t from = e->size > 0 ? e->lexems[e->size - 1].end : 0;
+
+  e->error = OK;
+  size_t p = from;
+  while (input[p] && e->error == OK) {
+    if (input[p] == '|' || input[p] == ' ') {
+      p++;
+      continue;
+    }
+    // знак относится к числу, если перед ним нет операнда или ")"
+    token_type last = e->size ? e->lexems[e->size - 1].type : TOKEN_LEFT;
+    int operand_expected = last != TOKEN_OPERAND && last != TOKEN_RIGHT;
+    token t;
+    size_t len = read_token(input + p, operand_expected, &t);
+    int mark = e->log_size;
+    e->error = reserve_lexem(e);
+    if (e->error == OK && len > 0) {
+      e->error = apply(e, t, operand_expected);
+      if (e->error != OK) undo(e, mark);
+    } else if (e->error == OK && input[p] == '+' && operand_expected) {
+      t.type = last;  // унарный плюс ничего не меняет
+      len = 1;
+    } else {
+      e->error = CALCULATION_ERROR;
+    }
+    if (e->error == OK) {
+      p += len;
+      e->lexems[e->size++] = (live_lexem){p, t.type, mark};
+    }
+  }
+
+  if (p + 1 > e->text_capacity) {
+    size_t capacity = e->text_capacity ? e->text_capacity : LIVE_CAPACITY;
+    while (capacity < p + 1) capacity *= 2;
+    char *text = realloc(e->text, capacity);
+    if (text != NULL) {
+      e->text = text;
+      e->text_capacity = capacity;
+    }
+  }
+  if (p + 1 <= e->text_capacity) {
+    memcpy(e->text + from, input + from, p - from);
+    e->length = p;
+  } else {
+    // без памяти под строку следующий вызов разберет все заново
+    undo(e, 0);
+    e->size = 0;
+    e->length = 0;
+    e->error = CALCULATION_ERROR;
+  }
+  return e->error;
+}
+
+int live_result(const live_expression *e, double *result) {
+  token_type last = e->size ? e->lexems[e->size - 1].type : TOKEN_LEFT;
+  int flag = CALCULATION_ERROR;
+  if (e->error == OK && (last == TOKEN_OPERAND || last == TOKEN_RIGHT)) {
+    // операции на стеке лежат в порядке свертки, левые скобки закрываются
+    double value = e->values[e->values_size - 1];
+    int next = e->values_size - 2;
+    for (int i = e->stack_size - 1; i >= 0; i--) {
+      const token *t = &e->stack[i];
+      if (t->type == TOKEN_NEGATE)
+        value = evaluate_operation(OP_MUL, value, -1);
+      else if (t->type == TOKEN_FUNCTION)
+        value = evaluate_operation(t->op, value, 0);
+      else if (t->type == TOKEN_OPERATOR)
+        value = evaluate_operation(t->op, e->values[next--], value);
+    }
+    *result = value;
+    flag = OK;
+  }
+  return flag;
+}
+
+void live_set_x(live_expression *e, double x) {
+  e->x = x;
+  e->size = 0;
+  e->values_size = 0;
+  e->stack_size = 0;
+  e->log_size = 0;
+  e->length = 0;
+  e->error = OK;
+}
+
+void live_free(live_expression *e) {
+  free(e->text);
+  free(e->lexems);
+  free(e->values);
+  free(e->stack);
+  free(e->log);
+  live_init(e, e->x);
+}
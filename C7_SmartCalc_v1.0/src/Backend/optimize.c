@@ -0,0 +1,233 @@
+#include "smartCalc.h"
+
+/// @brief Узел графа выражения
+typedef struct {
+  opcode op;
+  double value;  // для OP_NUM
+  int a, b;      // индексы аргументов или -1
+  int uses;      // сколько раз узел используется в итоговом выражении
+  int slot;      // ячейка, в которой лежит уже посчитанное значение, или -1
+  int need;      // глубина стека, нужная для вычисления узла
+} dag_node;
+
+typedef struct {
+  dag_node *nodes;
+  int size;
+  int *table;       // открытая адресация: номер узла или -1
+  int table_mask;   // размер таблицы - степень двойки, минус один
+  instruction *code;
+  int code_size;
+  int slots;
+} dag;
+
+/// @brief FNV-1a по операции, аргументам и битам числа
+static unsigned long node_hash(opcode op, double value, int a, int b) {
+  unsigned char key[3 * sizeof(int) + sizeof(double)] = {0};
+  int fields[3] = {op, a, b};
+  memcpy(key, fields, sizeof(fields));
+  if (op == OP_NUM) memcpy(key + sizeof(fields), &value, sizeof(double));
+  unsigned long hash = 14695981039346656037UL;
+  for (size_t i = 0; i < sizeof(key); i++) {
+    hash ^= key[i];
+    hash *= 1099511628211UL;
+  }
+  return hash;
+}
+
+/// @brief Возвращает существующий одинаковый узел или добавляет новый
+static int intern(dag *g, opcode op, double value, int a, int b) {
+  // у коммутативных операций порядок аргументов не важен
+  if ((op == OP_ADD || op == OP_MUL) && a > b) {
+    int tmp = a;
+    a = b;
+    b = tmp;
+  }
+  // таблица заполнена не больше чем наполовину, свободная ячейка найдется
+  int pos = (int)(node_hash(op, value, a, b) & g->table_mask);
+  for (; g->table[pos] >= 0; pos = (pos + 1) & g->table_mask) {
+    dag_node *n = &g->nodes[g->table[pos]];
+    if (n->op == op && n->a == a && n->b == b &&
+        (op != OP_NUM || !memcmp(&n->value, &value, sizeof(double))))
+      return g->table[pos];
+  }
+  g->table[pos] = g->size;
+  // второй аргумент считается поверх первого; у коммутативных операций
+  // первым можно считать более глубокий, как в нумерации Сети-Ульмана
+  int need = 1;
+  if (b >= 0) {
+    int na = g->nodes[a].need, nb = g->nodes[b].need;
+    if (op == OP_ADD || op == OP_MUL)
+      need = na == nb ? na + 1 : (na > nb ? na : nb);
+    else
+      need = na > nb + 1 ? na : nb + 1;
+  } else if (a >= 0) {
+    need = g->nodes[a].need;
+  }
+  g->nodes[g->size] = (dag_node){op, value, a, b, 0, -1, need};
+  return g->size++;
+}
+
+static int is_constant(const dag *g, int node) {
+  return g->nodes[node].op == OP_NUM;
+}
+
+static int build_node(dag *g, opcode op, double value, int a, int b) {
+  int result;
+  if (op == OP_NUM || op == OP_X || op == OP_NEG_X) {
+    result = intern(g, op, value, -1, -1);
+  } else if (operation_arity(op) == 1 && is_constant(g, a)) {
+    double folded = evaluate_operation(op, g->nodes[a].value, 0);
+    result = intern(g, OP_NUM, folded, -1, -1);
+  } else if (operation_arity(op) == 2 && is_constant(g, a) &&
+             is_constant(g, b)) {
+    double folded =
+        evaluate_operation(op, g->nodes[a].value, g->nodes[b].value);
+    result = intern(g, OP_NUM, folded, -1, -1);
+  } else if (op == OP_POW && is_constant(g, b) && g->nodes[b].value == 2) {
+    // x^2 -> x*x без вызова pow
+    result = intern(g, OP_SQUARE, 0, a, -1);
+  } else {
+    result = intern(g, op, value, a, operation_arity(op) == 2 ? b : -1);
+  }
+  return result;
+}
+
+static void count_uses(dag *g, int node) {
+  if (g->nodes[node].uses++ == 0) {
+    if (g->nodes[node].a >= 0) count_uses(g, g->nodes[node].a);
+    if (g->nodes[node].b >= 0) count_uses(g, g->nodes[node].b);
+  }
+}
+
+static void emit(dag *g, int node) {
+  dag_node *n = &g->nodes[node];
+  if (n->slot >= 0) {
+    g->code[g->code_size++] = (instruction){.op = OP_LOAD, .slot = n->slot};
+    return;
+  }
+  if ((n->op == OP_ADD || n->op == OP_MUL) &&
+      g->nodes[n->b].need > g->nodes[n->a].need) {
+    emit(g, n->b);
+    emit(g, n->a);
+  } else {
+    if (n->a >= 0) emit(g, n->a);
+    if (n->b >= 0) emit(g, n->b);
+  }
+  g->code[g->code_size++] = (instruction){.op = n->op, .value = n->value};
+  // общий подграф считается один раз, дальше значение берется из ячейки
+  if (n->uses > 1 && operation_arity(n->op) > 0) {
+    n->slot = g->slots++;
+    g->code[g->code_size++] = (instruction){.op = OP_STORE, .slot = n->slot};
+  }
+}
+
+/// @brief Добавляет программу в граф; ячейки уже оптимизированной программы
+/// заменяются узлами, которые в них сохранены
+/// @param root Узел результата программы
+static int add_program(dag *g, const program *prog, int *root) {
+  int *stack = malloc(sizeof(int) * (prog->depth > 0 ? prog->depth : 1));
+  int *slots = malloc(sizeof(int) * (prog->slots > 0 ? prog->slots : 1));
+  int flag = stack && slots && prog->size > 0 ? OK : CALCULATION_ERROR;
+  int top = 0;
+  for (int i = 0; i < prog->size && flag == OK; i++) {
+    const instruction *ins = &prog->code[i];
+    int arity = operation_arity(ins->op);
+    if (ins->op == OP_STORE) {
+      if (top > 0 && ins->slot < prog->slots)
+        slots[ins->slot] = stack[top - 1];
+      else
+        flag = CALCULATION_ERROR;
+    } else if (ins->op == OP_LOAD) {
+      if (ins->slot < prog->slots && top < prog->depth)
+        stack[top++] = slots[ins->slot];
+      else
+        flag = CALCULATION_ERROR;
+    } else if (top < arity || (arity == 0 && top >= prog->depth)) {
+      flag = CALCULATION_ERROR;
+    } else {
+      int b = arity == 2 ? stack[--top] : -1;
+      int a = arity >= 1 ? stack[--top] : -1;
+      stack[top++] = build_node(g, ins->op, ins->value, a, b);
+    }
+  }
+  if (flag == OK && top == 1)
+    *root = stack[0];
+  else
+    flag = CALCULATION_ERROR;
+  free(slots);
+  free(stack);
+  return flag;
+}
+
+/// @brief Выводит результаты графа по порядку; после программы на стеке
+/// остается count значений
+static int emit_roots(dag *g, const int *roots, int count, program *out) {
+  for (int i = 0; i < count; i++) count_uses(g, roots[i]);
+  for (int i = 0; i < count; i++) emit(g, roots[i]);
+  // глубина стека после перестановок пересчитывается заново
+  int depth = 0, max_depth = 0;
+  for (int i = 0; i < g->code_size; i++) {
+    opcode op = g->code[i].op;
+    int arity = operation_arity(op);
+    if (op != OP_STORE) depth += arity == 0 ? 1 : 1 - arity;
+    if (depth > max_depth) max_depth = depth;
+  }
+  int flag = CALCULATION_ERROR;
+  if (max_depth <= PROGRAM_STACK_SIZE && g->slots <= PROGRAM_STACK_SIZE) {
+    out->code = g->code;
+    out->size = g->code_size;
+    out->depth = max_depth;
+    out->slots = g->slots;
+    g->code = NULL;
+    flag = OK;
+  }
+  return flag;
+}
+
+/// @brief Общий граф для нескольких программ
+static int merge(const program *progs, int count, program *out) {
+  int total = 0;
+  for (int i = 0; i < count; i++) total += progs[i].size;
+  dag g = {NULL, 0, NULL, 0, NULL, 0, 0};
+  g.nodes = malloc(sizeof(dag_node) * (total > 0 ? total : 1));
+  // узлов не больше, чем инструкций; таблица хотя бы вдвое больше
+  int table_size = 2;
+  while (table_size < 2 * total) table_size *= 2;
+  g.table = malloc(sizeof(int) * table_size);
+  g.table_mask = table_size - 1;
+  for (int i = 0; g.table && i < table_size; i++) g.table[i] = -1;
+  // каждая исходная инструкция дает не больше двух: операцию или LOAD и STORE
+  g.code = malloc(sizeof(instruction) * (2 * total + count + 1));
+  int *roots = malloc(sizeof(int) * (count > 0 ? count : 1));
+  int flag = g.nodes && g.table && g.code && roots && count > 0
+                 ? OK
+                 : CALCULATION_ERROR;
+  for (int i = 0; i < count && flag == OK; i++)
+    flag = add_program(&g, &progs[i], &roots[i]);
+  if (flag == OK) flag = emit_roots(&g, roots, count, out);
+  free(roots);
+  free(g.code);
+  free(g.table);
+  free(g.nodes);
+  return flag;
+}
+
+int optimize_program(program *prog) {
+  program result;
+  int flag = OK;
+  for (int i = 0; i < prog->size; i++)
+    if (prog->code[i].op == OP_STORE || prog->code[i].op == OP_LOAD)
+      flag = CALCULATION_ERROR;  // программа уже оптимизирована
+  if (flag == OK) flag = merge(prog, 1, &result);
+  if (flag == OK) {
+    free(prog->code);
+    *prog = result;
+  }
+  return flag;
+}
+
+int merge_programs(const program *progs, int count, program *out) {
+  out->code = NULL;
+  out->size = out->depth = out->slots = 0;
+  return merge(progs, count, out);
+}
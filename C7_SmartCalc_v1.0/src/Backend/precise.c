@@ -0,0 +1,26 @@
+#include "decimal.h"
+
+int evaluate_precise(const char *input, const symbol_table *table,
+                     int precision, double x, char *text) {
+  int flag = CALCULATION_ERROR;
+  if (precision == PRECISION_LONG) {
+    long_program prog;
+    flag = compile_long(input, table, &prog);
+    if (flag == OK) {
+      snprintf(text, PRECISE_TEXT_SIZE, "%.21Lg", evaluate_long(&prog, x));
+      free_long_program(&prog);
+    }
+  } else if (precision == PRECISION_DECIMAL) {
+    // x из поля ввода переводится по своей записи, как числа выражения
+    s21_decimal value, result;
+    decimal_program prog;
+    flag = decimal_from_double(x, &value);
+    if (flag == OK) flag = compile_decimal(input, table, &prog);
+    if (flag == OK) {
+      flag = evaluate_decimal(&prog, value, &result);
+      if (flag == OK) decimal_to_string(result, text);
+      free_decimal_program(&prog);
+    }
+  }
+  return flag;
+}
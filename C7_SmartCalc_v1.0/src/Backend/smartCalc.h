@@ -10,13 +10,299 @@
 #define M_PI (3.14159265358979323846)
 #endif
 
+#define PROGRAM_STACK_SIZE 256
+#define BATCH_SIZE 256
+#define ADAPTIVE_MAX_DEPTH 16
+#define ADAPTIVE_JUMP 32
+#define NATIVE_REGISTERS 14
+#define PROGRAM_CACHE_SIZE 64
+#define DEPOSIT_TERM_DAYS 0
+#define DEPOSIT_TERM_MONTHS 1
+#define DEPOSIT_TERM_YEARS 2
+#define DEPOSIT_DAILY 0
+#define DEPOSIT_TAX_FREE 1e6
+#define DEPOSIT_TAX_RATE 0.13
+#define CREDIT_ANNUITY 0
+#define CREDIT_DIFFERENTIATED 1
+#define SWEEP_CREDIT 0
+#define SWEEP_DEPOSIT 1
+#define SWEEP_BLOCK 64
+#define SWEEP_MAX_THREADS 64
+#define STACK_POOL_BLOCK 256
+#define SYMBOL_MAX_DEPTH 32
+#define SYMBOL_MAX_TOKENS 65536
+#define NUMBER_SIZE 64
+#define NUMBER_TEXT_SIZE (NUMBER_SIZE + 2)
+#define PRECISION_DOUBLE 0
+#define PRECISION_LONG 1
+#define PRECISION_DECIMAL 2
+#define PRECISE_TEXT_SIZE 40
+
 enum Error { OK, CALCULATION_ERROR, EXTRA_BRACKET, BRACKET_MISSING };
 
-/// @brief Структура стека чисел
-typedef struct stack_num {
-  long double data;
-  struct stack_num *next;
-} stack_num;
+/// @brief Коды операций скомпилированного выражения
+typedef enum {
+  OP_NUM,
+  OP_X,
+  OP_NEG_X,
+  OP_ADD,
+  OP_SUB,
+  OP_MUL,
+  OP_DIV,
+  OP_POW,
+  OP_MOD,
+  OP_SIN,
+  OP_COS,
+  OP_TAN,
+  OP_ASIN,
+  OP_ACOS,
+  OP_ATAN,
+  OP_SQRT,
+  OP_LN,
+  OP_LOG,
+  OP_SQUARE,
+  OP_STORE,
+  OP_LOAD
+} opcode;
+
+/// @brief Инструкция: код операции, уже разобранное число для OP_NUM и номер
+/// ячейки для OP_STORE и OP_LOAD
+typedef struct {
+  opcode op;
+  int slot;
+  double value;
+} instruction;
+
+/// @brief Выражение, скомпилированное из обратной польской нотации
+typedef struct {
+  instruction *code;
+  int size;
+  int depth;  // наибольшая глубина стека при вычислении
+  int slots;  // количество ячеек для общих подвыражений
+} program;
+
+/// @brief Выражение для вычисления в long double: инструкции без оптимизации,
+/// чтобы константы не сворачивались в double, и числа, прочитанные заново в
+/// long double
+typedef struct {
+  program prog;
+  long double *constants;  // значение OP_NUM по номеру инструкции
+} long_program;
+
+/// @brief Выражение, собранное в машинный код x86-64
+typedef struct {
+  void *code;  // исполняемые страницы или NULL
+  size_t size;
+  double *constants;
+} native_program;
+
+/// @brief Отрезок значений [low, high]; NAN в границах означает, что
+/// выражение не определено ни в одной точке
+typedef struct {
+  double low;
+  double high;
+} interval;
+
+/// @brief Параметры вклада. Даты - номера дней от 1970-01-01, периоды -
+/// индексы списков в интерфейсе
+typedef struct {
+  double sum;
+  int start;
+  int term;
+  int term_type;       // DEPOSIT_TERM_DAYS, _MONTHS или _YEARS
+  double rate;         // годовая ставка, %
+  int payment_period;  // каждый день, неделю, месяц, квартал, полгода, год,
+                       // в конце срока
+  int capitalization;
+  double replenishment;  // 0 - без пополнений
+  int replenishment_date;
+  int replenishment_period;  // разовое, раз в 1, 2, 3, 6 или 12 месяцев
+  double withdrawal;         // 0 - без снятий
+  int withdrawal_date;
+  int withdrawal_period;
+  int taxed;
+  double key_rate;  // ключевая ставка, %
+} deposit_params;
+
+/// @brief Результат расчета вклада
+typedef struct {
+  double interest;  // начисленные проценты
+  double tax;
+  double sum;  // сумма в конце срока
+  int finish;  // дата окончания, раньше срока при снятии всей суммы
+} deposit_result;
+
+/// @brief График платежей по кредиту: столбцы лежат подряд в одном блоке
+/// памяти, строка i - платеж i + 1
+typedef struct {
+  int size;
+  double *payment;
+  double *principal;  // платеж по основному долгу
+  double *interest;   // платеж по процентам
+  double *balance;    // остаток долга после платежа
+  int *date;          // дни от 1970-01-01
+  double first_payment;
+  double last_payment;
+  double overpayment;
+  double total;
+} credit_schedule;
+
+/// @brief Равномерная сетка из count значений от first до last
+typedef struct {
+  double first;
+  double last;
+  int count;
+} sweep_range;
+
+/// @brief Перебор ставок и сроков. В каждой точке считаются оба вида
+/// платежей кредита или вклад без капитализации и с ней
+typedef struct {
+  int kind;          // SWEEP_CREDIT или SWEEP_DEPOSIT
+  sweep_range rate;  // годовая ставка, %
+  sweep_range term;  // срок в месяцах
+  double sum;
+  int start;               // дата выдачи или открытия
+  deposit_params deposit;  // прочие параметры вклада
+  int threads;             // 0 - по числу процессоров
+} sweep_params;
+
+/// @brief Результат одной точки перебора
+typedef struct {
+  double rate;
+  int term;
+  int type;   // вид платежей кредита или капитализация вклада
+  int error;  // код ошибки расчета
+  credit_schedule credit;  // только итоги, без строк
+  deposit_result deposit;
+} sweep_point;
+
+/// @brief Получает готовые точки по порядку: ставка, срок, вид
+typedef void (*sweep_callback)(const sweep_point *points, int count,
+                               void *context);
+
+/// @brief Имя пользователя: переменная или функция одного аргумента
+typedef struct {
+  char *name;
+  char *parameter;  // NULL у переменной
+  char *body;       // выражение, подставляется при каждой компиляции
+} symbol;
+
+/// @brief Таблица имен пользователя; version растет при каждом изменении,
+/// по ней кэш узнает, что выражения нужно скомпилировать заново
+typedef struct {
+  symbol *items;
+  int size;
+  int capacity;
+  unsigned long version;
+} symbol_table;
+
+/// @brief Запись кэша: скомпилированное выражение или код ошибки
+typedef struct cache_entry {
+  char *key;
+  unsigned long hash;
+  program prog;
+  int error;
+  unsigned long version;  // версия таблицы имен при компиляции
+  struct cache_entry *prev;   // список от недавних к давним
+  struct cache_entry *next;
+  struct cache_entry *chain;  // следующая запись в той же корзине
+} cache_entry;
+
+/// @brief Кэш скомпилированных выражений с вытеснением давно не
+/// использованных (LRU) и статистикой попаданий
+typedef struct {
+  cache_entry **buckets;
+  int bucket_count;
+  cache_entry *head;
+  cache_entry *tail;
+  int size;
+  int capacity;
+  long hits;
+  long misses;
+  const symbol_table *symbols;  // имена пользователя или NULL
+} program_cache;
+
+/// @brief Виды лексем
+typedef enum {
+  TOKEN_OPERAND,   // число, x или pi
+  TOKEN_OPERATOR,  // бинарная операция
+  TOKEN_FUNCTION,
+  TOKEN_NEGATE,  // унарный минус перед скобкой или функцией
+  TOKEN_LEFT,
+  TOKEN_RIGHT
+} token_type;
+
+/// @brief Лексема: вид, код операции (OP_NUM, OP_X, OP_NEG_X для операндов),
+/// уже разобранное число и его запись со знаком во входной строке
+typedef struct {
+  token_type type;
+  opcode op;
+  double value;
+  const char *text;  // начало записи числа или NULL
+  int length;
+} token;
+
+/// @brief Массив лексем, растет по мере разбора
+typedef struct {
+  token *items;
+  int size;
+  int capacity;
+} token_list;
+
+/// @brief Виды записей журнала изменений стеков живого разбора
+typedef enum {
+  LIVE_PUSH_VALUE,
+  LIVE_POP_VALUE,
+  LIVE_PUSH_TOKEN,
+  LIVE_POP_TOKEN
+} live_change_kind;
+
+/// @brief Запись журнала: снятые со стека значение или лексема сохраняются,
+/// чтобы вернуть их при отмене
+typedef struct {
+  live_change_kind kind;
+  token t;
+  double value;
+} live_change;
+
+/// @brief Разобранная лексема входной строки
+typedef struct {
+  size_t end;       // конец лексемы в строке
+  token_type type;  // у унарного плюса - вид предыдущей лексемы
+  int mark;         // начало изменений лексемы в журнале
+} live_lexem;
+
+/// @brief Выражение, которое разбирается и считается по мере ввода. Числа и
+/// операции сворачиваются сразу, на стеках остаются только значения и
+/// операции незакрытых скобок; изменения стеков пишутся в журнал, и удаление
+/// лексемы с конца отменяет только ее изменения
+typedef struct {
+  char *text;  // разобранное начало строки
+  size_t length;
+  size_t text_capacity;
+  live_lexem *lexems;
+  int size;
+  int capacity;
+  double *values;
+  int values_size;
+  int values_capacity;
+  token *stack;  // операции, функции и левые скобки
+  int stack_size;
+  int stack_capacity;
+  live_change *log;
+  int log_size;
+  int log_capacity;
+  int error;  // ошибка в лексеме сразу после разобранного начала
+  double x;
+} live_expression;
+
+/// @brief Точки графика, NAN в y означает разрыв линии
+typedef struct {
+  double *x;
+  double *y;
+  int size;
+  int capacity;
+} samples;
 
 /// @brief Стуктура стека строк
 typedef struct stack_char {
@@ -34,27 +320,9 @@ int check_brackets_result(char *input_str, int *quantity);
 /// @param lexemas массим ликсем
 void to_lexems(char *inpun_str, char **lexems);
 
-/// @brief Создает новый верхний стек чисел
-/// @param head Верхний стек
-/// @param value переменная для создания нового элемента стека
-void creating_top_stack_num(stack_num **head, long double value);
-
-/// @brief Извлечение информации из верхнего стека чисел и его стирание
-/// @param head Верхний стек
-/// @return Значение верхнего стека
-long double use_top_stack_num(stack_num **head);
-
-/// @brief Производит вычисление
-/// @param op Значение оператора
-/// @param dop Значение функции
-/// @param head стек чисел
-/// @return Результат вычисления
-long double calculation(char op, char dop, stack_num **head);
-
-/// @brief Разделяет операторы от функций
-/// @param op Входящее значение
-/// @return Код оператора или функции
-int separation(char op);
+/// @brief Освобождает блоки пула, из которого берутся узлы стека операций
+/// lexems_to_RPN в текущем потоке; стек должен быть пуст
+void free_stack_pool(void);
 
 /// @brief Проверяет, является ли лексема цифрой
 /// @param number Лексема
@@ -65,8 +333,8 @@ int is_number(char *number);
 /// @param str Обратная польская нотация
 /// @param x Значение переменной х
 /// @param flag Контрольный флаг
-/// @return Результат вычисления
-long double answer(char **str, double x, int *flag);
+/// @return Результат вычисления в double
+double answer(char **str, double x, int *flag);
 
 /// @brief Смотрим на значение верхнего стека строк
 /// @param head Верхний стек
@@ -104,4 +372,461 @@ int priority(char *string);
 /// @param RPN Обратная польская нотация
 /// @return Код ошибки
 int lexems_to_RPN(char **lexems, char **tmp_out, char **RPN);
+
+/// @brief Компилирует обратную польскую нотацию в массив инструкций и
+/// оптимизирует его
+/// @param RPN Обратная польская нотация
+/// @param prog Скомпилированное выражение, освобождается через free_program
+/// @return Код ошибки, при ошибке prog пуст
+int compile_RPN(char **RPN, program *prog);
+
+/// @brief Находит операцию по имени без перебора всех имен
+/// @param name Имя операции (не обязательно заканчивается нулем)
+/// @param len Длина имени
+/// @param op Код найденной операции
+/// @return Число аргументов: 2 для операторов, 1 для функций, 0 если имя
+/// неизвестно
+int resolve_operation(const char *name, size_t len, opcode *op);
+
+/// @brief Число аргументов, которые инструкция снимает со стека
+/// @param op Код операции
+/// @return 0 для операндов и ячеек, 1 для функций, 2 для операторов
+int operation_arity(opcode op);
+
+/// @brief Приоритет операции
+/// @param op Код операции
+/// @return Код приоритета, как у priority
+int operation_priority(opcode op);
+
+/// @brief Разбирает одну лексему с начала строки
+/// @param p Строка, начинается не с разделителя
+/// @param operand_expected 1, если перед лексемой нет операнда или ")": тогда
+/// знак относится к числу или означает унарный минус
+/// @param t Лексема
+/// @return Длина лексемы; 0, если лексема неизвестна или это унарный плюс
+size_t read_token(const char *p, int operand_expected, token *t);
+
+/// @brief Разбирает строку за один проход в массив типизированных лексем.
+/// Лексемы разделяются "|" или пробелами либо идут подряд ("sin(x)*-2");
+/// знак относится к числу, если перед ним нет операнда или ")"
+/// @param input Входная строка, не изменяется
+/// @param tokens Лексемы, освобождаются через free_tokens
+/// @return Код ошибки, при ошибке tokens пуст
+int tokenize(const char *input, token_list *tokens);
+
+/// @brief Добавляет лексему в конец массива
+/// @param tokens Лексемы
+/// @param t Лексема
+/// @return Код ошибки
+int append_token(token_list *tokens, token t);
+
+/// @brief Освобождает массив лексем
+/// @param tokens Лексемы
+void free_tokens(token_list *tokens);
+
+/// @brief Создает пустую таблицу имен
+/// @param table Таблица, освобождается через symbols_free
+void symbols_init(symbol_table *table);
+
+/// @brief Определяет или переопределяет имя: "a=2*pi" или "f(t)=t^2+1".
+/// Имена и параметр - строчные латинские буквы, не совпадающие с x, pi и
+/// встроенными функциями; тело может ссылаться на x и другие имена
+/// @param table Таблица имен
+/// @param definition Определение, пробелы и "|" пропускаются
+/// @return Код ошибки, если определение неправильное или тело не
+/// компилируется (в том числе из-за рекурсии); тогда таблица не меняется
+int define_symbol(symbol_table *table, const char *definition);
+
+/// @brief Удаляет имя из таблицы
+/// @param table Таблица имен
+/// @param name Имя
+/// @return Код ошибки, если имени нет
+int remove_symbol(symbol_table *table, const char *name);
+
+/// @brief Ищет имя в таблице
+/// @param table Таблица имен или NULL
+/// @param name Имя (не обязательно заканчивается нулем)
+/// @param len Длина имени
+/// @return Запись таблицы или NULL
+const symbol *find_symbol(const symbol_table *table, const char *name,
+                          size_t len);
+
+/// @brief Разбирает строку в лексемы, как tokenize, и подставляет имена
+/// пользователя: переменная заменяется своим телом в скобках, вызов функции -
+/// телом в скобках, где параметр заменен аргументом в скобках
+/// @param input Входная строка
+/// @param table Таблица имен или NULL
+/// @param tokens Лексемы, освобождаются через free_tokens
+/// @return Код ошибки: неизвестное имя, вложенность подстановок больше
+/// SYMBOL_MAX_DEPTH или больше SYMBOL_MAX_TOKENS лексем; при ошибке tokens
+/// пуст
+int tokenize_symbols(const char *input, const symbol_table *table,
+                     token_list *tokens);
+
+/// @brief Освобождает таблицу имен
+/// @param table Таблица имен
+void symbols_free(symbol_table *table);
+
+/// @brief Компилирует строку сразу в инструкции без промежуточных массивов
+/// строк и оптимизирует их; можно вызывать из нескольких потоков
+/// @param input Входная строка
+/// @param prog Скомпилированное выражение, освобождается через free_program
+/// @return Код ошибки, при ошибке prog пуст
+int compile_expression(const char *input, program *prog);
+
+/// @brief Компилирует строку, как compile_expression, подставляя имена
+/// пользователя; после подстановки константы сворачиваются вместе с телами
+/// функций, поэтому вызов функции ничего не стоит при вычислении
+/// @param input Входная строка
+/// @param table Таблица имен или NULL
+/// @param prog Скомпилированное выражение, освобождается через free_program
+/// @return Код ошибки, при ошибке prog пуст
+int compile_symbols(const char *input, const symbol_table *table,
+                    program *prog);
+
+/// @brief Компилирует строку, как compile_symbols, но без оптимизации: для
+/// вычисления не в double, где свертка в double потеряла бы точность
+/// @param input Входная строка
+/// @param table Таблица имен или NULL
+/// @param prog Скомпилированное выражение, освобождается через free_program
+/// @param literals Лексемы чисел по номерам инструкций, чтобы перечитать их
+/// записи в другом типе; освобождается через free, при ошибке NULL
+/// @return Код ошибки, при ошибке prog пуст
+int compile_plain(const char *input, const symbol_table *table,
+                  program *prog, token **literals);
+
+/// @brief Запись константы программы, как она введена: "12345678901234567891"
+/// без округления до double, "-pi" для pi. У констант без записи (-1 унарного
+/// минуса) - кратчайшая запись, которая читается обратно в то же double
+/// @param literal Лексема числа из compile_plain
+/// @param value Значение инструкции
+/// @param text Строка не короче NUMBER_TEXT_SIZE
+void literal_text(const token *literal, double value, char *text);
+
+/// @brief Компилирует строку для вычисления в long double
+/// @param input Входная строка
+/// @param table Таблица имен или NULL
+/// @param out Выражение, освобождается через free_long_program
+/// @return Код ошибки, при ошибке out пуст
+int compile_long(const char *input, const symbol_table *table,
+                 long_program *out);
+
+/// @brief Вычисляет выражение в long double; отдельная функция, чтобы
+/// evaluate в double ничего не платил за другие типы
+/// @param prog Выражение
+/// @param x Значение переменной х
+/// @return Результат вычисления
+long double evaluate_long(const long_program *prog, long double x);
+
+/// @brief Освобождает выражение для long double
+/// @param prog Выражение
+void free_long_program(long_program *prog);
+
+/// @brief Вычисляет выражение один раз в long double или десятичных числах
+/// s21_decimal, как кнопка "=" с выбранной точностью; double считается через
+/// кэш выражений
+/// @param input Входная строка
+/// @param table Таблица имен или NULL
+/// @param precision PRECISION_LONG или PRECISION_DECIMAL
+/// @param x Значение переменной х
+/// @param text Результат, не короче PRECISE_TEXT_SIZE
+/// @return Код ошибки, в десятичных числах также для функций и дробных
+/// степеней
+int evaluate_precise(const char *input, const symbol_table *table,
+                     int precision, double x, char *text);
+
+/// @brief Создает пустой кэш выражений
+/// @param cache Кэш, освобождается через cache_free
+/// @param capacity Наибольшее количество выражений
+/// @return Код ошибки
+int cache_init(program_cache *cache, int capacity);
+
+/// @brief Возвращает скомпилированное выражение из кэша, при промахе
+/// компилирует его с именами cache->symbols. Ключ - выражение без лишних
+/// разделителей "|" и пробелов; записи, скомпилированные до изменения таблицы
+/// имен, компилируются заново
+/// @param cache Кэш
+/// @param expression Входная строка
+/// @param flag Код ошибки компиляции
+/// @return Выражение или NULL при ошибке; указатель действителен до
+/// следующего вызова cache_get или cache_free
+const program *cache_get(program_cache *cache, const char *expression,
+                         int *flag);
+
+/// @brief Освобождает кэш вместе со всеми выражениями
+/// @param cache Кэш
+void cache_free(program_cache *cache);
+
+/// @brief Номер дня от 1970-01-01
+/// @param year Год
+/// @param month Месяц от 1
+/// @param day День от 1
+/// @return Дата
+int date_from_civil(int year, int month, int day);
+
+/// @brief Год, месяц и день по номеру дня от 1970-01-01
+/// @param date Дата
+/// @param year Год
+/// @param month Месяц от 1
+/// @param day День от 1
+void civil_from_date(int date, int *year, int *month, int *day);
+
+/// @brief Прибавляет месяцы, день уменьшается до последнего дня месяца
+/// @param date Дата
+/// @param months Количество месяцев
+/// @return Дата
+int add_months(int date, int months);
+
+/// @brief Дата окончания вклада
+/// @param start Дата открытия
+/// @param term Срок
+/// @param term_type DEPOSIT_TERM_DAYS, _MONTHS или _YEARS
+/// @return Дата
+int deposit_end_date(int start, int term, int term_type);
+
+/// @brief Рассчитывает вклад переходом от события к событию (выплаты,
+/// пополнения, снятия, конец года); между событиями проценты считаются
+/// сразу за все дни
+/// @param p Параметры вклада
+/// @param r Результат
+/// @return Код ошибки
+int deposit_calculate(const deposit_params *p, deposit_result *r);
+
+/// @brief deposit_calculate в десятичных числах s21_decimal: суммы и
+/// проценты считаются с 28 знаками, в double переводится только результат.
+/// Медленнее, поэтому перебор сетки считает в double
+/// @param p Параметры вклада
+/// @param r Результат
+/// @return Код ошибки, в том числе при переполнении s21_decimal
+int deposit_calculate_decimal(const deposit_params *p, deposit_result *r);
+
+/// @brief Рассчитывает график платежей по кредиту
+/// @param sum Сумма кредита
+/// @param months Срок в месяцах
+/// @param rate Годовая ставка, %
+/// @param type CREDIT_ANNUITY или CREDIT_DIFFERENTIATED
+/// @param start Дата выдачи, дни от 1970-01-01
+/// @param s График, освобождается free_credit_schedule
+/// @return Код ошибки
+int credit_calculate(double sum, int months, double rate, int type, int start,
+                     credit_schedule *s);
+
+/// @brief credit_calculate в десятичных числах s21_decimal: аннуитет,
+/// проценты, остаток и итоги считаются с 28 знаками, в double переводятся
+/// только значения строк и итогов
+/// @param sum Сумма кредита
+/// @param months Срок в месяцах
+/// @param rate Годовая ставка, %
+/// @param type CREDIT_ANNUITY или CREDIT_DIFFERENTIATED
+/// @param start Дата выдачи, дни от 1970-01-01
+/// @param s График, освобождается free_credit_schedule
+/// @return Код ошибки, в том числе при переполнении s21_decimal
+int credit_calculate_decimal(double sum, int months, double rate, int type,
+                             int start, credit_schedule *s);
+
+/// @brief Итоги кредита без графика: первый и последний платеж, переплата и
+/// общая сумма, память не выделяется
+/// @param sum Сумма кредита
+/// @param months Срок в месяцах
+/// @param rate Годовая ставка, %
+/// @param type CREDIT_ANNUITY или CREDIT_DIFFERENTIATED
+/// @param s Итоги, size = 0
+/// @return Код ошибки
+int credit_summary(double sum, int months, double rate, int type,
+                   credit_schedule *s);
+
+/// @brief Освобождает график платежей
+/// @param s График
+void free_credit_schedule(credit_schedule *s);
+
+/// @brief Число точек перебора
+/// @param p Параметры перебора
+/// @return 2 * число ставок * число сроков или 0, если сетка пуста или
+/// больше INT_MAX точек
+int sweep_size(const sweep_params *p);
+
+/// @brief Считает сетку параметров в пуле потоков. Точки считаются блоками
+/// по SWEEP_BLOCK и передаются emit в вызывающем потоке строго по порядку,
+/// пока остальные блоки еще считаются
+/// @param p Параметры перебора
+/// @param emit Получатель готовых блоков
+/// @param context Передается в emit
+/// @return Код ошибки, CALCULATION_ERROR для пустой или слишком большой сетки
+int sweep(const sweep_params *p, sweep_callback emit, void *context);
+
+/// @brief Сворачивает константы, объединяет одинаковые подвыражения в граф
+/// (общие значения сохраняются в ячейки) и заменяет x^2 на x*x
+/// @param prog Скомпилированное выражение, заменяется оптимизированным
+/// @return Код ошибки, при ошибке prog не меняется
+int optimize_program(program *prog);
+
+/// @brief Объединяет выражения в один граф: общие подвыражения всех
+/// выражений считаются один раз, после вычисления на стеке остаются count
+/// результатов по порядку (evaluate возвращает первый)
+/// @param progs Скомпилированные выражения
+/// @param count Количество выражений
+/// @param out Объединенная программа, освобождается через free_program
+/// @return Код ошибки
+int merge_programs(const program *progs, int count, program *out);
+
+/// @brief Вычисляет скомпилированное выражение без выделения памяти в double
+/// @param prog Скомпилированное выражение
+/// @param x Значение переменной х
+/// @return Результат вычисления
+double evaluate(const program *prog, double x);
+
+/// @brief Одна операция над числами, результат совпадает с evaluate до бита
+/// @param op Код операции
+/// @param a Аргумент функции или левый аргумент оператора
+/// @param b Правый аргумент оператора
+/// @return Результат вычисления
+double evaluate_operation(opcode op, double a, double b);
+
+/// @brief Вычисляет выражение сразу для массива значений х блоками по
+/// BATCH_SIZE: каждая инструкция проходит по всему блоку
+/// @param prog Скомпилированное выражение
+/// @param x Значения переменной х
+/// @param y Массив для результатов (n элементов)
+/// @param n Количество значений
+void evaluate_batch(const program *prog, const double *x, double *y, int n);
+
+/// @brief Вычисляет программу с несколькими результатами (merge_programs) для
+/// массива значений х за один проход
+/// @param prog Объединенная программа
+/// @param outputs Количество результатов
+/// @param x Значения переменной х
+/// @param y Массивы для результатов, y[k] - n значений результата k
+/// @param n Количество значений
+void evaluate_batch_outputs(const program *prog, int outputs, const double *x,
+                            double **y, int n);
+
+/// @brief Собирает выражение в машинный код x86-64 (SSE2, по два значения x
+/// за итерацию, функции вызываются из libm) в отдельных исполняемых страницах
+/// @param prog Скомпилированное выражение
+/// @param out Машинный код, освобождается через free_native
+/// @return Код ошибки: на других архитектурах, при глубине стека больше
+/// NATIVE_REGISTERS или без памяти нужно считать через evaluate_batch
+int compile_native(const program *prog, native_program *out);
+
+/// @brief Вычисляет выражение машинным кодом для массива значений х; можно
+/// вызывать из нескольких потоков
+/// @param native Машинный код, собранный compile_native без ошибки
+/// @param x Значения переменной х
+/// @param y Массив для результатов (n элементов)
+/// @param n Количество значений
+void evaluate_native(const native_program *native, const double *x, double *y,
+                     int n);
+
+/// @brief Освобождает машинный код
+/// @param native Машинный код
+void free_native(native_program *native);
+
+/// @brief Адаптивно строит точки графика: отрезки, где середина отходит от
+/// хорды больше допуска, делятся пополам; на полюсах и скачках ставится разрыв
+/// @param prog Скомпилированное выражение
+/// @param left Левая граница х
+/// @param right Правая граница х
+/// @param initial Количество начальных равных отрезков
+/// @param max_samples Предел количества точек
+/// @param tolerance Допустимое отклонение по y (обычно размер пикселя)
+/// @param out Точки графика, освобождаются через free_samples
+/// @return Код ошибки
+int sample_adaptive(const program *prog, double left, double right,
+                    int initial, int max_samples, double tolerance,
+                    samples *out);
+
+/// @brief Адаптивно строит точки графика в окне [y_low, y_high]: отрезки,
+/// которые по интервальной оценке целиком выше или ниже окна, не делятся
+/// @param prog Скомпилированное выражение
+/// @param left Левая граница х
+/// @param right Правая граница х
+/// @param y_low Нижняя граница видимой области
+/// @param y_high Верхняя граница видимой области
+/// @param initial Количество начальных равных отрезков
+/// @param max_samples Предел количества точек
+/// @param tolerance Допустимое отклонение по y (обычно размер пикселя)
+/// @param out Точки графика, освобождаются через free_samples
+/// @return Код ошибки
+int sample_adaptive_view(const program *prog, double left, double right,
+                         double y_low, double y_high, int initial,
+                         int max_samples, double tolerance, samples *out);
+
+/// @brief Интервальная оценка: отрезок, гарантированно содержащий все
+/// значения выражения при x из [x.low, x.high] (с точностью до округления)
+/// @param prog Скомпилированное выражение
+/// @param x Отрезок значений х
+/// @return Оценка значений; у полюса границы бесконечны
+interval evaluate_interval(const program *prog, interval x);
+
+/// @brief Диапазон y для графика без построения точек: [left, right] делится
+/// на parts частей, части с бесконечной оценкой (асимптоты) и их соседи
+/// пропускаются
+/// @param prog Скомпилированное выражение
+/// @param left Левая граница х
+/// @param right Правая граница х
+/// @param parts Количество частей
+/// @param low Нижняя граница диапазона
+/// @param high Верхняя граница диапазона
+/// @return Код ошибки, если ни одна часть не ограничена
+int interval_range(const program *prog, double left, double right, int parts,
+                   double *low, double *high);
+
+/// @brief Прореживает точки графика до ширины экрана: в каждом из buckets
+/// равных столбцов по x остаются первая, наименьшая, наибольшая и последняя
+/// точки, поэтому линия выглядит так же, как со всеми точками. Бесконечные и
+/// NAN значения дают один разрыв
+/// @param x Значения х по возрастанию
+/// @param y Значения функции
+/// @param n Количество точек
+/// @param buckets Количество столбцов (обычно ширина графика в пикселях)
+/// @param out Не больше 4 * buckets точек и разрывы, освобождаются через
+/// free_samples
+/// @return Код ошибки
+int decimate(const double *x, const double *y, int n, int buckets,
+             samples *out);
+
+/// @brief Освобождает точки графика
+/// @param out Точки графика
+void free_samples(samples *out);
+
+/// @brief Создает пустое живое выражение
+/// @param e Выражение, освобождается через live_free
+/// @param x Значение переменной х
+void live_init(live_expression *e, double x);
+
+/// @brief Приводит выражение к новой строке: лексемы после первого
+/// отличающегося символа отменяются по журналу, новый хвост разбирается и
+/// сразу сворачивается. Работа пропорциональна изменению, а не длине строки
+/// @param e Выражение
+/// @param input Входная строка в формате finish_line
+/// @return Код ошибки первой неправильной лексемы, разбор на ней
+/// останавливается
+int live_set(live_expression *e, const char *input);
+
+/// @brief Значение выражения, как если бы все открытые скобки были закрыты;
+/// сворачиваются только операции, оставшиеся на стеке
+/// @param e Выражение
+/// @param result Результат вычисления
+/// @return Код ошибки, если выражение не закончено операндом или ")"
+int live_result(const live_expression *e, double *result);
+
+/// @brief Меняет значение х; следующий live_set разбирает строку заново
+/// @param e Выражение
+/// @param x Значение переменной х
+void live_set_x(live_expression *e, double x);
+
+/// @brief Освобождает живое выражение
+/// @param e Выражение
+void live_free(live_expression *e);
+
+/// @brief Копирует скомпилированное выражение, например чтобы оно пережило
+/// вытеснение из кэша
+/// @param src Выражение
+/// @param dst Копия, освобождается через free_program
+/// @return Код ошибки
+int copy_program(const program *src, program *dst);
+
+/// @brief Освобождает скомпилированное выражение
+/// @param prog Скомпилированное выражение
+void free_program(program *prog);
 #endif  // TO_RPN_H
@@ -0,0 +1,119 @@
+#define _DEFAULT_SOURCE
+#include <limits.h>
+#include <pthread.h>
+#include <unistd.h>
+
+#include "smartCalc.h"
+
+/// @brief Общее состояние пула: потоки берут блоки сетки по порядку, а
+/// вызывающий поток отдает готовые блоки в том же порядке. Блоков в работе
+/// не больше окна, поэтому память не растет с размером сетки
+typedef struct {
+  const sweep_params *p;
+  sweep_point *window;
+  int *done;
+  int blocks;
+  int points;
+  int next;     // следующий блок для потоков
+  int emitted;  // блоков уже отдано
+  int slots;
+  pthread_mutex_t lock;
+  pthread_cond_t changed;
+} sweep_state;
+
+static double grid_value(sweep_range r, int i) {
+  return r.count > 1 ? r.first + i * (r.last - r.first) / (r.count - 1)
+                     : r.first;
+}
+
+static void compute_point(const sweep_params *p, int index, sweep_point *out) {
+  out->type = index % 2;
+  out->term = (int)lround(grid_value(p->term, index / 2 % p->term.count));
+  out->rate = grid_value(p->rate, index / 2 / p->term.count);
+  if (p->kind == SWEEP_CREDIT) {
+    out->error =
+        credit_summary(p->sum, out->term, out->rate, out->type, &out->credit);
+  } else {
+    deposit_params d = p->deposit;
+    d.sum = p->sum;
+    d.start = p->start;
+    d.term = out->term;
+    d.term_type = DEPOSIT_TERM_MONTHS;
+    d.rate = out->rate;
+    d.capitalization = out->type;
+    out->error = deposit_calculate(&d, &out->deposit);
+  }
+}
+
+static void *worker(void *arg) {
+  sweep_state *s = arg;
+  pthread_mutex_lock(&s->lock);
+  for (;;) {
+    while (s->next < s->blocks && s->next >= s->emitted + s->slots)
+      pthread_cond_wait(&s->changed, &s->lock);
+    if (s->next >= s->blocks) break;
+    int block = s->next++;
+    pthread_mutex_unlock(&s->lock);
+    sweep_point *out = s->window + (block % s->slots) * SWEEP_BLOCK;
+    int first = block * SWEEP_BLOCK;
+    for (int i = first; i - first < SWEEP_BLOCK && i < s->points; i++)
+      compute_point(s->p, i, &out[i - first]);
+    pthread_mutex_lock(&s->lock);
+    s->done[block % s->slots] = 1;
+    pthread_cond_broadcast(&s->changed);
+  }
+  pthread_mutex_unlock(&s->lock);
+  return NULL;
+}
+
+int sweep_size(const sweep_params *p) {
+  long long size = 0;
+  if (p->rate.count > 0 && p->term.count > 0)
+    size = 2LL * p->rate.count * p->term.count;
+  return size <= INT_MAX ? (int)size : 0;
+}
+
+int sweep(const sweep_params *p, sweep_callback emit, void *context) {
+  sweep_state s = {.p = p, .points = sweep_size(p)};
+  int threads = p->threads;
+  if (threads <= 0) threads = (int)sysconf(_SC_NPROCESSORS_ONLN);
+  if (threads <= 0) threads = 1;
+  if (threads > SWEEP_MAX_THREADS) threads = SWEEP_MAX_THREADS;
+  s.blocks = s.points / SWEEP_BLOCK + (s.points % SWEEP_BLOCK != 0);
+  s.slots = 4 * threads;
+  s.window = malloc(sizeof(sweep_point) * SWEEP_BLOCK * s.slots);
+  s.done = calloc(s.slots, sizeof(int));
+  int flag = s.points > 0 && s.window != NULL && s.done != NULL
+                 ? OK
+                 : CALCULATION_ERROR;
+  pthread_t pool[SWEEP_MAX_THREADS];
+  int started = 0;
+  pthread_mutex_init(&s.lock, NULL);
+  pthread_cond_init(&s.changed, NULL);
+  if (flag == OK) {
+    while (started < threads &&
+           pthread_create(&pool[started], NULL, worker, &s) == 0)
+      started++;
+    if (started == 0) flag = CALCULATION_ERROR;
+  }
+  for (int block = 0; flag == OK && block < s.blocks; block++) {
+    int slot = block % s.slots;
+    pthread_mutex_lock(&s.lock);
+    while (!s.done[slot]) pthread_cond_wait(&s.changed, &s.lock);
+    s.done[slot] = 0;
+    pthread_mutex_unlock(&s.lock);
+    int first = block * SWEEP_BLOCK;
+    int count = s.points - first < SWEEP_BLOCK ? s.points - first : SWEEP_BLOCK;
+    emit(s.window + slot * SWEEP_BLOCK, count, context);
+    pthread_mutex_lock(&s.lock);
+    s.emitted++;
+    pthread_cond_broadcast(&s.changed);
+    pthread_mutex_unlock(&s.lock);
+  }
+  for (int i = 0; i < started; i++) pthread_join(pool[i], NULL);
+  pthread_mutex_destroy(&s.lock);
+  pthread_cond_destroy(&s.changed);
+  free(s.window);
+  free(s.done);
+  return flag;
+}
@@ -0,0 +1,280 @@
+#include "smartCalc.h"
+
+/// @brief Параметр функции, тело которой сейчас подставляется
+typedef struct {
+  const char *name;
+  size_t len;
+  const token_list *argument;
+} scope;
+
+static int is_letter(char c) { return c >= 'a' && c <= 'z'; }
+
+static const char *skip_separators(const char *p) {
+  while (*p == '|' || *p == ' ') p++;
+  return p;
+}
+
+static char *copy_text(const char *text, size_t len) {
+  char *result = malloc(len + 1);
+  if (result != NULL) {
+    memcpy(result, text, len);
+    result[len] = '\0';
+  }
+  return result;
+}
+
+/// @brief Имя занято x, pi, встроенной функцией или оператором mod
+static int is_reserved(const char *name, size_t len) {
+  opcode op;
+  return resolve_operation(name, len, &op) != 0 ||
+         (len == 1 && name[0] == 'x') || (len == 2 && !memcmp(name, "pi", 2));
+}
+
+static void free_symbol(symbol *s) {
+  free(s->name);
+  free(s->parameter);
+  free(s->body);
+}
+
+void symbols_init(symbol_table *table) {
+  table->items = NULL;
+  table->size = table->capacity = 0;
+  table->version = 0;
+}
+
+static int find_index(const symbol_table *table, const char *name,
+                      size_t len) {
+  int result = -1;
+  for (int i = 0; table != NULL && i < table->size && result < 0; i++)
+    if (strlen(table->items[i].name) == len &&
+        !memcmp(table->items[i].name, name, len))
+      result = i;
+  return result;
+}
+
+const symbol *find_symbol(const symbol_table *table, const char *name,
+                          size_t len) {
+  int i = find_index(table, name, len);
+  return i >= 0 ? &table->items[i] : NULL;
+}
+
+/// @brief Закрывающая скобка для открывающей open или NULL
+static const char *matching_bracket(const char *open, const char *end) {
+  int depth = 0;
+  const char *result = NULL;
+  for (const char *p = open; p < end && result == NULL; p++) {
+    if (*p == '(') depth++;
+    if (*p == ')' && --depth == 0) result = p;
+  }
+  return result;
+}
+
+static int expand(const char *p, const char *end, const symbol_table *table,
+                  const scope *s, int depth, token_list *out);
+
+static token bracket(token_type type) {
+  return (token){type, OP_NUM, 0, NULL, 0};
+}
+
+/// @brief Подставляет тело в скобках
+static int expand_body(const char *body, const symbol_table *table,
+                       const scope *s, int depth, token_list *out) {
+  int flag = append_token(out, bracket(TOKEN_LEFT));
+  if (flag == OK)
+    flag = expand(body, body + strlen(body), table, s, depth + 1, out);
+  if (flag == OK) flag = append_token(out, bracket(TOKEN_RIGHT));
+  return flag;
+}
+
+/// @brief Подставляет имя, которое начинается в name; для функции *p
+/// сдвигается за скобку с аргументом
+static int expand_name(const char *name, const char **p, const char *end,
+                       const symbol_table *table, const scope *s, int depth,
+                       token_list *out) {
+  int flag = OK;
+  size_t len = *p - name;
+  const symbol *sym = find_symbol(table, name, len);
+  if (s != NULL && len == s->len && !memcmp(name, s->name, len)) {
+    // параметр закрывает одноименное имя таблицы
+    flag = append_token(out, bracket(TOKEN_LEFT));
+    for (int i = 0; i < s->argument->size && flag == OK; i++)
+      flag = append_token(out, s->argument->items[i]);
+    if (flag == OK) flag = append_token(out, bracket(TOKEN_RIGHT));
+  } else if (sym == NULL) {
+    flag = CALCULATION_ERROR;
+  } else if (sym->parameter == NULL) {
+    flag = expand_body(sym->body, table, NULL, depth, out);
+  } else {
+    const char *open = skip_separators(*p);
+    const char *close = *open == '(' ? matching_bracket(open, end) : NULL;
+    token_list argument = {NULL, 0, 0};
+    // аргумент разбирается в области вызова
+    if (close == NULL)
+      flag = CALCULATION_ERROR;
+    else
+      flag = expand(open + 1, close, table, s, depth, &argument);
+    if (flag == OK && argument.size == 0) flag = CALCULATION_ERROR;
+    if (flag == OK) {
+      scope inner = {sym->parameter, strlen(sym->parameter), &argument};
+      flag = expand_body(sym->body, table, &inner, depth, out);
+      *p = close + 1;
+    }
+    free_tokens(&argument);
+  }
+  return flag;
+}
+
+/// @brief Разбор как в tokenize, только неизвестные слова ищутся среди
+/// параметра и имен таблицы
+static int expand(const char *p, const char *end, const symbol_table *table,
+                  const scope *s, int depth, token_list *out) {
+  int flag = depth > SYMBOL_MAX_DEPTH ? CALCULATION_ERROR : OK;
+  while (p < end && flag == OK) {
+    if (*p == '|' || *p == ' ') {
+      p++;
+      continue;
+    }
+    token_type last = out->size ? out->items[out->size - 1].type : TOKEN_LEFT;
+    int operand_expected = last != TOKEN_OPERAND && last != TOKEN_RIGHT;
+    token t;
+    size_t len = read_token(p, operand_expected, &t);
+    if (len > 0) {
+      p += len;
+      flag = append_token(out, t);
+    } else if (*p == '+' && operand_expected) {
+      p++;  // унарный плюс ничего не меняет
+    } else if (is_letter(*p)) {
+      const char *name = p;
+      while (p < end && is_letter(*p)) p++;
+      flag = expand_name(name, &p, end, table, s, depth, out);
+    } else {
+      flag = CALCULATION_ERROR;
+    }
+    // вложенные вызовы удваивают подстановку на каждом уровне
+    if (out->size > SYMBOL_MAX_TOKENS) flag = CALCULATION_ERROR;
+  }
+  return flag;
+}
+
+int tokenize_symbols(const char *input, const symbol_table *table,
+                     token_list *tokens) {
+  tokens->items = NULL;
+  tokens->size = tokens->capacity = 0;
+  int flag = expand(input, input + strlen(input), table, NULL, 0, tokens);
+  if (flag != OK) free_tokens(tokens);
+  return flag;
+}
+
+/// @brief Читает имя из строчных букв
+/// @return Длина имени, 0 если имя не годится
+static size_t read_name(const char *p) {
+  size_t len = 0;
+  while (is_letter(p[len])) len++;
+  return is_reserved(p, len) ? 0 : len;
+}
+
+/// @brief Разбирает "имя=тело" или "имя(параметр)=тело"
+static int parse_definition(const char *definition, symbol *s) {
+  int flag = CALCULATION_ERROR;
+  s->name = s->parameter = s->body = NULL;
+  const char *p = skip_separators(definition);
+  size_t len = read_name(p);
+  const char *name = p;
+  p = skip_separators(p + len);
+  const char *parameter = NULL;
+  size_t parameter_len = 0;
+  if (len > 0 && *p == '(') {
+    parameter = skip_separators(p + 1);
+    parameter_len = read_name(parameter);
+    p = skip_separators(parameter + parameter_len);
+    if (parameter_len == 0 || *p != ')' ||
+        (parameter_len == len && !memcmp(name, parameter, len)))
+      len = 0;
+    else
+      p = skip_separators(p + 1);
+  }
+  if (len > 0 && *p == '=' && *skip_separators(p + 1) != '\0') {
+    s->name = copy_text(name, len);
+    s->body = copy_text(p + 1, strlen(p + 1));
+    if (parameter != NULL) s->parameter = copy_text(parameter, parameter_len);
+    if (s->name != NULL && s->body != NULL &&
+        (parameter == NULL || s->parameter != NULL))
+      flag = OK;
+    else
+      free_symbol(s);
+  }
+  return flag;
+}
+
+/// @brief Пробная компиляция имени: "a" или "f(1)"
+static int check_symbol(const symbol_table *table, const symbol *s) {
+  size_t len = strlen(s->name);
+  char *text = malloc(len + 4);
+  int flag = CALCULATION_ERROR;
+  if (text != NULL) {
+    memcpy(text, s->name, len);
+    strcpy(text + len, s->parameter != NULL ? "(1)" : "");
+    program prog;
+    flag = compile_symbols(text, table, &prog);
+    if (flag == OK) free_program(&prog);
+    free(text);
+  }
+  return flag;
+}
+
+int define_symbol(symbol_table *table, const char *definition) {
+  symbol s;
+  int flag = parse_definition(definition, &s);
+  int i = flag == OK ? find_index(table, s.name, strlen(s.name)) : -1;
+  if (flag == OK && i < 0 && table->size == table->capacity) {
+    int capacity = table->capacity ? table->capacity * 2 : 8;
+    symbol *items = realloc(table->items, sizeof(symbol) * capacity);
+    if (items != NULL) {
+      table->items = items;
+      table->capacity = capacity;
+    } else {
+      free_symbol(&s);
+      flag = CALCULATION_ERROR;
+    }
+  }
+  if (flag == OK) {
+    // новое определение проверяется на месте старого: так находится рекурсия
+    symbol previous = {NULL, NULL, NULL};
+    if (i >= 0) {
+      previous = table->items[i];
+      table->items[i] = s;
+    } else {
+      table->items[table->size++] = s;
+    }
+    flag = check_symbol(table, &s);
+    if (flag == OK) {
+      free_symbol(&previous);
+      table->version++;
+    } else {
+      if (i >= 0)
+        table->items[i] = previous;
+      else
+        table->size--;
+      free_symbol(&s);
+    }
+  }
+  return flag;
+}
+
+int remove_symbol(symbol_table *table, const char *name) {
+  int i = find_index(table, name, strlen(name));
+  int flag = CALCULATION_ERROR;
+  if (i >= 0) {
+    free_symbol(&table->items[i]);
+    table->items[i] = table->items[--table->size];
+    table->version++;
+    flag = OK;
+  }
+  return flag;
+}
+
+void symbols_free(symbol_table *table) {
+  for (int i = 0; i < table->size; i++) free_symbol(&table->items[i]);
+  free(table->items);
+  symbols_init(table);
+}
@@ -29,6 +29,8 @@ int lexems_to_RPN(char **lexems, char **tmp_out, char **RPN) {
       break;
     }
   }
+  if (flag != OK)
+    while (stack) use_top_stack_char(&stack);
   if (flag == OK) {
     for (int i = 0; tmp_out[i] || stack; i++) {
       if (tmp_out[i]) {
@@ -0,0 +1,338 @@
+#include "cli.h"
+
+#define CHUNK_SIZE (16 * BATCH_SIZE)
+#define CLI_CACHE_SIZE 4096
+
+/// @brief Накопленные значения x одного выражения, считаются блоком.
+/// Программа хранится копией: таблица при росте переносит свои записи
+typedef struct {
+  program prog;
+  const native_program *native;
+  double x[CHUNK_SIZE];
+  double y[CHUNK_SIZE];
+  int size;
+} chunk;
+
+/// @brief Выражение, скомпилированное для long double или десятичных чисел
+typedef struct {
+  int type;  // PRECISION_LONG или PRECISION_DECIMAL
+  long_program extended;
+  decimal_program exact;
+  int error;   // код ошибки компиляции
+  char *text;  // скомпилированное выражение или NULL
+} precise;
+
+/// @brief Читает строку любой длины без перевода строки
+/// @return Длина строки или -1 в конце файла
+static long read_line(FILE *in, char **line, size_t *capacity) {
+  size_t len = 0;
+  int c;
+  while ((c = getc(in)) != EOF && c != '\n') {
+    if (len + 1 >= *capacity) {
+      size_t size = *capacity ? *capacity * 2 : 256;
+      char *buffer = realloc(*line, size);
+      if (buffer == NULL) return -1;
+      *line = buffer;
+      *capacity = size;
+    }
+    (*line)[len++] = c;
+  }
+  if (c == EOF && len == 0) return -1;
+  if (len > 0 && (*line)[len - 1] == '\r') len--;
+  if (*line == NULL) {
+    *line = malloc(1);
+    if (*line == NULL) return -1;
+    *capacity = 1;
+  }
+  (*line)[len] = '\0';
+  return len;
+}
+
+static int parse_x(const char *text, double *x) {
+  char *end;
+  *x = strtod(text, &end);
+  while (*end == ' ' || *end == '\t') end++;
+  return end != text && *end == '\0' ? OK : CALCULATION_ERROR;
+}
+
+static int parse_long_x(const char *text, long double *x) {
+  char *end;
+  *x = strtold(text, &end);
+  return end != text && *end == '\0' ? OK : CALCULATION_ERROR;
+}
+
+/// @brief Убирает пробелы и табуляции по краям
+static char *trim(char *text) {
+  while (*text == ' ' || *text == '\t') text++;
+  size_t len = strlen(text);
+  while (len > 0 && (text[len - 1] == ' ' || text[len - 1] == '\t')) len--;
+  text[len] = '\0';
+  return text;
+}
+
+static void flush_chunk(chunk *c) {
+  if (c->size == 0) return;
+  if (c->native != NULL)
+    evaluate_native(c->native, c->x, c->y, c->size);
+  else
+    evaluate_batch(&c->prog, c->x, c->y, c->size);
+  for (int i = 0; i < c->size; i++) printf("%.17g\n", c->y[i]);
+  c->size = 0;
+}
+
+static void add_value(chunk *c, const program *prog,
+                      const native_program *native, double x) {
+  if (c->prog.code != prog->code || c->size == CHUNK_SIZE) flush_chunk(c);
+  c->prog = *prog;
+  c->native = native;
+  c->x[c->size++] = x;
+}
+
+/// @brief Строки "выражение", "выражение;x" или определения имен; подряд
+/// идущие строки с одним выражением считаются одним блоком
+static int run_pairs(FILE *in, program_cache *cache, symbol_table *symbols,
+                     chunk *c) {
+  int errors = 0;
+  char *line = NULL, *previous = NULL;
+  size_t capacity = 0;
+  const program *prog = NULL;
+  while (read_line(in, &line, &capacity) >= 0) {
+    if (strchr(line, '=') != NULL) {
+      // после определения блок и программа предыдущего выражения устарели
+      flush_chunk(c);
+      free(previous);
+      previous = NULL;
+      int flag = define_symbol(symbols, line);
+      puts(flag == OK ? "ok" : "error");
+      if (flag != OK) errors++;
+      continue;
+    }
+    double x = 0;
+    char *separator = strchr(line, ';');
+    int flag = OK;
+    if (separator != NULL) {
+      *separator = '\0';
+      flag = parse_x(separator + 1, &x);
+    }
+    if (flag == OK && (previous == NULL || strcmp(line, previous))) {
+      // промах кэша может вытеснить выражение накопленного блока
+      flush_chunk(c);
+      free(previous);
+      previous = malloc(strlen(line) + 1);
+      if (previous != NULL) strcpy(previous, line);
+      prog = cache_get(cache, line, &flag);
+    }
+    if (flag == OK && prog != NULL) {
+      add_value(c, prog, NULL, x);
+    } else {
+      flush_chunk(c);
+      puts("error");
+      errors++;
+    }
+  }
+  flush_chunk(c);
+  free(previous);
+  free(line);
+  return errors;
+}
+
+static void precise_free(precise *p) {
+  if (p->error == OK && p->type == PRECISION_LONG)
+    free_long_program(&p->extended);
+  else if (p->error == OK)
+    free_decimal_program(&p->exact);
+  p->error = CALCULATION_ERROR;
+  free(p->text);
+  p->text = NULL;
+}
+
+/// @brief Компилирует выражение, если оно отличается от предыдущего
+static int precise_compile(precise *p, const char *expression,
+                           const symbol_table *symbols) {
+  if (p->text == NULL || strcmp(p->text, expression)) {
+    precise_free(p);
+    if (p->type == PRECISION_LONG)
+      p->error = compile_long(expression, symbols, &p->extended);
+    else
+      p->error = compile_decimal(expression, symbols, &p->exact);
+    p->text = malloc(strlen(expression) + 1);
+    if (p->text != NULL) strcpy(p->text, expression);
+  }
+  return p->error;
+}
+
+/// @brief Считает и выводит одно значение
+/// @param x Значение х строкой или NULL для нуля
+static int precise_print(const precise *p, const char *x) {
+  int flag = OK;
+  if (p->type == PRECISION_LONG) {
+    long double value = 0;
+    if (x != NULL) flag = parse_long_x(x, &value);
+    if (flag == OK) printf("%.21Lg\n", evaluate_long(&p->extended, value));
+  } else {
+    s21_decimal value = {{0, 0, 0, 0}}, result;
+    char text[DECIMAL_TEXT_SIZE];
+    if (x != NULL) flag = decimal_from_string(x, &value);
+    if (flag == OK) flag = evaluate_decimal(&p->exact, value, &result);
+    if (flag == OK) {
+      decimal_to_string(result, text);
+      puts(text);
+    }
+  }
+  return flag;
+}
+
+/// @brief Строки как у run_pairs или столбец x как у run_column, но каждое
+/// значение считается отдельно в long double или десятичных числах
+static int run_precise(FILE *in, const char *expression,
+                       symbol_table *symbols, int type) {
+  precise p = {.type = type, .error = CALCULATION_ERROR, .text = NULL};
+  if (expression != NULL && precise_compile(&p, expression, symbols) != OK) {
+    fprintf(stderr, "smartcalc: неправильное выражение: %s\n", expression);
+    precise_free(&p);
+    return -1;
+  }
+  int errors = 0;
+  char *line = NULL;
+  size_t capacity = 0;
+  while (read_line(in, &line, &capacity) >= 0) {
+    int flag;
+    if (expression != NULL) {
+      flag = precise_print(&p, trim(line));
+    } else if (strchr(line, '=') != NULL) {
+      // после определения выражение компилируется заново
+      precise_free(&p);
+      flag = define_symbol(symbols, line);
+      if (flag == OK) puts("ok");
+    } else {
+      char *separator = strchr(line, ';');
+      if (separator != NULL) *separator = '\0';
+      flag = precise_compile(&p, line, symbols);
+      if (flag == OK)
+        flag = precise_print(&p, separator ? trim(separator + 1) : NULL);
+    }
+    if (flag != OK) {
+      puts("error");
+      errors++;
+    }
+  }
+  precise_free(&p);
+  free(line);
+  return errors;
+}
+
+/// @brief Одно выражение и столбец значений x
+static int run_column(FILE *in, const char *expression,
+                      const symbol_table *symbols, chunk *c) {
+  program prog;
+  if (compile_symbols(expression, symbols, &prog) != OK) {
+    fprintf(stderr, "smartcalc: неправильное выражение: %s\n", expression);
+    return -1;
+  }
+  native_program native;
+  int jit = compile_native(&prog, &native) == OK;
+  int errors = 0;
+  char *line = NULL;
+  size_t capacity = 0;
+  while (read_line(in, &line, &capacity) >= 0) {
+    double x;
+    if (parse_x(line, &x) == OK) {
+      add_value(c, &prog, jit ? &native : NULL, x);
+    } else {
+      flush_chunk(c);
+      puts("error");
+      errors++;
+    }
+  }
+  flush_chunk(c);
+  free(line);
+  free_native(&native);
+  free_program(&prog);
+  return errors;
+}
+
+static void usage(void) {
+  fputs(
+      "Использование:\n"
+      "  smartcalc [ФАЙЛ]              строки \"выражение\" или "
+      "\"выражение;x\"\n"
+      "  smartcalc -e ВЫРАЖЕНИЕ [ФАЙЛ] столбец значений x\n"
+      "  -d ИМЯ=ТЕЛО, -d F(T)=ТЕЛО     переменная или функция для выражений;\n"
+      "                                в ФАЙЛЕ определением считается строка\n"
+      "                                с \"=\", на нее выводится ok\n"
+      "  -p double|long|decimal        числа: double (по умолчанию, быстрее\n"
+      "                                всего), long double или точные\n"
+      "                                десятичные (+ - * / mod и целая ^)\n"
+      "  smartcalc sweep credit|deposit ...  перебор ставок и сроков, CSV\n"
+      "  -s                            статистика кэша выражений в stderr\n"
+      "Без ФАЙЛА читается стандартный ввод. На каждую строку выводится\n"
+      "результат или error.\n",
+      stderr);
+}
+
+int main(int argc, char **argv) {
+  if (argc > 1 && !strcmp(argv[1], "sweep"))
+    return sweep_command(argc - 2, argv + 2);
+  const char *expression = NULL;
+  const char *path = NULL;
+  int stats = 0;
+  int type = PRECISION_DOUBLE;
+  symbol_table symbols;
+  symbols_init(&symbols);
+  for (int i = 1; i < argc; i++) {
+    if (!strcmp(argv[i], "-e") && i + 1 < argc && expression == NULL) {
+      expression = argv[++i];
+    } else if (!strcmp(argv[i], "-d") && i + 1 < argc) {
+      if (define_symbol(&symbols, argv[++i]) != OK) {
+        fprintf(stderr, "smartcalc: неправильное определение: %s\n", argv[i]);
+        symbols_free(&symbols);
+        return 2;
+      }
+    } else if (!strcmp(argv[i], "-p") && i + 1 < argc) {
+      const char *name = argv[++i];
+      type = -1;
+      if (!strcmp(name, "double")) type = PRECISION_DOUBLE;
+      if (!strcmp(name, "long")) type = PRECISION_LONG;
+      if (!strcmp(name, "decimal")) type = PRECISION_DECIMAL;
+      if (type < 0) {
+        usage();
+        symbols_free(&symbols);
+        return 2;
+      }
+    } else if (!strcmp(argv[i], "-s")) {
+      stats = 1;
+    } else if (argv[i][0] != '-' && path == NULL) {
+      path = argv[i];
+    } else {
+      usage();
+      symbols_free(&symbols);
+      return 2;
+    }
+  }
+  FILE *in = path != NULL ? fopen(path, "r") : stdin;
+  if (in == NULL) {
+    perror(path);
+    return 2;
+  }
+  program_cache cache;
+  chunk *c = calloc(1, sizeof(chunk));
+  if (c == NULL || cache_init(&cache, CLI_CACHE_SIZE) != OK) return 2;
+  cache.symbols = &symbols;
+  setvbuf(stdout, NULL, _IOFBF, OUTPUT_BUFFER);
+
+  int errors = 0;
+  if (type != PRECISION_DOUBLE)
+    errors = run_precise(in, expression, &symbols, type);
+  else if (expression != NULL)
+    errors = run_column(in, expression, &symbols, c);
+  else
+    errors = run_pairs(in, &cache, &symbols, c);
+  if (stats)
+    fprintf(stderr, "кэш: попаданий %ld, промахов %ld\n", cache.hits,
+            cache.misses);
+  cache_free(&cache);
+  symbols_free(&symbols);
+  free(c);
+  if (in != stdin) fclose(in);
+  return errors < 0 ? 2 : errors > 0;
+}
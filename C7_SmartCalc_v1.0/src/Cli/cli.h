@@ -0,0 +1,15 @@
+#ifndef CLI_H
+#define CLI_H
+
+#include "../Backend/decimal.h"
+
+#define OUTPUT_BUFFER (1 << 16)
+
+/// @brief Команда sweep: перебор ставок и сроков кредита или вклада, CSV в
+/// стандартный вывод
+/// @param argc Число аргументов после слова sweep
+/// @param argv Аргументы после слова sweep
+/// @return Код завершения программы
+int sweep_command(int argc, char **argv);
+
+#endif  // CLI_H
@@ -0,0 +1,139 @@
+#define _DEFAULT_SOURCE
+#include <limits.h>
+#include <time.h>
+
+#include "cli.h"
+
+/// @brief Разбирает "ОТ:ДО:ЧИСЛО" или одно значение
+static int parse_range(const char *text, sweep_range *r) {
+  char *end;
+  r->first = r->last = strtod(text, &end);
+  r->count = 1;
+  if (*end == ':') {
+    r->last = strtod(end + 1, &end);
+    if (*end == ':') r->count = (int)strtol(end + 1, &end, 10);
+  }
+  return end != text && *end == '\0' && r->count > 0 ? OK : CALCULATION_ERROR;
+}
+
+static int parse_date(const char *text, int *date) {
+  int year, month, day;
+  int flag = sscanf(text, "%d-%d-%d", &year, &month, &day) == 3 &&
+                     month >= 1 && month <= 12 && day >= 1 && day <= 31
+                 ? OK
+                 : CALCULATION_ERROR;
+  if (flag == OK) *date = date_from_civil(year, month, day);
+  return flag;
+}
+
+static void print_date(int date) {
+  int year, month, day;
+  civil_from_date(date, &year, &month, &day);
+  printf("%04d-%02d-%02d", year, month, day);
+}
+
+static void print_credit(const sweep_point *points, int count, void *context) {
+  (void)context;
+  for (int i = 0; i < count; i++) {
+    const sweep_point *p = &points[i];
+    printf("%.6g,%d,%s,", p->rate, p->term,
+           p->type == CREDIT_ANNUITY ? "annuity" : "differentiated");
+    if (p->error == OK)
+      printf("%.2f,%.2f,%.2f,%.2f\n", p->credit.first_payment,
+             p->credit.last_payment, p->credit.overpayment, p->credit.total);
+    else
+      puts("error,error,error,error");
+  }
+}
+
+static void print_deposit(const sweep_point *points, int count,
+                          void *context) {
+  (void)context;
+  for (int i = 0; i < count; i++) {
+    const sweep_point *p = &points[i];
+    printf("%.6g,%d,%d,", p->rate, p->term, p->type);
+    if (p->error == OK) {
+      printf("%.2f,%.2f,%.2f,", p->deposit.interest, p->deposit.tax,
+             p->deposit.sum);
+      print_date(p->deposit.finish);
+      putchar('\n');
+    } else {
+      puts("error,error,error,error");
+    }
+  }
+}
+
+static void usage(void) {
+  fputs(
+      "Использование:\n"
+      "  smartcalc sweep credit|deposit -s СУММА -r СТАВКИ -t СРОКИ "
+      "[параметры]\n"
+      "  -r ОТ:ДО:ЧИСЛО   годовые ставки, %\n"
+      "  -t ОТ:ДО:ЧИСЛО   сроки в месяцах\n"
+      "  -d ГГГГ-ММ-ДД    дата выдачи или открытия, по умолчанию сегодня\n"
+      "  -j ПОТОКИ        по умолчанию по числу процессоров\n"
+      "  -p ПЕРИОД        выплаты по вкладу: 0 день, 1 неделя, 2 месяц,\n"
+      "                   3 квартал, 4 полгода, 5 год, 6 в конце срока\n"
+      "  -k СТАВКА        ключевая ставка для налога на проценты по вкладу\n"
+      "Кредит считается аннуитетным и дифференцированным, вклад - без\n"
+      "капитализации и с ней.\n",
+      stderr);
+}
+
+int sweep_command(int argc, char **argv) {
+  sweep_params p = {0};
+  p.start = (int)(time(NULL) / 86400);
+  p.deposit.payment_period = 2;
+  int flag = argc > 0 ? OK : CALCULATION_ERROR;
+  if (flag == OK && !strcmp(argv[0], "deposit"))
+    p.kind = SWEEP_DEPOSIT;
+  else if (flag == OK && strcmp(argv[0], "credit"))
+    flag = CALCULATION_ERROR;
+  int ranges = 0;
+  for (int i = 1; flag == OK && i < argc; i += 2) {
+    const char *option = argv[i];
+    const char *value = i + 1 < argc ? argv[i + 1] : NULL;
+    char *end = NULL;
+    if (value == NULL || option[0] != '-' || option[1] == '\0' ||
+        option[2] != '\0') {
+      flag = CALCULATION_ERROR;
+    } else if (option[1] == 's') {
+      p.sum = strtod(value, &end);
+    } else if (option[1] == 'r') {
+      flag = parse_range(value, &p.rate);
+      ranges |= 1;
+    } else if (option[1] == 't') {
+      flag = parse_range(value, &p.term);
+      ranges |= 2;
+    } else if (option[1] == 'd') {
+      flag = parse_date(value, &p.start);
+    } else if (option[1] == 'j') {
+      p.threads = (int)strtol(value, &end, 10);
+    } else if (option[1] == 'p') {
+      p.deposit.payment_period = (int)strtol(value, &end, 10);
+    } else if (option[1] == 'k') {
+      p.deposit.key_rate = strtod(value, &end);
+      p.deposit.taxed = 1;
+    } else {
+      flag = CALCULATION_ERROR;
+    }
+    if (end != NULL && (end == value || *end != '\0')) flag = CALCULATION_ERROR;
+  }
+  if (flag != OK || ranges != 3 || !(p.sum > 0)) {
+    usage();
+    return 2;
+  }
+  if (sweep_size(&p) == 0) {
+    fprintf(stderr, "smartcalc: в сетке больше %d точек\n", INT_MAX);
+    return 1;
+  }
+  setvbuf(stdout, NULL, _IOFBF, OUTPUT_BUFFER);
+  if (p.kind == SWEEP_CREDIT) {
+    puts("rate,term,type,first_payment,last_payment,overpayment,total");
+    flag = sweep(&p, print_credit, NULL);
+  } else {
+    puts("rate,term,capitalization,interest,tax,sum,finish");
+    flag = sweep(&p, print_deposit, NULL);
+  }
+  return flag == OK ? 0 : 1;
+}
@@ -1,4 +1,4 @@
-QT       += core gui printsupport
+QT       += core gui printsupport concurrent
 
 greaterThan(QT_MAJOR_VERSION, 4): QT += widgets
 
@@ -9,18 +9,42 @@ CONFIG += c++17
 #DEFINES += QT_DISABLE_DEPRECATED_BEFORE=0x060000    # disables all the APIs deprecated before Qt 6.0.0
 
 SOURCES += \
+    ../../Backend/adaptive.c \
+    ../../Backend/batch.c \
+    ../../Backend/cache.c \
     ../../Backend/comm.c \
+    ../../Backend/compile.c \
+    ../../Backend/credit.c \
+    ../../Backend/decimal.c \
+    ../../Backend/decimate.c \
+    ../../Backend/deposit.c \
+    ../../Backend/extended.c \
+    ../../Backend/interval.c \
+    ../../Backend/jit.c \
+    ../../Backend/lexer.c \
+    ../../Backend/live.c \
+    ../../Backend/optimize.c \
+    ../../Backend/precise.c \
     ../../Backend/solution.c \
+    ../../Backend/sweep.c \
+    ../../Backend/symbols.c \
     ../../Backend/toRPN.c \
     credit_calculator.cpp \
+    credit_model.cpp \
     deposit_calculator.cpp \
     main.cpp \
     mainwindow.cpp \
     qcustomplot.cpp
 
+# точные десятичные числа из проекта s21_decimal
+DECIMAL_DIR = ../../../../C5_s21_decimal/src
+SOURCES += $$files($$DECIMAL_DIR/s21_*.c)
+
 HEADERS += \
+    ../../Backend/decimal.h \
     ../../Backend/smartCalc.h \
     ../../Backend/test.check \
+    credit_model.h \
     mainwindow.h \
     qcustomplot.h
 
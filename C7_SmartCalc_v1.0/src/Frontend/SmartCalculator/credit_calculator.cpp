@@ -21,14 +21,7 @@ void MainWindow::on_push_credit_cal_clicked() {
     if (ui->comboBox_term->currentIndex() == 0) {
       credit_term *= 12;
     }
-
-    procent /= 100;
-    if (ui->comboBox_type->currentIndex() == 0) {
-      annuitet_calc(credit_sum, credit_term, procent);
-    } else {
-      difference_calc(credit_sum, credit_term, procent);
-    }
-    setFixedSize(825, 540);
+    credit_calculation(credit_sum, credit_term, procent);
   } else {
     ui->error->setText("Заполнены не все поля!");
   }
@@ -39,116 +32,33 @@ void MainWindow::on_credit_clean_clicked() {
   ui->total->setText("");
   ui->overpayment->setText("");
   ui->date_credit_finish->clear();
+  credit_model->clear();
   setFixedSize(825, 290);
 }
 
-void add_table(double d, QStandardItemModel *model, int i, int j) {
-  QStandardItem *item = new QStandardItem(QString::number(d, 'f', 2));
-  model->setItem(i, j, item);
-}
-
-void add_table_s(const QString &str, QStandardItemModel *model, int i, int j) {
-  QStandardItem *item = new QStandardItem(str);
-  model->setItem(i, j, item);
-}
-
-void MainWindow::annuitet_calc(double credit_sum, int credit_term,
-                               double procent) {
-  procent /= 12;
+void MainWindow::credit_calculation(double credit_sum, int credit_term,
+                                    double procent) {
+  int type = ui->comboBox_type->currentIndex() == 0 ? CREDIT_ANNUITY
+                                                    : CREDIT_DIFFERENTIATED;
   QDate date_start = ui->date_credit_start->date();
-  QDate date_tmp = date_start;
-  QDate date_finish = date_start.addMonths(credit_term);
-  ui->date_credit_finish->setDate(date_finish);
-
-  QStandardItemModel *model = new QStandardItemModel();
-  QStringList labels =
-      QObject::tr(
-          "Дата платежа;Сумма платежа;Платеж по основному долгу;Платеж "
-          "по процентам;Остаток долга")
-          .simplified()
-          .split(";");
-  model->setHorizontalHeaderLabels(labels);
-
-  double payment = credit_sum * procent * (pow((1 + procent), credit_term)) /
-                   (pow((1 + procent), credit_term) - 1);
-  double payment_total = payment * credit_term;
-  double overpayment = 0.0;
-  double debt_balance = credit_sum;
-  int i = 0;
-  for (; date_tmp < date_finish; date_tmp = date_tmp.addMonths(1)) {
-    double overpay = debt_balance * procent;
-    double pay = payment - overpay;
-    debt_balance -= pay;
-    QDate date = date_tmp.addMonths(1);
-    add_table_s(date.toString("dd-MM-yyyy"), model, i, 0);
-    add_table(payment, model, i, 1);
-    add_table(pay, model, i, 2);
-    add_table(overpay, model, i, 3);
-    add_table(debt_balance, model, i, 4);
-    i++;
-    overpayment += overpay;
-  }
-  ui->table_result->setModel(model);
-  ui->table_result->resizeColumnsToContents();
-  ui->table_result->show();
-  annuitet_result(payment, overpayment, payment_total);
-}
-
-void MainWindow::difference_calc(double credit_sum, const int credit_term,
-                                 double procent) {
-  //    QDate date_start_term = QDate::currentDate();
-  procent /= 12;
-  QDate date_start = ui->date_credit_start->date();
-  QDate date_finish = date_start.addMonths(credit_term);
-  ui->date_credit_finish->setDate(date_finish);
-  QDate date_tmp = date_start;
-  double start_payment = 0.0;
-  double end_payment = 0.0;
-  double debt_balance = credit_sum;
-  double month_credit = credit_sum / credit_term;
-  double total_payment = 0.0;
-  double overpayment = 0.0;
-  QStandardItemModel *model = new QStandardItemModel();
-  QStringList labels =
-      QObject::tr(
-          "Дата платежа;Сумма платежа;Платеж по основному долгу;Платеж "
-          "по процентам;Остаток долга")
-          .simplified()
-          .split(";");
-  model->setHorizontalHeaderLabels(labels);
-  int i = 0;
-  for (int j = 1; date_tmp < date_finish;
-       date_tmp = date_tmp.addMonths(1), j++) {
-    double payment =
-        month_credit + (credit_sum - (j - 1) * month_credit) * procent;
-    if (i == 0) {
-      start_payment = payment;
-    } else if (i != 0 && i == credit_term - 1) {
-      end_payment = payment;
+  credit_schedule schedule;
+  // деньги считаются в s21_decimal, double нужен только для вывода
+  if (credit_calculate_decimal(credit_sum, credit_term, procent, type,
+                               to_backend_date(date_start), &schedule) == OK) {
+    ui->date_credit_finish->setDate(date_start.addMonths(credit_term));
+    if (type == CREDIT_ANNUITY || credit_term == 1) {
+      annuitet_result(schedule.first_payment, schedule.overpayment,
+                      schedule.total);
+    } else {
+      difference_result(schedule.first_payment, schedule.last_payment,
+                        schedule.overpayment, schedule.total);
     }
-    total_payment += payment;
-
-    double overpay = debt_balance * procent;
-    double pay = payment - overpay;
-    debt_balance -= pay;
-    overpayment += overpay;
-    QDate date = date_tmp.addMonths(1);
-    add_table_s(date.toString("dd-MM-yyyy"), model, i, 0);
-    add_table(payment, model, i, 1);
-    add_table(pay, model, i, 2);
-    add_table(overpay, model, i, 3);
-    add_table(debt_balance, model, i, 4);
-    i++;
-  }
-
-  if (credit_term == 1) {
-    annuitet_result(start_payment, overpayment, total_payment);
+    credit_model->set_schedule(schedule);
+    ui->table_result->resizeColumnsToContents();
+    setFixedSize(825, 540);
   } else {
-    difference_result(start_payment, end_payment, overpayment, total_payment);
+    ui->error->setText("Ошибка в данных!");
   }
-  ui->table_result->setModel(model);
-  ui->table_result->resizeColumnsToContents();
-  ui->table_result->show();
 }
 
 void MainWindow::annuitet_result(const double payment, const double overpayment,
@@ -0,0 +1,74 @@
+#include "credit_model.h"
+
+#include <QDate>
+
+#include "mainwindow.h"
+
+CreditModel::CreditModel(QObject *parent) : QAbstractTableModel(parent) {
+  schedule.size = 0;
+  schedule.payment = NULL;
+}
+
+CreditModel::~CreditModel() { free_credit_schedule(&schedule); }
+
+void CreditModel::set_schedule(const credit_schedule &s) {
+  beginResetModel();
+  free_credit_schedule(&schedule);
+  schedule = s;
+  endResetModel();
+}
+
+void CreditModel::clear() {
+  beginResetModel();
+  free_credit_schedule(&schedule);
+  endResetModel();
+}
+
+int CreditModel::rowCount(const QModelIndex &parent) const {
+  return parent.isValid() ? 0 : schedule.size;
+}
+
+int CreditModel::columnCount(const QModelIndex &parent) const {
+  return parent.isValid() ? 0 : 5;
+}
+
+QVariant CreditModel::data(const QModelIndex &index, int role) const {
+  QVariant result;
+  int i = index.row();
+  if (role == Qt::DisplayRole && index.isValid() && i < schedule.size) {
+    switch (index.column()) {
+      case 0:
+        result = QDate::fromJulianDay(schedule.date[i] + JULIAN_DAY_1970)
+                     .toString("dd-MM-yyyy");
+        break;
+      case 1:
+        result = QString::number(schedule.payment[i], 'f', 2);
+        break;
+      case 2:
+        result = QString::number(schedule.principal[i], 'f', 2);
+        break;
+      case 3:
+        result = QString::number(schedule.interest[i], 'f', 2);
+        break;
+      case 4:
+        result = QString::number(schedule.balance[i], 'f', 2);
+        break;
+    }
+  }
+  return result;
+}
+
+QVariant CreditModel::headerData(int section, Qt::Orientation orientation,
+                                 int role) const {
+  static const char *labels[] = {
+      "Дата платежа", "Сумма платежа", "Платеж по основному долгу",
+      "Платеж по процентам", "Остаток долга"};
+  QVariant result;
+  if (role == Qt::DisplayRole) {
+    if (orientation == Qt::Horizontal && section >= 0 && section < 5)
+      result = tr(labels[section]);
+    else if (orientation == Qt::Vertical)
+      result = section + 1;
+  }
+  return result;
+}
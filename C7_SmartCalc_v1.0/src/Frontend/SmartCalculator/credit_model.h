@@ -0,0 +1,37 @@
+#ifndef CREDITMODEL_H
+#define CREDITMODEL_H
+
+#include <QAbstractTableModel>
+
+extern "C" {
+#include "../../Backend/smartCalc.h"
+}
+
+/// @brief Таблица графика платежей поверх credit_schedule. Ячейки
+/// форматируются только при отрисовке, поэтому длинный график показывается
+/// сразу
+class CreditModel : public QAbstractTableModel {
+  Q_OBJECT
+
+ public:
+  explicit CreditModel(QObject *parent = nullptr);
+  ~CreditModel();
+
+  /// @brief Заменяет график, модель становится его владельцем
+  void set_schedule(const credit_schedule &schedule);
+
+  /// @brief Удаляет график
+  void clear();
+
+  int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+  int columnCount(const QModelIndex &parent = QModelIndex()) const override;
+  QVariant data(const QModelIndex &index,
+                int role = Qt::DisplayRole) const override;
+  QVariant headerData(int section, Qt::Orientation orientation,
+                      int role = Qt::DisplayRole) const override;
+
+ private:
+  credit_schedule schedule;
+};
+
+#endif  // CREDITMODEL_H
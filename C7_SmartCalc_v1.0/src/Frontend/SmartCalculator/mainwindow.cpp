@@ -1,15 +1,30 @@
 #include "mainwindow.h"
 
+#include <QThread>
+#include <QtConcurrent>
+
 #include "ui_mainwindow.h"
 
 MainWindow::MainWindow(QWidget *parent)
     : QMainWindow(parent), ui(new Ui::MainWindow) {
   ui->setupUi(this);
+  cache_init(&cache, PROGRAM_CACHE_SIZE);
+  symbols_init(&symbols);
+  cache.symbols = &symbols;
+  live_init(&live, ui->doubleSpinBox_x->value());
+  credit_model = new CreditModel(this);
+  ui->table_result->setModel(credit_model);
   start_settings();
   connect_signals();
 }
 
-MainWindow::~MainWindow() { delete ui; }
+MainWindow::~MainWindow() {
+  free_graphs();
+  live_free(&live);
+  cache_free(&cache);
+  symbols_free(&symbols);
+  delete ui;
+}
 
 void MainWindow::start_settings() {
   setFixedSize(624, 533);
@@ -91,6 +106,11 @@ void MainWindow::connect_signals() {
           SLOT(on_button_pi_or_x_clicked()));
   connect(ui->button_pi, SIGNAL(released()), this,
           SLOT(on_button_pi_or_x_clicked()));
+
+  connect(ui->finish_line, SIGNAL(textChanged(QString)), this,
+          SLOT(update_live_result()));
+  connect(ui->tmp_line, SIGNAL(textChanged(QString)), this,
+          SLOT(update_live_result()));
 }
 
 void MainWindow::digits_numbers() {
@@ -295,6 +315,7 @@ void MainWindow::on_button_del_clicked() {
       ui->input_line->setText(inp);
       return;
     }
+    if (delete_symbol_name()) return;
     if (len_i > 1) {
       LAST_I_2;
       if (inp.endsWith("(pi)")) {
@@ -526,22 +547,25 @@ void MainWindow::on_button_equal_clicked() {
   if (flag == OK) {
     if (!ui->checkBox->isChecked()) {
       // ui->finish_line->setText("");
-      long double result;
       double x = ui->doubleSpinBox_x->value();
-      char *lexems[255] = {0};
-      char *RPN[255] = {0};
-      char *tmp_out[255] = {0};
-      int code = OK;
-      to_lexems(input_str, lexems);
-      if (lexems_to_RPN(lexems, tmp_out, RPN)) {
-        ui->tab_result_mistakes->setText(
-            "Не правильное выражение! Проверьте вводимые данные.");
+      int precision = ui->comboBox_precision->currentIndex();
+      if (precision != PRECISION_DOUBLE) {
+        char text[PRECISE_TEXT_SIZE];
+        if (evaluate_precise(input_str, &symbols, precision, x, text) == OK)
+          ui->tab_result_mistakes->setText(text);
+        else
+          ui->tab_result_mistakes->setText(
+              "Не правильное выражение или функция, которую десятичные числа "
+              "не считают точно.");
       } else {
-        result = answer(RPN, x, &code);
-
-        if (code) {
-          ui->tab_result_mistakes->setText("Error!");
+        int code;
+        const program *prog = cache_get(&cache, input_str, &code);
+        show_cache_stats();
+        if (prog == NULL) {
+          ui->tab_result_mistakes->setText(
+              "Не правильное выражение! Проверьте вводимые данные.");
         } else {
+          double result = evaluate(prog, x);
           QString final = QString::number(result, 'g', 7);
           ui->tab_result_mistakes->setText(final);
         }
@@ -560,6 +584,105 @@ void MainWindow::on_button_equal_clicked() {
   }
 }
 
+void MainWindow::update_live_result() {
+  // набираемое число еще в tmp_line, finish_line перед ним кончается на "|"
+  QByteArray array =
+      (ui->finish_line->text() + ui->tmp_line->text()).toLocal8Bit();
+  double result;
+  live_set(&live, array.constData());
+  if (live_result(&live, &result) == OK) {
+    ui->label_live->setText("= " + QString::number(result, 'g', 7));
+  } else {
+    ui->label_live->clear();
+  }
+}
+
+void MainWindow::on_doubleSpinBox_x_valueChanged(double x) {
+  live_set_x(&live, x);
+  update_live_result();
+}
+
+void MainWindow::on_line_define_returnPressed() {
+  QString text = ui->line_define->text().trimmed();
+  QByteArray array = text.toLocal8Bit();
+  int flag;
+  if (text.contains('=')) {
+    flag = define_symbol(&symbols, array.constData());
+  } else {
+    flag = remove_symbol(&symbols, array.constData());
+  }
+  if (flag == OK) {
+    ui->line_define->clear();
+    refresh_symbols();
+    ui->tab_result_mistakes->setText(text.contains('=') ? "Имя определено."
+                                                        : "Имя удалено.");
+    // графики построены по старым определениям; сообщение о графике,
+    // который больше не строится, заменяет сообщение об имени
+    if (!graph_expressions.isEmpty()) plot_graphs();
+  } else {
+    ui->tab_result_mistakes->setText(
+        "Неправильное определение. Пример: a=2*pi или f(t)=t^2+1.");
+  }
+}
+
+void MainWindow::refresh_symbols() {
+  ui->comboBox_symbols->clear();
+  for (int i = 0; i < symbols.size; i++) {
+    const symbol *s = &symbols.items[i];
+    QString name = QString::fromLocal8Bit(s->name);
+    QString head =
+        s->parameter ? name + "(" + QString::fromLocal8Bit(s->parameter) + ")"
+                     : name;
+    ui->comboBox_symbols->addItem(
+        head + "=" + QString::fromLocal8Bit(s->body).remove('|'), name);
+  }
+}
+
+void MainWindow::on_comboBox_symbols_activated(int index) {
+  ui->tab_result_mistakes->clear();
+  QString name = ui->comboBox_symbols->itemData(index).toString();
+  QByteArray array = name.toLocal8Bit();
+  const symbol *s = find_symbol(&symbols, array.constData(), array.size());
+  INP;
+  QChar lastChar = inp.isEmpty() ? '(' : inp.at(inp.length() - 1);
+  if (s == NULL) {
+    refresh_symbols();
+  } else if (!ui->tmp_line->text().isEmpty() ||
+             !(lastChar == '+' || lastChar == '-' || lastChar == '*' ||
+               lastChar == '/' || lastChar == '^' || lastChar == 'd' ||
+               lastChar == '(')) {
+    ui->tab_result_mistakes->setText("Синтаксическая ошибка (Syntax Error)!");
+  } else if (s->parameter != NULL) {
+    ui->input_line->setText(inp + name + "(");
+    ui->finish_line->setText(ui->finish_line->text() + name + "|(|");
+  } else {
+    // переменная вводится в скобках, как pi и x
+    ui->input_line->setText(inp + "(" + name + ")");
+    ui->finish_line->setText(ui->finish_line->text() + name + "|");
+  }
+}
+
+bool MainWindow::delete_symbol_name() {
+  INP;
+  FIN;
+  bool deleted = false;
+  for (int i = 0; i < symbols.size && !deleted; i++) {
+    const symbol *s = &symbols.items[i];
+    QString name = QString::fromLocal8Bit(s->name);
+    QString in_input = s->parameter ? name + "(" : "(" + name + ")";
+    QString in_finish = s->parameter ? name + "|(|" : name + "|";
+    if (inp.endsWith(in_input) &&
+        (fin == in_finish || fin.endsWith("|" + in_finish))) {
+      inp.chop(in_input.length());
+      fin.chop(in_finish.length());
+      ui->finish_line->setText(fin);
+      ui->input_line->setText(inp);
+      deleted = true;
+    }
+  }
+  return deleted;
+}
+
 void MainWindow::on_pushButton_graf_clicked() {
   ui->tab_result_mistakes->setText("");
   if (!ui->tmp_line->text().isEmpty()) {
@@ -573,45 +696,20 @@ void MainWindow::on_pushButton_graf_clicked() {
   int flag = check_brackets_result(input_str, &num);
   if (flag == OK) {
     if (ui->checkBox->isChecked()) {
-      long double result;
-      char *lexems[255] = {0};
-      char *RPN[255] = {0};
-      char *tmp_out[255] = {0};
-      int code = OK;
-      to_lexems(input_str, lexems);
-      if (lexems_to_RPN(lexems, tmp_out, RPN)) {
+      int code;
+      const program *prog = cache_get(&cache, input_str, &code);
+      show_cache_stats();
+      if (prog == NULL) {
         ui->tab_result_mistakes->setText(
             "Не правильное выражение! Проверьте вводимые данные.");
       } else {
         if (ui->input_line->text().contains('x')) {
-          QVector<double> x, y;
-          ui->graph->clearGraphs();
-          x.clear();
-          y.clear();
-
-          double xMax = ui->doubleSpinBox_x_right->value();
-          double step = ui->doubleSpinBox_step->value();
-          double X = ui->doubleSpinBox_x_left->value();
-          for (; X <= xMax; X += step) {
-            result = answer(RPN, X, &code);
-            if (code) {
-              ui->tab_result_mistakes->setText("Error!");
-            } else {
-              x.push_back(X);
-              y.push_back(result);
-            }
-          }
-          ui->graph->clearGraphs();
-          ui->graph->addGraph();
-          ui->graph->graph(0)->setData(x, y);
-          ui->graph->xAxis->rescale();
-          ui->graph->yAxis->rescale();
-          if (ui->comboBox->currentIndex() == 0) {
-          } else {
-            ui->graph->graph(0)->setLineStyle(QCPGraph::lsNone);
-            ui->graph->graph(0)->setScatterStyle(QCPScatterStyle::ssDisc);
-          }
-          ui->graph->replot();
+          // с флажком выражение добавляется к уже построенным графикам
+          QString expression = QString::fromLocal8Bit(input_str);
+          if (!ui->checkBox_add_graph->isChecked()) graph_expressions.clear();
+          if (!graph_expressions.contains(expression))
+            graph_expressions.append(expression);
+          plot_graphs();
         } else {
           ui->tab_result_mistakes->setText(
               "Не возможно построить график. Отсутствует переменная!");
@@ -627,6 +725,212 @@ void MainWindow::on_pushButton_graf_clicked() {
   }
 }
 
+void MainWindow::plot_graphs() {
+  free_graphs();
+  // выражение, которое больше не компилируется (например, удалено имя),
+  // убирается вместе с графиком, чтобы не мешать строить остальные
+  QStringList failed;
+  for (qsizetype i = 0; i < graph_expressions.size();) {
+    // программа берется из кэша, куда ее положила проверка выражения, и
+    // копируется: следующий cache_get может ее вытеснить
+    int code;
+    const program *cached =
+        cache_get(&cache, graph_expressions[i].toLocal8Bit().data(), &code);
+    program prog;
+    if (cached != NULL && copy_program(cached, &prog) == OK) {
+      graph_programs.append(prog);
+      i++;
+    } else {
+      failed.append(graph_expressions.takeAt(i));
+    }
+  }
+  show_cache_stats();
+  qsizetype n = graph_programs.size();
+  if (n > 0 && merge_programs(graph_programs.data(), n, &graph_merged) != OK) {
+    free_graphs();
+    failed.append(graph_expressions);
+    graph_expressions.clear();
+    n = 0;
+  }
+  if (n > 0) {
+    graph_x_left = ui->doubleSpinBox_x_left->value();
+    graph_x_right = ui->doubleSpinBox_x_right->value();
+    graph_step = ui->doubleSpinBox_step->value();
+    graph_mode = ui->comboBox->currentIndex();
+    // диапазон y берется из интервальной оценки до построения точек,
+    // чтобы адаптивный режим не уточнял невидимые участки
+    bool ranged = graph_x_right > graph_x_left &&
+                  set_y_range(graph_programs.data(), n, graph_x_left,
+                              graph_x_right);
+    ui->graph->clearGraphs();
+    for (qsizetype i = 0; i < n; i++) {
+      QCPGraph *graph = ui->graph->addGraph();
+      // первый график синий, как по умолчанию, остальные сдвигаются по кругу
+      graph->setPen(QPen(QColor::fromHsv((240 + GRAPH_HUE_STEP * i) % 360,
+                                         255, 200)));
+      if (graph_mode == 1) {
+        graph->setLineStyle(QCPGraph::lsNone);
+        graph->setScatterStyle(QCPScatterStyle::ssDisc);
+      }
+    }
+    ui->graph->xAxis->setRange(graph_x_left, graph_x_right);
+    resample_graphs();
+    // по точкам диапазон считается, только если оценка не удалась; у
+    // адаптивного графика у полюсов точки уходят в бесконечность
+    if (graph_mode != ADAPTIVE_GRAPH && !ranged) {
+      ui->graph->yAxis->rescale();
+      ui->graph->replot();
+    }
+    // setRange и rescale выше запустили таймер, а графики уже посчитаны
+    resample_timer->stop();
+  } else {
+    ui->graph->clearGraphs();
+    ui->graph->replot();
+  }
+  if (!failed.isEmpty())
+    ui->tab_result_mistakes->setText("Не правильное выражение: " +
+                                     failed.join(", ").remove('|') +
+                                     ". График убран.");
+}
+
+void MainWindow::resample_graphs() {
+  qsizetype n = graph_programs.size();
+  if (n == 0 || ui->graph->graphCount() != n) return;
+  // считается только видимая часть заданного диапазона x
+  QCPRange view = ui->graph->xAxis->range();
+  double left = qMax(view.lower, graph_x_left);
+  double right = qMin(view.upper, graph_x_right);
+  int width = qMax(ui->graph->axisRect()->width(), 1);
+  QVector<double> x;
+  QVector<QVector<double>> y(n);
+  if (graph_mode == ADAPTIVE_GRAPH) {
+    for (qsizetype i = 0; i < n; i++) {
+      sample_graph_adaptive(&graph_programs[i], left, right, x, y[i]);
+      ui->graph->graph(i)->setData(x, y[i], true);
+    }
+  } else {
+    // точки сетки пользователя, но не больше GRAPH_MAX_PER_PIXEL на пиксель
+    double step = graph_step;
+    double first =
+        graph_x_left + ceil((left - graph_x_left) / step - 1e-9) * step;
+    qsizetype count =
+        step > 0 && right >= first ? (right - first) / step + 1 + 1e-9 : 0;
+    qsizetype limit = (qsizetype)width * GRAPH_MAX_PER_PIXEL;
+    if (count > limit) {
+      first = left;
+      step = (right - left) / (limit - 1);
+      count = limit;
+    }
+    sample_graph(&graph_merged, n, first, step, count, x, y);
+    for (qsizetype i = 0; i < n; i++) {
+      samples out;
+      // линия прореживается до ширины графика: столько же точек видно, а
+      // QCustomPlot хранит и перебирает не больше 4 точек на пиксель
+      if (graph_mode == 0 && count > 4 * width &&
+          decimate(x.data(), y[i].data(), count, width, &out) == OK) {
+        ui->graph->graph(i)->setData(QVector<double>(out.x, out.x + out.size),
+                                     QVector<double>(out.y, out.y + out.size),
+                                     true);
+        free_samples(&out);
+      } else {
+        ui->graph->graph(i)->setData(x, y[i], true);
+      }
+    }
+  }
+  ui->graph->replot();
+}
+
+void MainWindow::free_graphs() {
+  for (program &prog : graph_programs) free_program(&prog);
+  graph_programs.clear();
+  free_program(&graph_merged);
+}
+
+void MainWindow::show_cache_stats() {
+  ui->tab_result_mistakes->setToolTip(
+      QString("Кэш выражений: попаданий %1, промахов %2")
+          .arg(cache.hits)
+          .arg(cache.misses));
+}
+
+void MainWindow::sample_graph(const program *prog, int outputs, double x_left,
+                              double step, qsizetype count, QVector<double> &x,
+                              QVector<QVector<double>> &y) {
+  x.resize(count);
+  // data() вызывается до запуска потоков, чтобы векторы не копировались в них
+  QVector<double *> columns(outputs);
+  for (int k = 0; k < outputs; k++) {
+    y[k].resize(count);
+    columns[k] = y[k].data();
+  }
+  // мелкие графики не стоят запуска потоков
+  int parts = qBound<qsizetype>(1, count / GRAPH_MIN_PART,
+                                QThread::idealThreadCount());
+  QVector<QPair<qsizetype, qsizetype>> ranges;
+  for (int p = 0; p < parts; p++)
+    ranges.append({count * p / parts, count * (p + 1) / parts});
+  double *keys = x.data();
+  // машинный код собирается один раз на весь график, без него и для
+  // нескольких графиков считает интерпретатор
+  native_program native;
+  bool jit = outputs == 1 && count >= GRAPH_MIN_PART &&
+             compile_native(prog, &native) == OK;
+  QtConcurrent::blockingMap(
+      ranges, [=, &native](const QPair<qsizetype, qsizetype> &range) {
+        for (qsizetype i = range.first; i < range.second; i++)
+          keys[i] = x_left + i * step;
+        QVector<double *> part(outputs);
+        for (int k = 0; k < outputs; k++) part[k] = columns[k] + range.first;
+        if (jit)
+          evaluate_native(&native, keys + range.first, part[0],
+                          range.second - range.first);
+        else
+          evaluate_batch_outputs(prog, outputs, keys + range.first,
+                                 part.data(), range.second - range.first);
+      });
+  if (jit) free_native(&native);
+}
+
+bool MainWindow::set_y_range(const program *progs, qsizetype count,
+                             double x_left, double x_right) {
+  double low = INFINITY, high = -INFINITY;
+  bool result = true;
+  for (qsizetype i = 0; i < count && result; i++) {
+    double part_low, part_high;
+    result = interval_range(&progs[i], x_left, x_right, INTERVAL_PARTS,
+                            &part_low, &part_high) == OK &&
+             qIsFinite(part_low) && qIsFinite(part_high);
+    low = qMin(low, part_low);
+    high = qMax(high, part_high);
+  }
+  if (result) {
+    double margin = high > low ? (high - low) * 0.05 : 1;
+    ui->graph->yAxis->setRange(low - margin, high + margin);
+  }
+  return result;
+}
+
+void MainWindow::sample_graph_adaptive(const program *prog, double x_left,
+                                       double x_right, QVector<double> &x,
+                                       QVector<double> &y) {
+  // допуск - один пиксель по y, точек не больше ADAPTIVE_PER_PIXEL на пиксель
+  int width = qMax(ui->graph->axisRect()->width(), 1);
+  int height = qMax(ui->graph->axisRect()->height(), 1);
+  double tolerance = ui->graph->yAxis->range().size() / height;
+  samples out;
+  x.clear();
+  y.clear();
+  QCPRange view = ui->graph->yAxis->range();
+  if (sample_adaptive_view(prog, x_left, x_right, view.lower, view.upper,
+                           qMax(width / 8, 8),
+                           qMax(width, 64) * ADAPTIVE_PER_PIXEL, tolerance,
+                           &out) == OK) {
+    x = QVector<double>(out.x, out.x + out.size);
+    y = QVector<double>(out.y, out.y + out.size);
+    free_samples(&out);
+  }
+}
+
 void MainWindow::makePlot() {
   ui->graph->addGraph();
   ui->graph->xAxis->setLabel("x");
@@ -640,11 +944,23 @@ void MainWindow::makePlot() {
   connect(ui->graph->yAxis, SIGNAL(rangeChanged(QCPRange)), ui->graph->yAxis2,
           SLOT(setRange(QCPRange)));
   ui->graph->setInteractions(QCP::iRangeDrag | QCP::iRangeZoom);
+  // при перемещении и масштабировании графики пересчитываются для новой
+  // видимой области; таймер объединяет несколько изменений подряд
+  resample_timer = new QTimer(this);
+  resample_timer->setSingleShot(true);
+  resample_timer->setInterval(GRAPH_RESAMPLE_DELAY);
+  connect(resample_timer, SIGNAL(timeout()), this, SLOT(resample_graphs()));
+  connect(ui->graph->xAxis, SIGNAL(rangeChanged(QCPRange)), resample_timer,
+          SLOT(start()));
+  connect(ui->graph->yAxis, SIGNAL(rangeChanged(QCPRange)), resample_timer,
+          SLOT(start()));
   ui->graph->xAxis->setRange(-10, 10);
   ui->graph->yAxis->setRange(-10, 10);
 }
 
 void MainWindow::on_pushButton_graf_3_clicked() {
+  graph_expressions.clear();
+  free_graphs();
   ui->graph->clearGraphs();
   ui->graph->replot();
 }
@@ -5,9 +5,13 @@
 #include <QLineEdit>
 #include <QMainWindow>
 #include <QString>
+#include <QStringList>
+#include <QTimer>
 #include <QVector>
 #include <cctype>
 
+#include "credit_model.h"
+
 extern "C" {
 #include "../../Backend/smartCalc.h"
 }
@@ -42,6 +46,16 @@ extern "C" {
     ui->tab_result_mistakes->setText("Синтаксическая ошибка (Syntax Error)!"); \
   }
 
+#define GRAPH_MIN_PART (16 * BATCH_SIZE)
+#define ADAPTIVE_GRAPH 2
+#define ADAPTIVE_PER_PIXEL 8
+#define INTERVAL_PARTS 256
+#define GRAPH_HUE_STEP 67
+#define GRAPH_MAX_PER_PIXEL 16
+#define GRAPH_RESAMPLE_DELAY 15
+// юлианский день 1970-01-01
+#define JULIAN_DAY_1970 2440588
+
 QT_BEGIN_NAMESPACE
 namespace Ui {
 class MainWindow;
@@ -111,12 +125,30 @@ class MainWindow : public QMainWindow {
   /// @brief Строит график
   void on_pushButton_graf_clicked();
 
+  /// @brief Показывает результат по мере ввода: выражение разбирается
+  /// заново только с места изменения
+  void update_live_result();
+
+  /// @brief Пересчитывает результат для нового значения х
+  void on_doubleSpinBox_x_valueChanged(double x);
+
+  /// @brief Определяет переменную или функцию пользователя; одно имя без
+  /// "=" удаляет его
+  void on_line_define_returnPressed();
+
+  /// @brief Вставляет выбранное имя во входную строку, как pi или функцию
+  void on_comboBox_symbols_activated(int index);
+
   /// @brief Задает размеры поля графика и все привязки для него
   void makePlot();
 
   /// @brief Очищает поле графика
   void on_pushButton_graf_3_clicked();
 
+  /// @brief Пересчитывает графики для видимой области: линия прореживается
+  /// до ширины графика, адаптивный график уточняется заново
+  void resample_graphs();
+
   /// @brief Валидные символы для кредитного калькулятора
   void credit_calc_validator();
 
@@ -130,11 +162,9 @@ class MainWindow : public QMainWindow {
   /// @brief Очищает кредитный калькулятор
   void on_credit_clean_clicked();
 
-  /// @brief Производит вычисление кредита для аннуитетного платежа
-  void annuitet_calc(double credit_sum, int credit_term, double procent);
-
-  /// @brief Производит вычисление кредита для дифференцированного платежа
-  void difference_calc(double credit_sum, int credit_term, double procent);
+  /// @brief Рассчитывает график платежей и выводит его в таблицу
+  /// @param procent Годовая ставка, %
+  void credit_calculation(double credit_sum, int credit_term, double procent);
 
   /// @brief Выводи результат вычислений
   void annuitet_result(double payment, double overpayment,
@@ -153,37 +183,8 @@ class MainWindow : public QMainWindow {
   /// @brief Первоначальная обработка даных в депозитном калькуляторе
   void deposit_calculation();
 
-  /// @brief Вычисляет последнюю дату вклада
-  QDate get_end_date_term_deposit();
-
-  /// @brief Определяет переодичность выплат
-  QDate get_next_date_payment(QDate date_payment);
-
-  /// @brief Определяет периодичность пополнения и частичного снятия
-  void get_next_date_replanishment_or_withdraw(QDate *date, const int type);
-
-  /// @brief Определяет необходимость пополнения вклада
-  void add_replanishment(double *deposit_sum, QDate *date_replanishment);
-
-  /// @brief Определяет необходимость частичного снятия
-  void sub_withdraw(double *deposit_sum, QDate *date_withdraw);
-
-  /// @brief Расчитывает дневные проценты в году
-  void procent_calculation(const double deposit_sum, const QDate date,
-                           double *sum_procent_of_period,
-                           double *total_sum_procent);
-
-  /// @brief Вычисляет процент налога
-  void add_sum_tax(double *sum_tax, double *sum_procent_of_year);
-
-  /// @brief Вычисление годовых процентов
-  void add_sum_procent_of_year(double *sum_procent_of_year,
-                               double *sum_procent_of_period);
-
-  /// @brief Проверяет дату пополнения или частичного снятия
-  void check_date_replanishment_or_withdraw(
-      const QDate date_start_term, const double sum, const int period,
-      QDate *date_replanishment_or_withdraw);
+  /// @brief Номер дня от 1970-01-01, которым считает бэкенд
+  static int to_backend_date(const QDate &date);
 
   /// @brief Выводит результаты расчета
   void set_deposit_result(const double total_sum_procent, const double sum_tax,
@@ -194,5 +195,55 @@ class MainWindow : public QMainWindow {
 
  private:
   Ui::MainWindow *ui;
+  program_cache cache;
+  symbol_table symbols;  // переменные и функции пользователя
+  live_expression live;  // finish_line и tmp_line, разобранные по мере ввода
+  CreditModel *credit_model;
+  QStringList graph_expressions;  // выражения построенных графиков
+  QVector<program> graph_programs;
+  program graph_merged = {};  // все графики одной программой
+  double graph_x_left = 0;
+  double graph_x_right = 0;
+  double graph_step = 0;
+  int graph_mode = 0;  // линия, точки или адаптивно
+  QTimer *resample_timer;
+
+  /// @brief Показывает статистику кэша выражений в подсказке поля результата
+  void show_cache_stats();
+
+  /// @brief Заполняет список имен пользователя
+  void refresh_symbols();
+
+  /// @brief Стирает имя пользователя в конце входной строки целиком
+  /// @return false, если строка кончается не именем
+  bool delete_symbol_name();
+
+  /// @brief Берет выражения из graph_expressions из кэша и строит графики;
+  /// выражения с ошибкой убираются из списка и называются в сообщении
+  void plot_graphs();
+
+  /// @brief Освобождает скомпилированные выражения графиков
+  void free_graphs();
+
+  /// @brief Заполняет x и y для графиков, деля диапазон на непрерывные куски
+  /// между потоками пула; у каждого потока свой стек вычисления
+  /// @param prog Программа с outputs результатами (merge_programs)
+  /// @param y Значения каждого результата
+  void sample_graph(const program *prog, int outputs, double x_left,
+                    double step, qsizetype count, QVector<double> &x,
+                    QVector<QVector<double>> &y);
+
+  /// @brief Ставит диапазон оси y по интервальной оценке выражений на
+  /// [x_left, x_right], окрестности асимптот не учитываются
+  /// @return false, если оценка хотя бы одного выражения не ограничена, тогда
+  /// диапазон не меняется
+  bool set_y_range(const program *progs, qsizetype count, double x_left,
+                   double x_right);
+
+  /// @brief Заполняет x и y адаптивно: точки сгущаются на крутых участках, на
+  /// полюсах вставляется NAN, чтобы линия рвалась
+  void sample_graph_adaptive(const program *prog, double x_left,
+                             double x_right, QVector<double> &x,
+                             QVector<double> &y);
 };
 #endif  // MAINWINDOW_H
@@ -0,0 +1,271 @@
+#define _DEFAULT_SOURCE
+#include <time.h>
+
+#include "../Backend/smartCalc.h"
+
+#define BENCH_MIN_TIME 0.2
+#define BENCH_LEXEMS 4096
+#define BENCH_POINTS 4096
+#define BENCH_GRAPH "sin(x)*x^2+cos(3*x)/(1+x^2)-ln(2+sin(x))"
+
+/// @brief Число выделений памяти; считается, только если malloc обернут
+/// компоновщиком (make bench в Linux)
+static long allocations = 0;
+
+#ifdef COUNT_ALLOCATIONS
+void *__real_malloc(size_t size);
+void *__real_calloc(size_t count, size_t size);
+void *__real_realloc(void *ptr, size_t size);
+
+void *__wrap_malloc(size_t size) {
+  allocations++;
+  return __real_malloc(size);
+}
+
+void *__wrap_calloc(size_t count, size_t size) {
+  allocations++;
+  return __real_calloc(count, size);
+}
+
+void *__wrap_realloc(void *ptr, size_t size) {
+  allocations++;
+  return __real_realloc(ptr, size);
+}
+#endif
+
+/// @brief Выражение корпуса в формате входной строки калькулятора
+typedef struct {
+  const char *name;
+  char *text;
+  char *copy;  // to_lexems режет строку на месте
+  char *lexems[BENCH_LEXEMS];
+  char *temp_out[BENCH_LEXEMS];
+  char *RPN[BENCH_LEXEMS];
+  int size;  // лексем; массивы очищаются только на эту длину
+  double x;
+} bench_case;
+
+typedef struct {
+  const program *prog;
+  const native_program *native;
+  double x[BENCH_POINTS];
+  double y[BENCH_POINTS];
+} bench_graph;
+
+static double seconds(void) {
+  struct timespec t;
+  clock_gettime(CLOCK_MONOTONIC, &t);
+  return t.tv_sec + t.tv_nsec * 1e-9;
+}
+
+/// @brief Повторяет run, удваивая число повторов, пока замер не займет
+/// BENCH_MIN_TIME
+/// @return Повторов в секунду
+static double measure(void (*run)(void *, long), void *context) {
+  long count = 1;
+  double elapsed = 0;
+  for (;;) {
+    double start = seconds();
+    run(context, count);
+    elapsed = seconds() - start;
+    if (elapsed >= BENCH_MIN_TIME) break;
+    count *= 2;
+  }
+  return count / elapsed;
+}
+
+static void run_brackets(void *context, long count) {
+  bench_case *c = context;
+  for (long i = 0; i < count; i++) {
+    int quantity = 0;
+    check_brackets_result(c->text, &quantity);
+  }
+}
+
+static void split(bench_case *c) {
+  strcpy(c->copy, c->text);
+  memset(c->lexems, 0, sizeof(char *) * (c->size + 1));
+  to_lexems(c->copy, c->lexems);
+}
+
+static void run_lexems(void *context, long count) {
+  for (long i = 0; i < count; i++) split(context);
+}
+
+static void convert(bench_case *c) {
+  memset(c->temp_out, 0, sizeof(char *) * (c->size + 1));
+  memset(c->RPN, 0, sizeof(char *) * (c->size + 1));
+  lexems_to_RPN(c->lexems, c->temp_out, c->RPN);
+}
+
+static void run_RPN(void *context, long count) {
+  for (long i = 0; i < count; i++) convert(context);
+}
+
+static void run_answer(void *context, long count) {
+  bench_case *c = context;
+  for (long i = 0; i < count; i++) {
+    int flag = OK;
+    answer(c->RPN, c->x, &flag);
+  }
+}
+
+static void run_evaluate(void *context, long count) {
+  bench_graph *g = context;
+  for (long i = 0; i < count; i++)
+    for (int j = 0; j < BENCH_POINTS; j++)
+      g->y[j] = evaluate(g->prog, g->x[j]);
+}
+
+static void run_batch(void *context, long count) {
+  bench_graph *g = context;
+  for (long i = 0; i < count; i++)
+    evaluate_batch(g->prog, g->x, g->y, BENCH_POINTS);
+}
+
+static void run_native(void *context, long count) {
+  bench_graph *g = context;
+  for (long i = 0; i < count; i++)
+    evaluate_native(g->native, g->x, g->y, BENCH_POINTS);
+}
+
+static void run_adaptive(void *context, long count) {
+  bench_graph *g = context;
+  for (long i = 0; i < count; i++) {
+    samples out;
+    sample_adaptive(g->prog, -10, 10, 256, 4 * BENCH_POINTS, 1e-3, &out);
+    g->y[0] = out.size;
+    free_samples(&out);
+  }
+}
+
+/// @brief Дописывает к строке лексемы через "|"
+static void append(char **text, size_t *len, const char *lexems) {
+  size_t add = strlen(lexems);
+  char *buffer = realloc(*text, *len + add + 1);
+  if (buffer != NULL) {
+    memcpy(buffer + *len, lexems, add + 1);
+    *text = buffer;
+    *len += add;
+  }
+}
+
+/// @brief Короткое, длинное и глубоко вложенное выражения
+static void make_corpus(bench_case *corpus) {
+  static const char *names[] = {"short", "long", "nested"};
+  for (int i = 0; i < 3; i++) {
+    corpus[i].name = names[i];
+    corpus[i].text = NULL;
+    corpus[i].x = 0.5;
+  }
+  size_t len = 0;
+  append(&corpus[0].text, &len, "2|*|x|+|sin|(|x|)");
+  len = 0;
+  append(&corpus[1].text, &len, "1");
+  for (int i = 0; i < 60; i++)
+    append(&corpus[1].text, &len, "|+|x|*|1.5|-|sin|(|x|/|3|)|^|2");
+  len = 0;
+  for (int i = 0; i < 100; i++)
+    append(&corpus[2].text, &len, i % 2 ? "cos|(|" : "(|1|+|");
+  append(&corpus[2].text, &len, "x");
+  for (int i = 0; i < 100; i++) append(&corpus[2].text, &len, "|)");
+  for (int i = 0; i < 3; i++)
+    corpus[i].copy = malloc(strlen(corpus[i].text) + 1);
+}
+
+static void bench_parsing(bench_case *c, FILE *out) {
+  double brackets = measure(run_brackets, c);
+  c->size = BENCH_LEXEMS - 1;
+  split(c);
+  c->size = 0;
+  while (c->lexems[c->size] != NULL) c->size++;
+  double lexems = measure(run_lexems, c);
+  double RPN = measure(run_RPN, c);
+  long before = allocations;
+  convert(c);
+  long RPN_allocations = allocations - before;
+  double answers = measure(run_answer, c);
+  before = allocations;
+  run_answer(c, 1);
+  fprintf(out,
+          "    {\"expression\": \"%s\", \"lexems\": %d, "
+          "\"check_brackets_result\": %.0f, \"to_lexems\": %.0f, "
+          "\"lexems_to_RPN\": %.0f, \"answer\": %.0f, "
+          "\"allocations_per_lexems_to_RPN\": ",
+          c->name, c->size, brackets, lexems, RPN, answers);
+#ifdef COUNT_ALLOCATIONS
+  fprintf(out, "%ld, \"allocations_per_answer\": %ld}", RPN_allocations,
+          allocations - before);
+#else
+  (void)before;
+  (void)RPN_allocations;
+  fputs("null, \"allocations_per_answer\": null}", out);
+#endif
+}
+
+static void bench_sampling(bench_graph *g, FILE *out) {
+  program prog;
+  compile_expression(BENCH_GRAPH, &prog);
+  native_program native;
+  int jit = compile_native(&prog, &native) == OK;
+  g->prog = &prog;
+  g->native = &native;
+  for (int i = 0; i < BENCH_POINTS; i++)
+    g->x[i] = -10 + 20.0 * i / BENCH_POINTS;
+  long before = allocations;
+  run_evaluate(g, 1);
+  long evaluate_allocations = allocations - before;
+  double scalar = measure(run_evaluate, g) * BENCH_POINTS;
+  double batch = measure(run_batch, g) * BENCH_POINTS;
+  double compiled = jit ? measure(run_native, g) * BENCH_POINTS : 0;
+  run_adaptive(g, 1);
+  double adaptive = measure(run_adaptive, g) * g->y[0];
+  fprintf(out,
+          "    \"expression\": \"%s\",\n"
+          "    \"evaluate\": %.0f,\n"
+          "    \"evaluate_batch\": %.0f,\n",
+          BENCH_GRAPH, scalar, batch);
+  if (jit)
+    fprintf(out, "    \"evaluate_native\": %.0f,\n", compiled);
+  else
+    fputs("    \"evaluate_native\": null,\n", out);
+  fprintf(out, "    \"sample_adaptive\": %.0f,\n", adaptive);
+  fputs("    \"allocations_per_evaluate\": ", out);
+#ifdef COUNT_ALLOCATIONS
+  fprintf(out, "%ld\n", evaluate_allocations);
+#else
+  (void)evaluate_allocations;
+  fputs("null\n", out);
+#endif
+  if (jit) free_native(&native);
+  free_program(&prog);
+}
+
+/// @brief Замеры в JSON: выражений в секунду для каждого этапа разбора и
+/// точек в секунду для построения графика
+int main(int argc, char **argv) {
+  FILE *out = argc > 1 ? fopen(argv[1], "w") : stdout;
+  bench_case *corpus = calloc(3, sizeof(bench_case));
+  bench_graph *graph = malloc(sizeof(bench_graph));
+  if (out == NULL || corpus == NULL || graph == NULL) {
+    perror(argc > 1 ? argv[1] : "bench");
+    return 1;
+  }
+  make_corpus(corpus);
+  fputs("{\n  \"parsing\": [\n", out);
+  for (int i = 0; i < 3; i++) {
+    bench_parsing(&corpus[i], out);
+    fputs(i < 2 ? ",\n" : "\n", out);
+  }
+  fputs("  ],\n  \"sampling\": {\n", out);
+  bench_sampling(graph, out);
+  fputs("  }\n}\n", out);
+  for (int i = 0; i < 3; i++) {
+    free(corpus[i].text);
+    free(corpus[i].copy);
+  }
+  free(corpus);
+  free(graph);
+  if (out != stdout) fclose(out);
+  return 0;
+}
@@ -1,6 +1,7 @@
 #include <check.h>
+#include <limits.h>
 
-#include "../Backend/smartCalc.h"
+#include "../Backend/decimal.h"
 
 START_TEST(test_01) {
   int code = 0;
@@ -247,6 +248,863 @@ START_TEST(test_19) {
 }
 END_TEST
 
+START_TEST(test_20) {
+  int code = 0;
+  program prog;
+  char str[] = "sin|(|x|)|*|-x|+|2|^|x|mod|3|-|log|(|pi|)";
+  char* lexems[255] = {0};
+  char* temp_out[255] = {0};
+  char* RPN[255] = {0};
+  to_lexems(str, lexems);
+  lexems_to_RPN(lexems, temp_out, RPN);
+  ck_assert_int_eq(compile_RPN(RPN, &prog), OK);
+  ck_assert_int_eq(prog.depth, 3);
+  for (double x = -5; x <= 5; x += 0.25) {
+    double expected = sin(x) * -x + fmod(pow(2, x), 3) - log10(M_PI);
+    ck_assert_double_eq_tol(evaluate(&prog, x), expected, 1e-12);
+    ck_assert_double_eq_tol(answer(RPN, x, &code), expected, 1e-12);
+  }
+  ck_assert_int_eq(code, OK);
+  free_program(&prog);
+}
+END_TEST
+
+START_TEST(test_21) {
+  program prog;
+  char str[] = "1|+|*|2";
+  char* lexems[255] = {0};
+  char* temp_out[255] = {0};
+  char* RPN[255] = {0};
+  to_lexems(str, lexems);
+  lexems_to_RPN(lexems, temp_out, RPN);
+  ck_assert_int_eq(compile_RPN(RPN, &prog), CALCULATION_ERROR);
+  ck_assert_ptr_null(prog.code);
+  char* empty[1] = {0};
+  ck_assert_int_eq(compile_RPN(empty, &prog), CALCULATION_ERROR);
+}
+END_TEST
+
+START_TEST(test_22) {
+  program prog;
+  char str[] = "sqrt|(|x|)|+|-x|/|3|*|cos|(|x|^|2|)|-|5|mod|x";
+  char* lexems[255] = {0};
+  char* temp_out[255] = {0};
+  char* RPN[255] = {0};
+  to_lexems(str, lexems);
+  lexems_to_RPN(lexems, temp_out, RPN);
+  ck_assert_int_eq(compile_RPN(RPN, &prog), OK);
+  // не кратно BATCH_SIZE, часть значений отрицательные (sqrt дает NaN)
+  int n = 3 * BATCH_SIZE + 17;
+  double x[3 * BATCH_SIZE + 17], y[3 * BATCH_SIZE + 17];
+  for (int i = 0; i < n; i++) x[i] = -2 + i * 0.01;
+  evaluate_batch(&prog, x, y, n);
+  for (int i = 0; i < n; i++) {
+    double expected =
+        sqrt(x[i]) + -x[i] / 3 * cos(x[i] * x[i]) - fmod(5, x[i]);
+    if (isnan(expected)) {
+      ck_assert(isnan(y[i]));
+    } else {
+      ck_assert_double_eq_tol(y[i], expected, 1e-12);
+    }
+  }
+  free_program(&prog);
+}
+END_TEST
+
+START_TEST(test_23) {
+  program prog;
+  samples out;
+  char str[] = "tan|(|x|)";
+  char* lexems[255] = {0};
+  char* temp_out[255] = {0};
+  char* RPN[255] = {0};
+  to_lexems(str, lexems);
+  lexems_to_RPN(lexems, temp_out, RPN);
+  ck_assert_int_eq(compile_RPN(RPN, &prog), OK);
+  ck_assert_int_eq(sample_adaptive(&prog, -3, 3, 32, 4000, 0.01, &out), OK);
+  ck_assert_int_le(out.size, 4000);
+  int breaks = 0;
+  for (int i = 0; i < out.size; i++) {
+    if (i > 0) ck_assert(out.x[i] > out.x[i - 1]);
+    if (isnan(out.y[i])) {
+      // разрывы только у полюсов -pi/2 и pi/2
+      ck_assert_double_eq_tol(fabs(out.x[i]), M_PI / 2, 1e-3);
+      breaks++;
+    }
+  }
+  ck_assert_int_ge(breaks, 2);
+  free_samples(&out);
+  free_program(&prog);
+}
+END_TEST
+
+START_TEST(test_24) {
+  program prog;
+  samples out;
+  char str[] = "2|*|x|+|1";
+  char* lexems[255] = {0};
+  char* temp_out[255] = {0};
+  char* RPN[255] = {0};
+  to_lexems(str, lexems);
+  lexems_to_RPN(lexems, temp_out, RPN);
+  ck_assert_int_eq(compile_RPN(RPN, &prog), OK);
+  // прямая не делится: только начальные отрезки и их середины
+  ck_assert_int_eq(sample_adaptive(&prog, -10, 10, 16, 4000, 0.01, &out), OK);
+  ck_assert_int_eq(out.size, 2 * 16 + 1);
+  ck_assert_double_eq_tol(out.x[out.size - 1], 10, 1e-12);
+  ck_assert_double_eq_tol(out.y[out.size - 1], 21, 1e-12);
+  free_samples(&out);
+  ck_assert_int_eq(sample_adaptive(&prog, 1, -1, 16, 4000, 0.01, &out),
+                   CALCULATION_ERROR);
+  ck_assert_int_eq(sample_adaptive(&prog, -1, 1, 16, 20, 0.01, &out),
+                   CALCULATION_ERROR);
+  free_program(&prog);
+}
+END_TEST
+
+START_TEST(test_25) {
+  program prog;
+  char str[] = "sin|(|x|)|*|x|+|sin|(|x|)|*|x|^|2|+|sin|(|2|*|pi|)";
+  char* lexems[255] = {0};
+  char* temp_out[255] = {0};
+  char* RPN[255] = {0};
+  to_lexems(str, lexems);
+  lexems_to_RPN(lexems, temp_out, RPN);
+  ck_assert_int_eq(compile_RPN(RPN, &prog), OK);
+  // sin(x) считается один раз, sin(2*pi) свернут, pow не вызывается
+  ck_assert_int_eq(prog.slots, 1);
+  int sines = 0;
+  for (int i = 0; i < prog.size; i++) {
+    ck_assert_int_ne(prog.code[i].op, OP_POW);
+    sines += prog.code[i].op == OP_SIN;
+  }
+  ck_assert_int_eq(sines, 1);
+  double x[BATCH_SIZE + 3], y[BATCH_SIZE + 3];
+  for (int i = 0; i < BATCH_SIZE + 3; i++) x[i] = -3 + i * 0.02;
+  evaluate_batch(&prog, x, y, BATCH_SIZE + 3);
+  for (int i = 0; i < BATCH_SIZE + 3; i++) {
+    double expected = sin(x[i]) * x[i] + sin(x[i]) * x[i] * x[i] + sin(2 * M_PI);
+    ck_assert_double_eq_tol(evaluate(&prog, x[i]), expected, 1e-12);
+    ck_assert_double_eq_tol(y[i], expected, 1e-12);
+  }
+  ck_assert_int_eq(optimize_program(&prog), CALCULATION_ERROR);
+  free_program(&prog);
+}
+END_TEST
+
+START_TEST(test_26) {
+  // строка в формате интерфейса компилируется так же, как через RPN
+  const char* inputs[] = {
+      "1|+|2|+|3|+|4|*|7|*|8|^|3|^|2|",
+      "-1|*|(|888.22|*|sin|(|888|-|+6|)|/|(|85|-|6|)|)",
+      "sqrt|(|x|)|mod|3|-|-x|^|2|+|ln|(|x|)|/|log|(|-pi|*|-x|)",
+      "atan|(|x|)|+|acos|(|x|/|9|)|*|asin|(|.5|)|-|tan|(|x|)|^|cos|(|x|)"};
+  for (size_t k = 0; k < sizeof(inputs) / sizeof(inputs[0]); k++) {
+    char str[256];
+    char* lexems[255] = {0};
+    char* temp_out[255] = {0};
+    char* RPN[255] = {0};
+    program expected, prog;
+    strcpy(str, inputs[k]);
+    to_lexems(str, lexems);
+    lexems_to_RPN(lexems, temp_out, RPN);
+    ck_assert_int_eq(compile_RPN(RPN, &expected), OK);
+    ck_assert_int_eq(compile_expression(inputs[k], &prog), OK);
+    for (double x = 0.125; x < 1.5; x += 0.125)
+      ck_assert_double_eq_tol(evaluate(&prog, x), evaluate(&expected, x),
+                              1e-12);
+    free_program(&expected);
+    free_program(&prog);
+  }
+}
+END_TEST
+
+START_TEST(test_27) {
+  program prog;
+  // запись без разделителей, унарный минус перед скобкой и функцией
+  ck_assert_int_eq(compile_expression("2*-sin(x)+ -(x - 3)^2 mod 5", &prog),
+                   OK);
+  for (double x = -2; x < 2; x += 0.25)
+    ck_assert_double_eq_tol(evaluate(&prog, x),
+                            2 * -sin(x) + fmod(pow(-(x - 3), 2), 5), 1e-12);
+  free_program(&prog);
+  ck_assert_int_eq(compile_expression("2^3^2", &prog), OK);
+  ck_assert_double_eq(evaluate(&prog, 0), 512);
+  free_program(&prog);
+  // длинное выражение не упирается в массивы на 255 лексем
+  char str[4000] = "0";
+  for (int i = 0; i < 600; i++) strcat(str, "|+|x");
+  ck_assert_int_eq(compile_expression(str, &prog), OK);
+  ck_assert_double_eq_tol(evaluate(&prog, 0.5), 300, 1e-9);
+  free_program(&prog);
+  const char* wrong[] = {"",        "sin(x",  "x)",  "2+",   "exp(x)",
+                         "2 3",     "(",      "x#2", "sinx", "1|-1|*"};
+  for (size_t k = 0; k < sizeof(wrong) / sizeof(wrong[0]); k++) {
+    ck_assert_int_eq(compile_expression(wrong[k], &prog), CALCULATION_ERROR);
+    ck_assert_ptr_null(prog.code);
+  }
+}
+END_TEST
+
+START_TEST(test_28) {
+  const char* inputs[] = {"((((x+1)*x+2)*x+3)*x+4)", "-x-(x-1)/(x+1)*-5",
+                          "sin(x)*x+sin(x)*x^2+sqrt(x)", "x mod 3+2^-x",
+                          "atan(x)-ln(x+2)*log(x+3)+acos(x/9)", "-pi"};
+  double x[BATCH_SIZE + 5], y[BATCH_SIZE + 5], expected[BATCH_SIZE + 5];
+  for (int i = 0; i < BATCH_SIZE + 5; i++) x[i] = -4 + i * 0.03;
+  for (size_t k = 0; k < sizeof(inputs) / sizeof(inputs[0]); k++) {
+    program prog;
+    native_program native;
+    ck_assert_int_eq(compile_expression(inputs[k], &prog), OK);
+#if defined(__x86_64__) && !defined(_WIN32)
+    ck_assert_int_eq(compile_native(&prog, &native), OK);
+    // нечетное n проверяет и хвост из одного значения
+    evaluate_native(&native, x, y, BATCH_SIZE + 5);
+    evaluate_batch(&prog, x, expected, BATCH_SIZE + 5);
+    for (int i = 0; i < BATCH_SIZE + 5; i++) {
+      if (isnan(expected[i]))
+        ck_assert(isnan(y[i]));
+      else
+        ck_assert_double_eq(y[i], expected[i]);
+    }
+#else
+    ck_assert_int_eq(compile_native(&prog, &native), CALCULATION_ERROR);
+#endif
+    free_native(&native);
+    free_program(&prog);
+  }
+}
+END_TEST
+
+START_TEST(test_29) {
+  program_cache cache;
+  int code;
+  ck_assert_int_eq(cache_init(&cache, 2), OK);
+  const program* a = cache_get(&cache, "sin|(|x|)|*|2", &code);
+  ck_assert_int_eq(code, OK);
+  ck_assert_double_eq_tol(evaluate(a, 1), 2 * sin(1), 1e-12);
+  // лишние разделители не создают новую запись
+  ck_assert_ptr_eq(cache_get(&cache, " sin ( x ) * 2 ", &code), a);
+  ck_assert_ptr_null(cache_get(&cache, "2|+|", &code));
+  ck_assert_int_eq(code, CALCULATION_ERROR);
+  // ошибка тоже запоминается
+  ck_assert_ptr_null(cache_get(&cache, "2 | +", &code));
+  ck_assert_int_eq(code, CALCULATION_ERROR);
+  ck_assert_int_eq(cache.hits, 2);
+  ck_assert_int_eq(cache.misses, 2);
+  // третье выражение вытесняет давно не использованное sin(x)*2
+  ck_assert_ptr_nonnull(cache_get(&cache, "x+1", &code));
+  ck_assert_int_eq(cache.size, 2);
+  ck_assert_ptr_nonnull(cache_get(&cache, "sin(x)*2", &code));
+  ck_assert_int_eq(cache.misses, 4);
+  const program *cached = cache_get(&cache, "x+1", &code);
+  ck_assert_int_eq(cache.hits, 3);
+  // копия переживает вытеснение выражения из кэша
+  program copy;
+  ck_assert_int_eq(copy_program(cached, &copy), OK);
+  ck_assert_ptr_ne(copy.code, cached->code);
+  cache_get(&cache, "1+x*2", &code);
+  cache_get(&cache, "x^3", &code);
+  ck_assert_double_eq(evaluate(&copy, 2), 3);
+  free_program(&copy);
+  cache_free(&cache);
+}
+END_TEST
+
+START_TEST(test_30) {
+  const char* inputs[] = {"sin(x)*x-cos(x)^3", "x^2-3*x mod 2",
+                          "sqrt(x)+ln(x+3)/(x+5)", "atan(x)*acos(x/4)-2^x",
+                          "tan(x)-asin(x/9)*log(x+9)", "ln(x)^0",
+                          "1^asin(pi*x)", "(x/x)^ln(7*x)"};
+  for (size_t k = 0; k < sizeof(inputs) / sizeof(inputs[0]); k++) {
+    program prog;
+    ck_assert_int_eq(compile_expression(inputs[k], &prog), OK);
+    // все значения на отрезке лежат внутри оценки
+    for (double a = -4; a < 4; a += 0.37) {
+      interval y = evaluate_interval(&prog, (interval){a, a + 0.5});
+      for (double x = a; x <= a + 0.5; x += 0.01) {
+        double v = evaluate(&prog, x);
+        if (isnan(v)) continue;
+        ck_assert_double_ge(v, y.low - 1e-9);
+        ck_assert_double_le(v, y.high + 1e-9);
+      }
+    }
+    free_program(&prog);
+  }
+  // pow(NAN, 0) == 1, как и в evaluate
+  program prog;
+  ck_assert_int_eq(compile_expression("ln(x)^0", &prog), OK);
+  interval y = evaluate_interval(&prog, (interval){-1.3, -1.3});
+  ck_assert_double_eq(y.low, 1);
+  ck_assert_double_eq(y.high, 1);
+  free_program(&prog);
+}
+END_TEST
+
+START_TEST(test_31) {
+  program prog;
+  ck_assert_int_eq(compile_expression("tan(x)", &prog), OK);
+  interval y = evaluate_interval(&prog, (interval){1, 2});
+  ck_assert(isinf(y.low) && isinf(y.high));
+  double low, high;
+  // полюса не растягивают диапазон
+  ck_assert_int_eq(interval_range(&prog, -10, 10, 256, &low, &high), OK);
+  ck_assert_double_lt(high, 100);
+  ck_assert_double_gt(low, -100);
+  free_program(&prog);
+  ck_assert_int_eq(compile_expression("sqrt(x)", &prog), OK);
+  y = evaluate_interval(&prog, (interval){-3, -1});
+  ck_assert(isnan(y.low) && isnan(y.high));
+  ck_assert_int_eq(interval_range(&prog, -3, -1, 16, &low, &high),
+                   CALCULATION_ERROR);
+  free_program(&prog);
+  // кривая далеко над окном не уточняется
+  samples all, visible;
+  ck_assert_int_eq(compile_expression("sin(x*x)+1000", &prog), OK);
+  ck_assert_int_eq(sample_adaptive(&prog, -5, 5, 16, 4000, 0.01, &all), OK);
+  ck_assert_int_eq(
+      sample_adaptive_view(&prog, -5, 5, -1, 1, 16, 4000, 0.01, &visible), OK);
+  ck_assert_int_eq(visible.size, 2 * 16 + 1);
+  ck_assert_int_gt(all.size, visible.size);
+  free_samples(&all);
+  free_samples(&visible);
+  free_program(&prog);
+}
+END_TEST
+
+START_TEST(test_32) {
+  ck_assert_int_eq(date_from_civil(1970, 1, 1), 0);
+  int year, month, day;
+  civil_from_date(date_from_civil(2024, 2, 29), &year, &month, &day);
+  ck_assert(year == 2024 && month == 2 && day == 29);
+  // конец месяца сдвигается на последний день короткого месяца
+  ck_assert_int_eq(add_months(date_from_civil(2023, 1, 31), 1),
+                   date_from_civil(2023, 2, 28));
+  ck_assert_int_eq(deposit_end_date(date_from_civil(2024, 2, 29), 1,
+                                    DEPOSIT_TERM_YEARS),
+                   date_from_civil(2025, 2, 28));
+
+  deposit_params p = {0};
+  p.sum = 100000;
+  p.start = date_from_civil(2023, 1, 1);
+  p.term = 365;
+  p.term_type = DEPOSIT_TERM_DAYS;
+  p.rate = 10;
+  p.payment_period = 6;
+  deposit_result r;
+  ck_assert_int_eq(deposit_calculate(&p, &r), OK);
+  double interest = 364 * 10000.0 / 365 + 10000.0 / 366;
+  ck_assert_double_eq_tol(r.interest, interest, 1e-7);
+  ck_assert_double_eq_tol(r.sum, 100000 + interest, 1e-7);
+  ck_assert_double_eq_tol(r.tax, 0, 1e-9);
+  ck_assert_int_eq(r.finish, date_from_civil(2024, 1, 1));
+
+  // капитализированные проценты не добавляются к сумме второй раз
+  p.payment_period = 2;
+  p.capitalization = 1;
+  deposit_result c;
+  ck_assert_int_eq(deposit_calculate(&p, &c), OK);
+  ck_assert_double_gt(c.interest, r.interest);
+  ck_assert_double_eq_tol(c.sum, 100000 + c.interest, 1e-7);
+
+  // ежедневная капитализация сжата в степень, как сложение по дням
+  p.payment_period = DEPOSIT_DAILY;
+  ck_assert_int_eq(deposit_calculate(&p, &c), OK);
+  double sum = 100000;
+  for (int i = 0; i < 365; i++) sum *= 1 + 0.1 / (i < 364 ? 365 : 366);
+  ck_assert_double_eq_tol(c.sum, sum, 1e-6);
+
+  // налог с дохода сверх необлагаемой суммы
+  p.sum = 10000000;
+  p.rate = 20;
+  p.payment_period = 6;
+  p.capitalization = 0;
+  p.taxed = 1;
+  p.key_rate = 10;
+  ck_assert_int_eq(deposit_calculate(&p, &r), OK);
+  ck_assert_double_gt(r.tax, 0);
+  ck_assert_double_eq_tol(r.sum, p.sum + r.interest - r.tax, 1e-6);
+
+  // снятие всей суммы закрывает вклад
+  p.taxed = 0;
+  p.withdrawal = p.sum;
+  p.withdrawal_date = date_from_civil(2023, 3, 1);
+  ck_assert_int_eq(deposit_calculate(&p, &r), OK);
+  ck_assert_double_eq_tol(r.sum, 0, 1e-9);
+  ck_assert_int_eq(r.finish, p.withdrawal_date);
+  p.rate = 0;
+  ck_assert_int_eq(deposit_calculate(&p, &r), CALCULATION_ERROR);
+}
+END_TEST
+
+START_TEST(test_33) {
+  credit_schedule s;
+  int start = date_from_civil(2024, 1, 31);
+  ck_assert_int_eq(credit_calculate(100000, 12, 12, CREDIT_ANNUITY, start, &s),
+                   OK);
+  ck_assert_int_eq(s.size, 12);
+  ck_assert_double_eq_tol(s.first_payment, 8884.88, 1e-2);
+  ck_assert_double_eq_tol(s.balance[11], 0, 1e-6);
+  ck_assert_double_eq_tol(s.total, 12 * s.first_payment, 1e-6);
+  ck_assert_double_eq_tol(s.overpayment, s.total - 100000, 1e-6);
+  // даты считаются от выдачи и не сползают с 31 числа
+  ck_assert_int_eq(s.date[0], date_from_civil(2024, 2, 29));
+  ck_assert_int_eq(s.date[1], date_from_civil(2024, 3, 31));
+  free_credit_schedule(&s);
+
+  ck_assert_int_eq(
+      credit_calculate(100000, 12, 12, CREDIT_DIFFERENTIATED, start, &s), OK);
+  ck_assert_double_eq_tol(s.first_payment, 9333.33, 1e-2);
+  ck_assert_double_eq_tol(s.last_payment, 8416.67, 1e-2);
+  ck_assert_double_eq_tol(s.overpayment, 6500, 1e-6);
+  ck_assert_double_eq_tol(s.principal[5], 100000.0 / 12, 1e-9);
+  free_credit_schedule(&s);
+
+  ck_assert_int_eq(credit_calculate(1200, 12, 0, CREDIT_ANNUITY, start, &s),
+                   OK);
+  ck_assert_double_eq_tol(s.payment[3], 100, 1e-9);
+  free_credit_schedule(&s);
+  ck_assert_int_eq(credit_calculate(1200, 0, 10, CREDIT_ANNUITY, start, &s),
+                   CALCULATION_ERROR);
+  free_credit_schedule(&s);
+}
+END_TEST
+
+typedef struct {
+  sweep_point *points;
+  int size;
+} sweep_copy;
+
+static void copy_points(const sweep_point *points, int count, void *context) {
+  sweep_copy *copy = context;
+  memcpy(copy->points + copy->size, points, sizeof(sweep_point) * count);
+  copy->size += count;
+}
+
+START_TEST(test_34) {
+  sweep_params p = {0};
+  p.kind = SWEEP_CREDIT;
+  p.rate = (sweep_range){1, 20, 7};
+  p.term = (sweep_range){1, 120, 40};
+  p.sum = 500000;
+  p.threads = 4;
+  int size = sweep_size(&p);
+  ck_assert_int_eq(size, 2 * 7 * 40);
+  sweep_copy copy = {malloc(sizeof(sweep_point) * size), 0};
+  ck_assert_int_eq(sweep(&p, copy_points, &copy), OK);
+  ck_assert_int_eq(copy.size, size);
+  // точки приходят по порядку: ставка, срок, вид платежей
+  for (int i = 0; i < size; i++) {
+    sweep_point *point = &copy.points[i];
+    ck_assert_int_eq(point->type, i % 2);
+    credit_schedule s;
+    ck_assert_int_eq(credit_summary(p.sum, point->term, point->rate,
+                                    point->type, &s),
+                     OK);
+    ck_assert_double_eq_tol(point->credit.total, s.total, 1e-9);
+  }
+  ck_assert_double_eq_tol(copy.points[size - 1].rate, 20, 1e-12);
+  ck_assert_int_eq(copy.points[size - 1].term, 120);
+
+  p.kind = SWEEP_DEPOSIT;
+  p.start = date_from_civil(2024, 1, 1);
+  p.deposit.payment_period = 6;
+  copy.size = 0;
+  ck_assert_int_eq(sweep(&p, copy_points, &copy), OK);
+  ck_assert_int_eq(copy.points[1].deposit.finish,
+                   date_from_civil(2024, 2, 1));
+  ck_assert_double_gt(copy.points[size - 1].deposit.interest, 0);
+  free(copy.points);
+  p.term.count = 0;
+  ck_assert_int_eq(sweep(&p, copy_points, &copy), CALCULATION_ERROR);
+  // 2 * 50000 * 50000 не помещается в int
+  p.rate.count = p.term.count = 50000;
+  ck_assert_int_eq(sweep_size(&p), 0);
+  ck_assert_int_eq(sweep(&p, copy_points, &copy), CALCULATION_ERROR);
+  p.rate.count = 1;
+  p.term.count = INT_MAX / 2;
+  ck_assert_int_eq(sweep_size(&p), INT_MAX - 1);
+}
+END_TEST
+
+START_TEST(test_35) {
+  stack_char *actions = NULL;
+  char text[] = "abc";
+  // стек растет больше одного блока пула
+  for (int i = 0; i < 3 * STACK_POOL_BLOCK; i++)
+    creating_top_stack_char(&actions, text + i % 3);
+  for (int i = 3 * STACK_POOL_BLOCK - 1; i >= 0; i--)
+    ck_assert_ptr_eq(use_top_stack_char(&actions), text + i % 3);
+  ck_assert_ptr_null(actions);
+  // пустой пул начинается заново с того же узла
+  creating_top_stack_char(&actions, text);
+  stack_char *first = actions;
+  use_top_stack_char(&actions);
+  creating_top_stack_char(&actions, text + 1);
+  ck_assert_ptr_eq(actions, first);
+  ck_assert_ptr_eq(use_top_stack_char(&actions), text + 1);
+  free_stack_pool();
+  creating_top_stack_char(&actions, text);
+  ck_assert_ptr_eq(use_top_stack_char(&actions), text);
+  free_stack_pool();
+}
+END_TEST
+
+START_TEST(test_36) {
+  const char *texts[] = {"sin(x)*2", "sin(x)+cos(x)^2", "cos(x)^2/(1+x^2)",
+                         "sin(x)*2"};
+  program progs[4], merged;
+  for (int i = 0; i < 4; i++)
+    ck_assert_int_eq(compile_expression(texts[i], &progs[i]), OK);
+  ck_assert_int_eq(merge_programs(progs, 4, &merged), OK);
+  // sin(x), cos(x)^2 и повторенное выражение считаются один раз
+  int calls = 0;
+  for (int i = 0; i < merged.size; i++)
+    calls += merged.code[i].op == OP_SIN || merged.code[i].op == OP_COS;
+  ck_assert_int_eq(calls, 2);
+  enum { N = BATCH_SIZE + 5 };
+  double x[N], y[4][N], expected[N];
+  double *columns[4] = {y[0], y[1], y[2], y[3]};
+  for (int i = 0; i < N; i++) x[i] = -4 + i * 0.03;
+  evaluate_batch_outputs(&merged, 4, x, columns, N);
+  for (int k = 0; k < 4; k++) {
+    evaluate_batch(&progs[k], x, expected, N);
+    ck_assert_int_eq(memcmp(y[k], expected, sizeof(expected)), 0);
+  }
+  ck_assert_double_eq(evaluate(&merged, x[7]), y[0][7]);
+  free_program(&merged);
+  ck_assert_int_eq(merge_programs(progs, 0, &merged), CALCULATION_ERROR);
+  for (int i = 0; i < 4; i++) free_program(&progs[i]);
+}
+END_TEST
+
+START_TEST(test_37) {
+  enum { N = 200000, BUCKETS = 500 };
+  double *x = malloc(sizeof(double) * N), *y = malloc(sizeof(double) * N);
+  double low = INFINITY, high = -INFINITY;
+  for (int i = 0; i < N; i++) {
+    x[i] = i * 1e-4;
+    y[i] = sin(x[i] * 50) + (i % 7) * 1e-3;
+    low = fmin(low, y[i]);
+    high = fmax(high, y[i]);
+  }
+  samples out;
+  ck_assert_int_eq(decimate(x, y, N, BUCKETS, &out), OK);
+  ck_assert_int_le(out.size, 4 * BUCKETS);
+  ck_assert_double_eq(out.x[0], x[0]);
+  ck_assert_double_eq(out.x[out.size - 1], x[N - 1]);
+  double out_low = INFINITY, out_high = -INFINITY;
+  for (int i = 0; i < out.size; i++) {
+    if (i > 0) ck_assert_double_gt(out.x[i], out.x[i - 1]);
+    out_low = fmin(out_low, out.y[i]);
+    out_high = fmax(out_high, out.y[i]);
+  }
+  // крайние значения не теряются
+  ck_assert_double_eq(out_low, low);
+  ck_assert_double_eq(out_high, high);
+  free_samples(&out);
+  // разрывы остаются, но не повторяются
+  for (int i = 1000; i < 1500; i++) y[i] = NAN;
+  y[3000] = INFINITY;
+  ck_assert_int_eq(decimate(x, y, N, BUCKETS, &out), OK);
+  int gaps = 0;
+  for (int i = 0; i < out.size; i++) {
+    if (isnan(out.y[i])) {
+      gaps++;
+      ck_assert(i > 0 && !isnan(out.y[i - 1]));
+    }
+  }
+  ck_assert_int_eq(gaps, 2);
+  free_samples(&out);
+  ck_assert_int_eq(decimate(x, y, 0, BUCKETS, &out), CALCULATION_ERROR);
+  free(x);
+  free(y);
+}
+END_TEST
+
+START_TEST(test_38) {
+  // ввод по одной кнопке, как его пишет finish_line
+  static const char *steps[] = {"1",
+                                "12",
+                                "12|+|",
+                                "12|+|sin|(|",
+                                "12|+|sin|(|x|",
+                                "12|+|sin|(|x|*|",
+                                "12|+|sin|(|x|*|3.5",
+                                "12|+|sin|(|x|*|3.5|)|",
+                                "12|+|sin|(|x|*|3.5|)|^|",
+                                "12|+|sin|(|x|*|3.5|)|^|2|^|0.5",
+                                "12|+|sin|(|x|*|3.5|)|^|2",
+                                "12|+|sin|(|x|*|3.5|)|",
+                                "12|+|sin|(|x|*|3|)|mod|5",
+                                "-|(|2|-|x|)|/|-pi|*|ln|(|-x|+|10",
+                                "2|^|3|^|2",
+                                "",
+                                "-|sqrt|(|16|)|^|2"};
+  static const char *closed[] = {"1",
+                                 "12",
+                                 NULL,
+                                 NULL,
+                                 "12+sin(x",
+                                 NULL,
+                                 "12+sin(x*3.5",
+                                 "12+sin(x*3.5)",
+                                 NULL,
+                                 "12+sin(x*3.5)^2^0.5",
+                                 "12+sin(x*3.5)^2",
+                                 "12+sin(x*3.5)",
+                                 "12+sin(x*3)mod5",
+                                 "-(2-x)/-pi*ln(-x+10",
+                                 "2^3^2",
+                                 NULL,
+                                 "-sqrt(16)^2"};
+  live_expression e;
+  live_init(&e, 0.7);
+  for (size_t i = 0; i < sizeof(steps) / sizeof(steps[0]); i++) {
+    ck_assert_int_eq(live_set(&e, steps[i]), OK);
+    double result;
+    int flag = live_result(&e, &result);
+    if (closed[i] == NULL) {
+      ck_assert_int_eq(flag, CALCULATION_ERROR);
+    } else {
+      // открытые скобки считаются закрытыми
+      char text[64];
+      int open = 0;
+      for (const char *c = closed[i]; *c; c++)
+        open += (*c == '(') - (*c == ')');
+      snprintf(text, sizeof(text), "%s%.*s", closed[i], open, "))))))))");
+      program prog;
+      ck_assert_int_eq(compile_expression(text, &prog), OK);
+      ck_assert_int_eq(flag, OK);
+      ck_assert_double_eq_tol(result, evaluate(&prog, 0.7), 1e-12);
+      free_program(&prog);
+    }
+  }
+  // ошибка останавливает разбор, исправление продолжает его
+  ck_assert_int_eq(live_set(&e, "2|+|)"), CALCULATION_ERROR);
+  double result;
+  ck_assert_int_eq(live_result(&e, &result), CALCULATION_ERROR);
+  ck_assert_int_eq(live_set(&e, "2|+|(|3|)"), OK);
+  ck_assert_int_eq(live_result(&e, &result), OK);
+  ck_assert_double_eq(result, 5);
+  ck_assert_int_eq(live_set(&e, "2|*|3|)"), CALCULATION_ERROR);
+  ck_assert_int_eq(live_set(&e, "+|2|*|x"), OK);
+  live_set_x(&e, 4);
+  ck_assert_int_eq(live_set(&e, "+|2|*|x"), OK);
+  ck_assert_int_eq(live_result(&e, &result), OK);
+  ck_assert_double_eq(result, 8);
+  live_free(&e);
+}
+END_TEST
+
+START_TEST(test_39) {
+  symbol_table table;
+  symbols_init(&table);
+  ck_assert_int_eq(define_symbol(&table, "a=2*pi"), OK);
+  ck_assert_int_eq(define_symbol(&table, "f(t) = t^2+1"), OK);
+  ck_assert_int_eq(define_symbol(&table, "g|(|t|)|=|f|(|t|)|*|a|+|x"), OK);
+  program prog, expected;
+  ck_assert_int_eq(compile_symbols("g(x)+f(3)-a", &table, &prog), OK);
+  ck_assert_int_eq(compile_expression("(((x)^2+1)*(2*pi)+x)+((3)^2+1)-(2*pi)",
+                                      &expected),
+                   OK);
+  for (double x = -3; x <= 3; x += 0.25)
+    ck_assert_double_eq(evaluate(&prog, x), evaluate(&expected, x));
+  free_program(&prog);
+  free_program(&expected);
+  // тело функции сворачивается вместе с аргументом в одну константу
+  ck_assert_int_eq(compile_symbols("f(3)*a", &table, &prog), OK);
+  ck_assert_int_eq(prog.size, 1);
+  ck_assert_double_eq_tol(evaluate(&prog, 0), 20 * M_PI, 1e-12);
+  free_program(&prog);
+  // параметр закрывает одноименную переменную
+  ck_assert_int_eq(define_symbol(&table, "t=100"), OK);
+  ck_assert_int_eq(compile_symbols("f(-t)+f(2)", &table, &prog), OK);
+  ck_assert_double_eq(evaluate(&prog, 0), 10001 + 5);
+  free_program(&prog);
+  // ошибки не меняют таблицу
+  unsigned long version = table.version;
+  ck_assert_int_eq(define_symbol(&table, "sin=2"), CALCULATION_ERROR);
+  ck_assert_int_eq(define_symbol(&table, "h(h)=1"), CALCULATION_ERROR);
+  ck_assert_int_eq(define_symbol(&table, "h(t)=h(t)+1"), CALCULATION_ERROR);
+  ck_assert_int_eq(define_symbol(&table, "f(t)=g(t)"), CALCULATION_ERROR);
+  ck_assert_int_eq(define_symbol(&table, "b=c+1"), CALCULATION_ERROR);
+  ck_assert_int_eq(define_symbol(&table, "b="), CALCULATION_ERROR);
+  ck_assert_int_eq(define_symbol(&table, "b2=1"), CALCULATION_ERROR);
+  ck_assert_int_eq(table.version, version);
+  ck_assert_int_eq(table.size, 4);
+  ck_assert_int_eq(compile_symbols("f(2", &table, &prog), CALCULATION_ERROR);
+  ck_assert_int_eq(compile_symbols("f()", &table, &prog), CALCULATION_ERROR);
+  ck_assert_int_eq(compile_symbols("f", &table, &prog), CALCULATION_ERROR);
+  ck_assert_int_eq(compile_expression("a", &prog), CALCULATION_ERROR);
+  // кэш перекомпилирует выражения после изменения таблицы
+  program_cache cache;
+  cache_init(&cache, 4);
+  cache.symbols = &table;
+  int flag;
+  const program *cached = cache_get(&cache, "f|(|2|)", &flag);
+  ck_assert_double_eq(evaluate(cached, 0), 5);
+  ck_assert_int_eq(define_symbol(&table, "f(t)=t*x"), OK);
+  cached = cache_get(&cache, "f|(|2|)", &flag);
+  ck_assert_int_eq(flag, OK);
+  ck_assert_double_eq(evaluate(cached, 3), 6);
+  ck_assert_int_eq(cache.hits, 1);
+  ck_assert_int_eq(remove_symbol(&table, "f"), OK);
+  ck_assert_int_eq(remove_symbol(&table, "f"), CALCULATION_ERROR);
+  ck_assert_ptr_null(cache_get(&cache, "f(2)", &flag));
+  ck_assert_int_eq(flag, CALCULATION_ERROR);
+  cache_free(&cache);
+  symbols_free(&table);
+}
+END_TEST
+
+/// @brief Точное значение выражения строкой или "error"
+static void decimal_text(const char *input, const char *x, char *text) {
+  decimal_program prog;
+  s21_decimal value = {{0, 0, 0, 0}}, result;
+  int flag = compile_decimal(input, NULL, &prog);
+  if (flag == OK && x != NULL) flag = decimal_from_string(x, &value);
+  if (flag == OK) flag = evaluate_decimal(&prog, value, &result);
+  if (flag == OK)
+    decimal_to_string(result, text);
+  else
+    strcpy(text, "error");
+  free_decimal_program(&prog);
+}
+
+START_TEST(test_40) {
+  // long double: константы читаются заново, а не сворачиваются в double
+  long_program extended;
+  ck_assert_int_eq(compile_long("0.1+0.2*x", NULL, &extended), OK);
+  ck_assert_ldouble_eq(evaluate_long(&extended, 1), 0.1L + 0.2L);
+  free_long_program(&extended);
+  ck_assert_int_eq(compile_long("sin(x)^2+cos(x)^2-pi", NULL, &extended), OK);
+  ck_assert_ldouble_eq_tol(evaluate_long(&extended, 0.5),
+                           1 - 3.141592653589793238462643383279502884L,
+                           1e-18);
+  free_long_program(&extended);
+  ck_assert_int_eq(compile_long("2+", NULL, &extended), CALCULATION_ERROR);
+  // число читается из записи, без округления до 17 цифр double
+  ck_assert_int_eq(compile_long("12345678901234567891+1", NULL, &extended), OK);
+  ck_assert_ldouble_eq(evaluate_long(&extended, 0), 12345678901234567892.0L);
+  free_long_program(&extended);
+  ck_assert_int_eq(compile_long("3.141592653589793*1", NULL, &extended), OK);
+  ck_assert_ldouble_eq(evaluate_long(&extended, 0), 3.141592653589793L);
+  free_long_program(&extended);
+  // десятичные числа считаются точно
+  char text[DECIMAL_TEXT_SIZE];
+  decimal_text("0.1+0.2", NULL, text);
+  ck_assert_str_eq(text, "0.3");
+  decimal_text("x*3-0.3", "0.1", text);
+  ck_assert_str_eq(text, "0");
+  decimal_text("1000000*7.9/1200", NULL, text);
+  ck_assert_str_eq(text, "6583.3333333333333333333333333");
+  decimal_text("-(1.1^2)+2^-2", NULL, text);
+  ck_assert_str_eq(text, "-0.96");
+  decimal_text("-x mod 2", "7.5", text);
+  ck_assert_str_eq(text, "-1.5");
+  decimal_text("pi", NULL, text);
+  ck_assert_str_eq(text, "3.1415926535897932384626433833");
+  decimal_text("2^0.5", NULL, text);
+  ck_assert_str_eq(text, "error");
+  decimal_text("sqrt(x)", "4", text);
+  ck_assert_str_eq(text, "error");
+  decimal_text("1/(x-1)", "1", text);
+  ck_assert_str_eq(text, "error");
+  decimal_text("10^29", NULL, text);
+  ck_assert_str_eq(text, "error");
+  decimal_text("12345678901234567891+1", NULL, text);
+  ck_assert_str_eq(text, "12345678901234567892");
+  decimal_text("0.12345678901234567891*1", NULL, text);
+  ck_assert_str_eq(text, "0.12345678901234567891");
+  decimal_text("3.141592653589793*1", NULL, text);
+  ck_assert_str_eq(text, "3.141592653589793");
+  decimal_text("79228162514264337593543950335-1", NULL, text);
+  ck_assert_str_eq(text, "79228162514264337593543950334");
+  decimal_text("-pi*1", NULL, text);
+  ck_assert_str_eq(text, "-3.1415926535897932384626433833");
+  // запись числа
+  s21_decimal value;
+  ck_assert_int_eq(decimal_from_string("-12.50e-1", &value), OK);
+  decimal_to_string(value, text);
+  ck_assert_str_eq(text, "-1.25");
+  // 29-я цифра после точки округляется
+  const char *digits = "0.12345678901234567890123456789";
+  ck_assert_int_eq(decimal_from_string(digits, &value), OK);
+  decimal_to_string(value, text);
+  ck_assert_str_eq(text, "0.1234567890123456789012345679");
+  ck_assert_int_eq(decimal_from_string("1..2", &value), CALCULATION_ERROR);
+  ck_assert_int_eq(decimal_from_string("1e", &value), CALCULATION_ERROR);
+  ck_assert_int_eq(decimal_from_string("", &value), CALCULATION_ERROR);
+  // 2^96 не помещается в мантиссу
+  int flag = decimal_from_string("79228162514264337593543950336", &value);
+  ck_assert_int_eq(flag, CALCULATION_ERROR);
+}
+END_TEST
+
+START_TEST(test_41) {
+  // 1000000 * 0.0065 / (1 - 1.0065^-360) с 28 знаками
+  credit_schedule s;
+  ck_assert_int_eq(
+      credit_calculate_decimal(1000000, 360, 7.8, CREDIT_ANNUITY, 0, &s), OK);
+  ck_assert_double_eq(s.first_payment, 7198.7050084042614937533153176);
+  ck_assert_double_eq_tol(s.balance[359], 0, 1e-15);
+  free_credit_schedule(&s);
+  // проценты 0.0065 * 1000000 * 361 / 2 без ошибки двоичной дроби
+  ck_assert_int_eq(credit_calculate_decimal(1000000, 360, 7.8,
+                                            CREDIT_DIFFERENTIATED, 0, &s),
+                   OK);
+  ck_assert_double_eq(s.overpayment, 1173250);
+  ck_assert_double_eq(s.total, 2173250);
+  free_credit_schedule(&s);
+  ck_assert_int_eq(credit_calculate_decimal(0, 12, 10, CREDIT_ANNUITY, 0, &s),
+                   CALCULATION_ERROR);
+
+  deposit_params p = {0};
+  p.sum = 100000;
+  p.start = date_from_civil(2022, 1, 1);
+  p.term = 365;
+  p.term_type = DEPOSIT_TERM_DAYS;
+  p.rate = 3.65;
+  p.payment_period = 6;
+  deposit_result r, expected;
+  ck_assert_int_eq(deposit_calculate_decimal(&p, &r), OK);
+  ck_assert_double_eq(r.interest, 3650);
+  ck_assert_double_eq(r.sum, 103650);
+  // события те же, что у deposit_calculate
+  p.sum = 10000000;
+  p.rate = 20;
+  p.term = 3;
+  p.term_type = DEPOSIT_TERM_YEARS;
+  p.payment_period = 2;
+  p.capitalization = 1;
+  p.replenishment = 5000;
+  p.replenishment_date = p.start;
+  p.replenishment_period = 1;
+  p.taxed = 1;
+  p.key_rate = 10;
+  ck_assert_int_eq(deposit_calculate_decimal(&p, &r), OK);
+  ck_assert_int_eq(deposit_calculate(&p, &expected), OK);
+  ck_assert_double_eq_tol(r.interest, expected.interest, 1e-6);
+  ck_assert_double_eq_tol(r.tax, expected.tax, 1e-6);
+  ck_assert_double_eq_tol(r.sum, expected.sum, 1e-6);
+  ck_assert_int_eq(r.finish, expected.finish);
+
+  char text[PRECISE_TEXT_SIZE];
+  ck_assert_int_eq(
+      evaluate_precise("0.1+0.2", NULL, PRECISION_DECIMAL, 0, text), OK);
+  ck_assert_str_eq(text, "0.3");
+  ck_assert_int_eq(evaluate_precise("x*x", NULL, PRECISION_DECIMAL, 2.5, text),
+                   OK);
+  ck_assert_str_eq(text, "6.25");
+  ck_assert_int_eq(
+      evaluate_precise("sin(x)", NULL, PRECISION_DECIMAL, 1, text),
+      CALCULATION_ERROR);
+  ck_assert_int_eq(evaluate_precise("1/4", NULL, PRECISION_LONG, 0, text), OK);
+  ck_assert_str_eq(text, "0.25");
+}
+END_TEST
+
 int main(void) {
   Suite* s1 = suite_create("SmartCalc");
   TCase* tc1_1 = tcase_create("SmartCalc");
@@ -272,6 +1130,28 @@ int main(void) {
   tcase_add_test(tc1_1, test_17);
   tcase_add_test(tc1_1, test_18);
   tcase_add_test(tc1_1, test_19);
+  tcase_add_test(tc1_1, test_20);
+  tcase_add_test(tc1_1, test_21);
+  tcase_add_test(tc1_1, test_22);
+  tcase_add_test(tc1_1, test_23);
+  tcase_add_test(tc1_1, test_24);
+  tcase_add_test(tc1_1, test_25);
+  tcase_add_test(tc1_1, test_26);
+  tcase_add_test(tc1_1, test_27);
+  tcase_add_test(tc1_1, test_28);
+  tcase_add_test(tc1_1, test_29);
+  tcase_add_test(tc1_1, test_30);
+  tcase_add_test(tc1_1, test_31);
+  tcase_add_test(tc1_1, test_32);
+  tcase_add_test(tc1_1, test_33);
+  tcase_add_test(tc1_1, test_34);
+  tcase_add_test(tc1_1, test_35);
+  tcase_add_test(tc1_1, test_36);
+  tcase_add_test(tc1_1, test_37);
+  tcase_add_test(tc1_1, test_38);
+  tcase_add_test(tc1_1, test_39);
+  tcase_add_test(tc1_1, test_40);
+  tcase_add_test(tc1_1, test_41);
 
   srunner_set_fork_status(sr, CK_NOFORK);
   srunner_run_all(sr, CK_VERBOSE);
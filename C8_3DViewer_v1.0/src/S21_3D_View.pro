@@ -1,4 +1,4 @@
-QT       += core gui openglwidgets
+QT       += core gui openglwidgets concurrent
 
 greaterThan(QT_MAJOR_VERSION, 4): QT += widgets
 
@@ -12,8 +12,12 @@ CONFIG += c++17
 SOURCES += \
     main.cpp \
     mainwindow.cpp \
+    s21_3dviewer_binary.c \
+    s21_3dviewer_bvh.c \
     s21_3dviewer_matrix.c \
     s21_3dviewer_parser.c \
+    s21_3dviewer_scene.c \
+    s21_3dviewer_stats.c \
     view.cpp
 
 HEADERS += \
@@ -3,8 +3,11 @@
 #include <QColorDialog>
 #include <QFileDialog>
 #include <QMouseEvent>
+#include <QElapsedTimer>
 #include <QOpenGLWidget>
+#include <QShortcut>
 #include <QTimer>
+#include <QtConcurrent>
 #include <QtOpenGL>
 
 #include "ui_mainwindow.h"
@@ -17,15 +20,32 @@ MainWindow::MainWindow(QWidget *parent)
     timer = new QTimer;
     gifImage = new QImage[50]{};
     connect(timer, SIGNAL(timeout()), this, SLOT(slotTimer()));
+    connect(ui->openGLWidget, &View::elementPicked, this, &MainWindow::show_picked);
+    connect(new QShortcut(QKeySequence(Qt::Key_F3), this), &QShortcut::activated,
+            this, &MainWindow::toggle_stats);
+    connect(new QShortcut(QKeySequence("Ctrl+Shift+F"), this), &QShortcut::activated,
+            this, &MainWindow::save_stats);
+
+    watcher = new QFileSystemWatcher(this);
+    reload_timer = new QTimer(this);
+    reload_timer->setSingleShot(true);
+    reload_timer->setInterval(200);
+    connect(watcher, &QFileSystemWatcher::fileChanged, this, &MainWindow::model_file_changed);
+    connect(reload_timer, &QTimer::timeout, this, &MainWindow::start_reload);
+    connect(&reload_watcher, &QFutureWatcher<model_reload>::finished, this, &MainWindow::finish_reload);
+    connect(new QShortcut(QKeySequence(Qt::Key_F5), this), &QShortcut::activated,
+            this, &MainWindow::toggle_watch);
     this->settingFile = QApplication::applicationDirPath() + "/settings.conf";
 
     default_val();
 }
 
 MainWindow::~MainWindow() {
+    reload_watcher.waitForFinished();
     saveSettings();
     delete timer;
     delete[] gifImage;
+    bvh_free(&ui->openGLWidget->bvh);
     delete ui;
 }
 
@@ -90,32 +110,53 @@ void MainWindow::saveSettings() {
 void MainWindow::on_pushButton_clicked() {
   QString str;
   str = QFileDialog::getOpenFileName(this, "Выбрать файл",
-                                     "../../../../src/objects", "*.obj");
+                                     "../../../../src/objects",
+                                     "Модели (*.obj *.stl *.ply);;Сцены (*.scene)");
+  if (str.isEmpty()) return;
   std::string expression = str.toStdString();
   char *file = expression.data();
-
-  parseOBJFile(file, &(ui->openGLWidget->probe));
-  for (int i = 0; i < (*(ui->openGLWidget->probe)).vertexCount; i++)
-    printf("v: %d: %f %f %f\n", i, (*(ui->openGLWidget->probe)).vertices[i * 3],
-           (*(ui->openGLWidget->probe)).vertices[i * 3 + 1], (*(ui->openGLWidget->probe)).vertices[i * 3 + 2]);
-  for (int i = 0; i < (*(ui->openGLWidget->probe)).faceCount; i++) {
-    printf("f: %d:  count_number_vertex: %d ", i,
-           (*(ui->openGLWidget->probe)).faces[i].count_number_vertex);
-    for (int j = 0; j < (*(ui->openGLWidget->probe)).faces[i].count_number_vertex; j++)
-      printf(" %d", (*(ui->openGLWidget->probe)).faces[i].number_vertex[j]);
-    printf("\n");
-
+  bool is_scene = str.endsWith(".scene", Qt::CaseInsensitive);
+
+  // бинарные STL/PLY читаются напрямую из отображенного файла, без разбора текста
+  OBJData *model = NULL;
+  scene_t scene = {};
+  QElapsedTimer load_timer;
+  load_timer.start();
+  if ((is_scene ? parseSceneFile(file, &scene) : parseModelFile(file, &model)) != EXIT_SUCCESS) {
+    ui->info->setText("Не удалось открыть файл:\n" + str);
+    return;
   }
-  set_info(str, (*(ui->openGLWidget->probe)).vertexCount, (*(ui->openGLWidget->probe)).faceCount);
-
-  ui->openGLWidget->matrix_alt = matrix_alteration (ui->rotate_y->value() * COEFF_ROTATE,
-                                                    ui->rotate_y->value() * COEFF_ROTATE,
-                                                    ui->rotate_z->value() * COEFF_ROTATE,
-                                                    (ui->translate_x->value() - 50) * COEFF_SHIFT,
-                                                    (ui->translate_y->value() - 50) * COEFF_SHIFT,
-                                                    (ui->translate_z->value() - 50) * COEFF_SHIFT,
-                                                    ui->scale_value->value() * COEFF_PART * COEFF_SCALE / 50.0 / ui->openGLWidget->probe->maxVertexValue);
-  ui->openGLWidget->update();
+  // фоновый разбор читает текущую модель, дожидаемся его до освобождения
+  reload_watcher.waitForFinished();
+  model_generation++;
+  View *view = ui->openGLWidget;
+  if (view->probe != NULL) freeOBJData(view->probe);
+  view->probe = model;
+  scene_free(&view->scene);
+  view->scene = scene;
+  // BVH строится один раз при загрузке, выбор мышью проходит по ней
+  bvh_free(&view->bvh);
+  if (model != NULL) bvh_build(model, &view->bvh);
+  view->load_ms = load_timer.nsecsElapsed() / 1e6;
+  view->modelChanged();
+  view->sceneChanged();
+  view->picked_face = -1;
+  view->picked_vertex = -1;
+  modelFile = str;
+  update_watch();
+  if (model != NULL)
+    set_info(str, model->vertexCount, model->faceCount);
+  else
+    set_scene_info(str, scene);
+
+  view->matrix_alt = matrix_alteration (ui->rotate_y->value() * COEFF_ROTATE,
+                                        ui->rotate_y->value() * COEFF_ROTATE,
+                                        ui->rotate_z->value() * COEFF_ROTATE,
+                                        (ui->translate_x->value() - 50) * COEFF_SHIFT,
+                                        (ui->translate_y->value() - 50) * COEFF_SHIFT,
+                                        (ui->translate_z->value() - 50) * COEFF_SHIFT,
+                                        ui->scale_value->value() * COEFF_PART * COEFF_SCALE / 50.0 / view->maxVertexValue());
+  view->update();
 }
 
 void MainWindow::set_info(QString filename, int vertex, int face) {
@@ -127,6 +168,136 @@ void MainWindow::set_info(QString filename, int vertex, int face) {
         "\n Количество линий: " + QString::number(face));
 }
 
+void MainWindow::set_scene_info(QString filename, const scene_t &scene) {
+    // в сцене считаются вершины и грани всех экземпляров
+    int vertices = 0, faces = 0;
+    for (int i = 0; i < scene.instanceCount; i++) {
+        vertices += scene.meshes[scene.instances[i].mesh]->vertexCount;
+        faces += scene.meshes[scene.instances[i].mesh]->faceCount;
+    }
+    set_info(filename, vertices, faces);
+}
+
+void MainWindow::show_picked(int face, int vertex, float x, float y, float z) {
+    set_info(modelFile, ui->openGLWidget->probe->vertexCount, ui->openGLWidget->probe->faceCount);
+    ui->info->setText(ui->info->text() +
+        "\n\n Грань: " + QString::number(face + 1) +
+        "\n Вершина: " + QString::number(vertex + 1) +
+        "\n (" + QString::number(x) + ", " + QString::number(y) + ", " + QString::number(z) + ")");
+}
+
+void MainWindow::toggle_stats() {
+    ui->openGLWidget->show_stats = !ui->openGLWidget->show_stats;
+    ui->openGLWidget->update();
+}
+
+void MainWindow::save_stats() {
+    QString fileName = QFileDialog::getSaveFileName(
+        this, "Сохранить время кадров", "frames.csv", "CSV (*.csv)");
+    if (!fileName.isEmpty()) {
+        std::string name = fileName.toStdString();
+        if (frame_history_write_csv(&ui->openGLWidget->history, name.c_str()) != EXIT_SUCCESS)
+            ui->statusbar->showMessage("Не удалось сохранить " + fileName, 3000);
+    }
+}
+
+void MainWindow::toggle_watch() {
+    watch_mode = !watch_mode;
+    update_watch();
+    ui->statusbar->showMessage(watch_mode ? "Слежение за файлом включено"
+                                          : "Слежение за файлом выключено", 3000);
+}
+
+void MainWindow::update_watch() {
+    if (!watcher->files().isEmpty())
+        watcher->removePaths(watcher->files());
+    if (watch_mode && !modelFile.isEmpty())
+        watcher->addPath(modelFile);
+}
+
+void MainWindow::model_file_changed(const QString &path) {
+    // редакторы часто сохраняют через удаление и переименование
+    if (!watcher->files().contains(path) && QFile::exists(path))
+        watcher->addPath(path);
+    reload_timer->start();
+}
+
+void MainWindow::start_reload() {
+    if (reload_watcher.isRunning()) {
+        reload_pending = true;
+        return;
+    }
+    // сцена перечитывается целиком вместе со своими моделями
+    bool is_scene = modelFile.endsWith(".scene", Qt::CaseInsensitive);
+    if ((!is_scene && ui->openGLWidget->probe == NULL) || !QFile::exists(modelFile))
+        return;
+    std::string name = modelFile.toStdString();
+    const OBJData *previous = ui->openGLWidget->probe;
+    bool obj = !modelFile.endsWith(".stl", Qt::CaseInsensitive) &&
+               !modelFile.endsWith(".ply", Qt::CaseInsensitive);
+    int generation = model_generation;
+    reload_watcher.setFuture(QtConcurrent::run([name, previous, obj, is_scene, generation]() {
+        model_reload reload;
+        reload.generation = generation;
+        QElapsedTimer timer;
+        timer.start();
+        if (is_scene) {
+            reload.scene_loaded = parseSceneFile(name.c_str(), &reload.scene) == EXIT_SUCCESS;
+        } else {
+            int result = obj ? reparseOBJFile(name.c_str(), previous, &reload.model, &reload.incremental)
+                             : parseModelFile(name.c_str(), &reload.model);
+            if (result != EXIT_SUCCESS)
+                reload.model = nullptr;
+            else
+                bvh_build(reload.model, &reload.bvh);
+        }
+        reload.ms = timer.nsecsElapsed() / 1e6;
+        return reload;
+    }));
+}
+
+void MainWindow::finish_reload() {
+    model_reload reload = reload_watcher.result();
+    if (reload.generation != model_generation) {
+        // пока шел разбор, был открыт другой файл
+        if (reload.model != nullptr)
+            freeOBJData(reload.model);
+        bvh_free(&reload.bvh);
+        scene_free(&reload.scene);
+    } else if (reload.scene_loaded) {
+        View *view = ui->openGLWidget;
+        scene_free(&view->scene);
+        view->scene = reload.scene;
+        view->load_ms = reload.ms;
+        view->sceneChanged();
+        set_scene_info(modelFile, view->scene);
+        ui->statusbar->showMessage(
+            QString("Сцена перечитана за %1 мс").arg(reload.ms, 0, 'f', 1), 3000);
+        view->update();
+    } else if (reload.model != nullptr) {
+        View *view = ui->openGLWidget;
+        freeOBJData(view->probe);
+        bvh_free(&view->bvh);
+        view->probe = reload.model;
+        view->bvh = reload.bvh;
+        view->picked_face = -1;
+        view->picked_vertex = -1;
+        view->load_ms = reload.ms;
+        view->modelChanged();
+        // matrix_alt не пересчитывается, чтобы вид модели не сбрасывался
+        set_info(modelFile, view->probe->vertexCount, view->probe->faceCount);
+        ui->statusbar->showMessage(
+            QString(reload.incremental ? "Дочитан хвост файла за %1 мс"
+                                       : "Файл перечитан за %1 мс").arg(reload.ms, 0, 'f', 1),
+            3000);
+        view->update();
+    }
+    if (reload_pending) {
+        reload_pending = false;
+        start_reload();
+    }
+}
+
 void MainWindow::on_v_circle_clicked() {
   ui->openGLWidget->vert_type = CIRCLE;
   ui->openGLWidget->update();
@@ -224,79 +395,79 @@ void MainWindow::on_projection_currentIndexChanged(int index)
 }
 
 void MainWindow::on_rotate_x_valueChanged(int value) {
-    if (ui->openGLWidget->probe != NULL) {
+    if (ui->openGLWidget->hasModel()) {
         ui->openGLWidget->matrix_alt = matrix_alteration (value * COEFF_ROTATE,
                                                           ui->rotate_y->value() * COEFF_ROTATE,
                                                           ui->rotate_z->value() * COEFF_ROTATE,
                                                           (ui->translate_x->value() - 50) * COEFF_SHIFT,
                                                           (ui->translate_y->value() - 50) * COEFF_SHIFT,
                                                           (ui->translate_z->value() - 50) * COEFF_SHIFT,
-                                                          ui->scale_value->value() * COEFF_PART * COEFF_SCALE / 50.0 / ui->openGLWidget->probe->maxVertexValue);
+                                                          ui->scale_value->value() * COEFF_PART * COEFF_SCALE / 50.0 / ui->openGLWidget->maxVertexValue());
         ui->openGLWidget->update();
     }
 }
 
 void MainWindow::on_rotate_y_valueChanged(int value) {
-    if (ui->openGLWidget->probe != NULL) {
+    if (ui->openGLWidget->hasModel()) {
         ui->openGLWidget->matrix_alt = matrix_alteration (ui->rotate_x->value() * COEFF_ROTATE,
                                                           value * COEFF_ROTATE,
                                                           ui->rotate_z->value() * COEFF_ROTATE,
                                                           (ui->translate_x->value() - 50) * COEFF_SHIFT,
                                                           (ui->translate_y->value() - 50) * COEFF_SHIFT,
                                                           (ui->translate_z->value() - 50) * COEFF_SHIFT,
-                                                          ui->scale_value->value() * COEFF_PART * COEFF_SCALE / 50.0 / ui->openGLWidget->probe->maxVertexValue);
+                                                          ui->scale_value->value() * COEFF_PART * COEFF_SCALE / 50.0 / ui->openGLWidget->maxVertexValue());
         ui->openGLWidget->update();
     }
 }
 
 void MainWindow::on_rotate_z_valueChanged(int value) {
-    if (ui->openGLWidget->probe != NULL) {
+    if (ui->openGLWidget->hasModel()) {
         ui->openGLWidget->matrix_alt = matrix_alteration (ui->rotate_x->value() * COEFF_ROTATE,
                                                           ui->rotate_y->value() * COEFF_ROTATE,
                                                           value * COEFF_ROTATE,
                                                           (ui->translate_x->value() - 50) * COEFF_SHIFT,
                                                           (ui->translate_y->value() - 50) * COEFF_SHIFT,
                                                           (ui->translate_z->value() - 50) * COEFF_SHIFT,
-                                                          ui->scale_value->value() * COEFF_PART * COEFF_SCALE / 50.0 / ui->openGLWidget->probe->maxVertexValue);
+                                                          ui->scale_value->value() * COEFF_PART * COEFF_SCALE / 50.0 / ui->openGLWidget->maxVertexValue());
         ui->openGLWidget->update();
     }
 }
 
 void MainWindow::on_translate_x_valueChanged(int value) {
-    if (ui->openGLWidget->probe != NULL) {
+    if (ui->openGLWidget->hasModel()) {
         ui->openGLWidget->matrix_alt = matrix_alteration (ui->rotate_x->value() * COEFF_ROTATE,
                                                           ui->rotate_y->value() * COEFF_ROTATE,
                                                           ui->rotate_z->value() * COEFF_ROTATE,
                                                           (value - 50) * COEFF_SHIFT,
                                                           (ui->translate_y->value() - 50) * COEFF_SHIFT,
                                                           (ui->translate_z->value() - 50) * COEFF_SHIFT,
-                                                          ui->scale_value->value() * COEFF_PART * COEFF_SCALE / 50.0 / ui->openGLWidget->probe->maxVertexValue);
+                                                          ui->scale_value->value() * COEFF_PART * COEFF_SCALE / 50.0 / ui->openGLWidget->maxVertexValue());
         ui->openGLWidget->update();
     }
 }
 
 void MainWindow::on_translate_y_valueChanged(int value) {
-    if (ui->openGLWidget->probe != NULL) {
+    if (ui->openGLWidget->hasModel()) {
         ui->openGLWidget->matrix_alt = matrix_alteration (ui->rotate_x->value() * COEFF_ROTATE,
                                                           ui->rotate_y->value() * COEFF_ROTATE,
                                                           ui->rotate_z->value() * COEFF_ROTATE,
                                                           (ui->translate_x->value() - 50) * COEFF_SHIFT,
                                                           (value - 50) * COEFF_SHIFT,
                                                           (ui->translate_z->value() - 50) * COEFF_SHIFT,
-                                                          ui->scale_value->value() * COEFF_PART * COEFF_SCALE / 50.0 / ui->openGLWidget->probe->maxVertexValue);
+                                                          ui->scale_value->value() * COEFF_PART * COEFF_SCALE / 50.0 / ui->openGLWidget->maxVertexValue());
         ui->openGLWidget->update();
     }
 }
 
 void MainWindow::on_translate_z_valueChanged(int value) {
-    if (ui->openGLWidget->probe != NULL) {
+    if (ui->openGLWidget->hasModel()) {
         ui->openGLWidget->matrix_alt = matrix_alteration (ui->rotate_x->value() * COEFF_ROTATE,
                                                           ui->rotate_y->value() * COEFF_ROTATE,
                                                           ui->rotate_z->value() * COEFF_ROTATE,
                                                           (ui->translate_x->value() - 50) * COEFF_SHIFT,
                                                           (ui->translate_y->value() - 50) * COEFF_SHIFT,
                                                           (value - 50) * COEFF_SHIFT,
-                                                          ui->scale_value->value() * COEFF_PART * COEFF_SCALE / 50.0 / ui->openGLWidget->probe->maxVertexValue);
+                                                          ui->scale_value->value() * COEFF_PART * COEFF_SCALE / 50.0 / ui->openGLWidget->maxVertexValue());
         ui->openGLWidget->update();
     }
 }
@@ -309,14 +480,14 @@ void MainWindow::on_hsbWidth_valueChanged(int value)
 
 void MainWindow::on_scale_value_valueChanged(int value)
 {
-    if (ui->openGLWidget->probe != NULL) {
+    if (ui->openGLWidget->hasModel()) {
         ui->openGLWidget->matrix_alt = matrix_alteration (ui->rotate_x->value() * COEFF_ROTATE,
                                                           ui->rotate_y->value() * COEFF_ROTATE,
                                                           ui->rotate_z->value() * COEFF_ROTATE,
                                                           (ui->translate_x->value() - 50) * COEFF_SHIFT,
                                                           (ui->translate_y->value() - 50) * COEFF_SHIFT,
                                                           (ui->translate_z->value() - 50) * COEFF_SHIFT,
-                                                          value * COEFF_PART * COEFF_SCALE / 50.0 / ui->openGLWidget->probe->maxVertexValue);
+                                                          value * COEFF_PART * COEFF_SCALE / 50.0 / ui->openGLWidget->maxVertexValue());
         ui->openGLWidget->update();
     }
 }
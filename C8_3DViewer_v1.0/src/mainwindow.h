@@ -3,6 +3,8 @@
 
 #include <QMainWindow>
 #include <QFileDialog>
+#include <QFileSystemWatcher>
+#include <QFutureWatcher>
 #include "view.h"
 #include <QSettings>
 
@@ -12,6 +14,17 @@ extern "C" {
      #include "parser.h"
  }
 
+/// @brief Результат фоновой перезагрузки модели.
+struct model_reload {
+    OBJData *model = nullptr;  // новая модель или nullptr при ошибке
+    bvh_t bvh = {};            // BVH для новой модели
+    scene_t scene = {};        // новая сцена, если перечитан файл .scene
+    bool scene_loaded = false; // сцена разобрана без ошибок
+    int incremental = 0;       // разобран только дописанный хвост
+    double ms = 0;             // время разбора и построения BVH
+    int generation = 0;        // номер открытого файла на момент запуска
+};
+
 QT_BEGIN_NAMESPACE
 namespace Ui { class MainWindow; }
 QT_END_NAMESPACE
@@ -42,6 +55,35 @@ private slots:
     /// @param lines Количество линий.
     void set_info(QString filename, int verticles, int lines);
 
+    /// @brief Информация о файле сцены: вершины и линии всех экземпляров.
+    void set_scene_info(QString filename, const scene_t &scene);
+
+    /// @brief Дописывает к информации о файле выбранный элемент модели.
+    /// @param face Индекс грани.
+    /// @param vertex Индекс вершины.
+    /// @param x, y, z Координаты вершины.
+    void show_picked(int face, int vertex, float x, float y, float z);
+
+    /// @brief Включает и выключает оверлей со временем кадров (F3).
+    void toggle_stats();
+
+    /// @brief Сохраняет историю времени кадров в CSV (Ctrl+Shift+F).
+    void save_stats();
+
+    /// @brief Включает и выключает слежение за файлом модели (F5).
+    void toggle_watch();
+
+    /// @brief Откладывает перезагрузку, пока редактор дописывает файл.
+    void model_file_changed(const QString &path);
+
+    /// @brief Запускает разбор измененного файла модели или сцены в фоновом
+    /// потоке.
+    void start_reload();
+
+    /// @brief Подменяет модель или сцену результатом разбора, не трогая
+    /// преобразования.
+    void finish_reload();
+
     /// @brief Обработчик события нажатия на кнопку "ОК".
     void on_pushButton_clicked();
 
@@ -128,6 +170,16 @@ private:
     Ui::MainWindow *ui;
 
     QString settingFile;
+    QString modelFile;
+    QFileSystemWatcher *watcher;
+    QTimer *reload_timer;
+    QFutureWatcher<model_reload> reload_watcher;
+    bool watch_mode = false;
+    bool reload_pending = false;
+    int model_generation = 0;
+
+    /// @brief Переставляет слежение на текущий файл модели.
+    void update_watch();
     QTimer *timer;
     QGifImage *gif;
     QImage *gifImage;
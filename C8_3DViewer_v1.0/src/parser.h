@@ -7,12 +7,24 @@
 #include <string.h>
 
 #define EPS 1e-07
+#define OBJ_MARK_BYTES 65536
 
 typedef struct face_t {
   int* number_vertex;       // массив индексов вершин
   int count_number_vertex;  // количество вершин в полигоне
 } face;
 
+/// @brief Состояние разбора OBJ на последней полной строке файла.
+typedef struct {
+  long bytes;            // длина разобранной части файла в байтах
+  unsigned long hash;    // FNV-1a хеш разобранной части
+  int vertexCount;       // количество вершин на этот момент
+  int faceCount;         // количество граней на этот момент
+  float maxVertexValue;  // максимум координат на этот момент
+  long pendingBytes;     // прочитано байт всего, включая неполную строку
+  unsigned long pendingHash;  // хеш всего прочитанного
+} obj_checkpoint;
+
 typedef struct {
   int vertexCount;  // количество вершин
   float* vertices;  // массив вершин (x, y, z)
@@ -20,8 +32,61 @@ typedef struct {
   int faceCount;    // количество граней
   float maxVertexValue;  // максимальное значение среди всех вершин
   int maxFaceValue;  // максимальное значение среди всех граней
+  int* indices;  // общий массив индексов граней (бинарные форматы) или NULL
+  obj_checkpoint checkpoint;  // где остановился разбор OBJ
+  obj_checkpoint* marks;  // состояния разбора OBJ примерно через каждые
+                          // OBJ_MARK_BYTES байт, по возрастанию bytes
+  int markCount;          // количество сохраненных состояний
 } OBJData;
 
+/// @brief Узел иерархии ограничивающих объемов (BVH) над гранями.
+typedef struct {
+  float min[3];  // нижний угол AABB
+  float max[3];  // верхний угол AABB
+  int left;      // индекс левого потомка, -1 у листа
+  int right;     // индекс правого потомка, -1 у листа
+  int first;     // начало диапазона граней листа в bvh_t::order
+  int count;     // количество граней листа, 0 у внутреннего узла
+} bvh_node;
+
+typedef struct {
+  bvh_node* nodes;  // массив узлов, корень - nodes[0]
+  int nodeCount;    // количество узлов
+  int* order;       // индексы граней, сгруппированные по листьям
+  int faceCount;    // количество граней в иерархии
+} bvh_t;
+
+typedef struct {
+  int face;        // индекс выбранной грани (с нуля) или -1
+  int vertex;      // индекс ближайшей к попаданию вершины (с нуля) или -1
+  float t;         // параметр луча в точке попадания
+  float point[3];  // точка попадания в координатах модели
+} pick_result;
+
+/// @brief Этапы кадра, для которых измеряется время.
+typedef enum {
+  STAGE_UPLOAD,     // подготовка буферов ребер после смены модели
+  STAGE_TRANSFORM,  // преобразование вершин матрицей matrix_alt
+  STAGE_DRAW,       // выдача команд отрисовки
+  STAGE_READBACK,   // ожидание завершения кадра на GPU (glFinish)
+  FRAME_STAGES
+} frame_stage;
+
+typedef struct {
+  double cpu_ms[FRAME_STAGES];  // время CPU по этапам, мс
+  double gpu_ms[FRAME_STAGES];  // время GPU по этапам, мс, -1 если нет
+  double total_ms;              // полное время paintGL, мс
+} frame_record;
+
+/// @brief Кольцевая история времени кадров.
+typedef struct {
+  frame_record* records;  // кольцевой буфер
+  int capacity;           // размер буфера
+  int count;              // количество записей в буфере
+  int head;               // позиция следующей записи
+  long frames;            // всего записанных кадров
+} frame_history;
+
 typedef enum {
   OK = 0,                // корректная матрица
   INCORRECT_MATRIX = 1,  // ошибка в матрице
@@ -35,6 +100,21 @@ typedef struct matrix_struct {
   matrix_type_t matrix_type;
 } matrix_t;
 
+/// @brief Экземпляр модели в сцене.
+typedef struct {
+  int mesh;            // индекс модели в scene_t::meshes
+  matrix_t transform;  // собственное преобразование 4x4 (владеет сцена)
+} scene_instance;
+
+/// @brief Сцена из нескольких моделей, каждая может повторяться много раз.
+typedef struct {
+  OBJData** meshes;           // загруженные модели (владеет сцена)
+  int meshCount;              // количество моделей
+  scene_instance* instances;  // экземпляры моделей
+  int instanceCount;          // количество экземпляров
+  int instanceCapacity;       // размер массива instances
+} scene_t;
+
 /// @brief Инициализация структуры OBJData.
 /// @param objData Указатель на указатель на структуру OBJData.
 void initializeOBJData(OBJData** objData);
@@ -47,6 +127,108 @@ void initializeOBJData(OBJData** objData);
 /// ошибки.
 int parseOBJFile(const char* filename, OBJData** objData);
 
+/// @brief Повторный разбор OBJ после изменения файла. Начало файла
+/// сравнивается с сохраненными состояниями previous; previous копируется до
+/// последнего состояния, после которого файл не менялся (при дописывании в
+/// конец - до последней полной строки), и разбирается только остаток. Если
+/// изменено самое начало, файл разбирается заново.
+/// @param filename Имя файла.
+/// @param previous Предыдущий результат разбора этого файла или NULL.
+/// @param objData Указатель на новую структуру OBJData.
+/// @param incremental 1, если разобран только хвост файла.
+/// @return EXIT_SUCCESS или EXIT_FAILURE (в этом случае *objData == NULL).
+int reparseOBJFile(const char* filename, const OBJData* previous,
+                   OBJData** objData, int* incremental);
+
+/// @brief Чтение бинарного STL через отображение файла в память.
+/// @param filename Имя файла.
+/// @param objData Указатель на указатель на структуру OBJData.
+/// @return EXIT_SUCCESS или EXIT_FAILURE (в этом случае *objData == NULL).
+int parseSTLFile(const char* filename, OBJData** objData);
+
+/// @brief Чтение бинарного PLY (little/big endian) через отображение файла в
+/// память.
+/// @param filename Имя файла.
+/// @param objData Указатель на указатель на структуру OBJData.
+/// @return EXIT_SUCCESS или EXIT_FAILURE (в этом случае *objData == NULL).
+int parsePLYFile(const char* filename, OBJData** objData);
+
+/// @brief Выбирает парсер по расширению файла (.stl, .ply, иначе OBJ).
+/// @param filename Имя файла.
+/// @param objData Указатель на указатель на структуру OBJData.
+/// @return Код возврата выбранного парсера.
+int parseModelFile(const char* filename, OBJData** objData);
+
+/// @brief Построение BVH над гранями модели (медианное разбиение).
+/// @param objData Модель.
+/// @param bvh Заполняемая иерархия.
+/// @return EXIT_SUCCESS или EXIT_FAILURE, если граней нет.
+int bvh_build(const OBJData* objData, bvh_t* bvh);
+
+/// @brief Освобождение памяти, выделенной под BVH.
+void bvh_free(bvh_t* bvh);
+
+/// @brief Поиск ближайшей грани, пересекаемой лучом origin + t * dir, t >= 0.
+/// @param bvh Иерархия, построенная для objData.
+/// @param objData Модель.
+/// @param origin Начало луча в координатах модели.
+/// @param dir Направление луча в координатах модели.
+/// @param result Выбранная грань, ближайшая вершина и точка попадания.
+/// @return EXIT_SUCCESS при попадании, иначе EXIT_FAILURE.
+int bvh_pick(const bvh_t* bvh, const OBJData* objData, const float* origin,
+             const float* dir, pick_result* result);
+
+/// @brief Создание истории кадров на capacity записей.
+int frame_history_init(frame_history* history, int capacity);
+
+/// @brief Освобождение истории кадров.
+void frame_history_free(frame_history* history);
+
+/// @brief Добавление кадра, при заполнении вытесняется самый старый.
+void frame_history_push(frame_history* history, const frame_record* record);
+
+/// @brief Кадр по порядку от самого старого (i = 0) или NULL.
+const frame_record* frame_history_at(const frame_history* history, int i);
+
+/// @brief Среднее по всем кадрам истории.
+void frame_history_average(const frame_history* history, frame_record* out);
+
+/// @brief Имя этапа кадра для вывода.
+const char* frame_stage_name(int stage);
+
+/// @brief Выгрузка истории кадров в CSV.
+/// @return EXIT_SUCCESS или EXIT_FAILURE при ошибке записи.
+int frame_history_write_csv(const frame_history* history,
+                            const char* filename);
+
+/// @brief Инициализация пустой сцены.
+void scene_init(scene_t* scene);
+
+/// @brief Освобождение сцены вместе с моделями и матрицами экземпляров.
+void scene_free(scene_t* scene);
+
+/// @brief Добавление модели в сцену, сцена становится ее владельцем.
+/// @return Индекс модели или -1.
+int scene_add_mesh(scene_t* scene, OBJData* mesh);
+
+/// @brief Добавление экземпляра модели, сцена становится владельцем матрицы.
+/// @return Индекс экземпляра или -1 (матрица при этом освобождается).
+int scene_add_instance(scene_t* scene, int mesh, matrix_t transform);
+
+/// @brief Матрицы экземпляров модели mesh по столбцам, по 16 чисел на
+/// экземпляр.
+/// @param out Массив для матриц или NULL, чтобы только посчитать экземпляры.
+/// @return Количество экземпляров модели.
+int scene_instance_matrices(const scene_t* scene, int mesh, float* out);
+
+/// @brief Максимальная координата сцены с учетом преобразований экземпляров.
+float scene_max_value(const scene_t* scene);
+
+/// @brief Чтение файла сцены: строки "m <путь к модели>" и
+/// "i <модель> <dx dy dz> <ax ay az> <масштаб>".
+/// @return EXIT_SUCCESS или EXIT_FAILURE (сцена при этом пуста).
+int parseSceneFile(const char* filename, scene_t* scene);
+
 /// @brief Освобождение памяти, выделенной под структуру OBJData.
 /// @param objData Указатель на структуру OBJData, которую нужно освободить.
 void freeOBJData(OBJData* objData);
@@ -63,6 +245,10 @@ matrix_t s21_mult_matrix(matrix_t* A, matrix_t* B);
 
 int s21_correct_matrix(matrix_t* A);
 
+/// @brief Обратная матрица (метод Гаусса - Жордана), для вырожденной -
+/// INCORRECT_MATRIX.
+matrix_t s21_inverse_matrix(matrix_t* A);
+
 /// @brief Проверка равенства двух матриц A и B.
 int s21_eq_matrix(matrix_t* A, matrix_t* B);
 
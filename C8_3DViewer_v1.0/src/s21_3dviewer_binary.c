@@ -0,0 +1,481 @@
+#include <ctype.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <stdint.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "parser.h"
+
+#define STL_HEADER_SIZE 80
+#define STL_TRIANGLE_SIZE 50
+#define PLY_MAX_PROPERTIES 32
+
+typedef struct {
+  const unsigned char* data;  // отображенный в память файл
+  size_t size;                // размер файла в байтах
+} mapped_file;
+
+typedef enum {
+  PLY_NONE,
+  PLY_INT8,
+  PLY_UINT8,
+  PLY_INT16,
+  PLY_UINT16,
+  PLY_INT32,
+  PLY_UINT32,
+  PLY_FLOAT32,
+  PLY_FLOAT64
+} ply_type;
+
+typedef struct {
+  ply_type type;        // тип скалярного свойства (или индексов списка)
+  ply_type count_type;  // тип счетчика списка, PLY_NONE для скаляра
+  int role;             // 0 - x, 1 - y, 2 - z, 3 - индексы граней, -1 - прочее
+} ply_property;
+
+typedef struct {
+  long count;
+  int property_count;
+  ply_property properties[PLY_MAX_PROPERTIES];
+} ply_element;
+
+static int map_file(const char* filename, mapped_file* file) {
+  int result = EXIT_FAILURE;
+  int fd = open(filename, O_RDONLY);
+  if (fd >= 0) {
+    struct stat st;
+    if (fstat(fd, &st) == 0 && st.st_size > 0) {
+      void* data = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+      if (data != MAP_FAILED) {
+        file->data = data;
+        file->size = st.st_size;
+        result = EXIT_SUCCESS;
+      }
+    }
+    close(fd);
+  }
+  return result;
+}
+
+static void unmap_file(mapped_file* file) {
+  munmap((void*)file->data, file->size);
+}
+
+static int host_is_little_endian(void) {
+  const uint16_t probe = 1;
+  return *(const unsigned char*)&probe == 1;
+}
+
+static void read_bytes(const unsigned char* src, void* dst, size_t n,
+                       int swap) {
+  unsigned char* out = dst;
+  for (size_t i = 0; i < n; i++) out[i] = swap ? src[n - 1 - i] : src[i];
+}
+
+static void update_max_vertex(OBJData* objData, const float* v) {
+  float maxCoord =
+      v[0] > v[1] ? (v[0] > v[2] ? v[0] : v[2]) : (v[1] > v[2] ? v[1] : v[2]);
+  if (maxCoord > objData->maxVertexValue) objData->maxVertexValue = maxCoord;
+}
+
+/// @brief Выделяет общий массив индексов и раздает его граням.
+static int allocate_faces(OBJData* objData, long faceCount, long indexCount) {
+  objData->faces = calloc(faceCount > 0 ? faceCount : 1, sizeof(face));
+  objData->indices = calloc(indexCount > 0 ? indexCount : 1, sizeof(int));
+  return objData->faces != NULL && objData->indices != NULL ? EXIT_SUCCESS
+                                                            : EXIT_FAILURE;
+}
+
+int parseSTLFile(const char* filename, OBJData** objData) {
+  initializeOBJData(objData);
+
+  mapped_file file;
+  if (map_file(filename, &file) != EXIT_SUCCESS) {
+    freeOBJData(*objData);
+    *objData = NULL;
+    return EXIT_FAILURE;
+  }
+
+  int result = EXIT_FAILURE;
+  int swap = !host_is_little_endian();
+  uint32_t count = 0;
+  if (file.size >= STL_HEADER_SIZE + sizeof(count)) {
+    read_bytes(file.data + STL_HEADER_SIZE, &count, sizeof(count), swap);
+  }
+  // ASCII STL тоже начинается со "solid", поэтому формат проверяется по размеру
+  if (file.size >= STL_HEADER_SIZE + sizeof(count) &&
+      file.size ==
+          STL_HEADER_SIZE + sizeof(count) + (size_t)count * STL_TRIANGLE_SIZE &&
+      allocate_faces(*objData, count, (long)count * 3) == EXIT_SUCCESS &&
+      ((*objData)->vertices = malloc(sizeof(float) * 9 * (count ? count : 1)))) {
+    const unsigned char* triangle =
+        file.data + STL_HEADER_SIZE + sizeof(count);
+    float* vertex = (*objData)->vertices;
+    for (uint32_t i = 0; i < count; i++, triangle += STL_TRIANGLE_SIZE) {
+      // пропускаем нормаль, копируем три вершины подряд
+      if (swap) {
+        for (int k = 0; k < 9; k++)
+          read_bytes(triangle + 12 + k * 4, vertex + k, 4, swap);
+      } else {
+        memcpy(vertex, triangle + 12, sizeof(float) * 9);
+      }
+      for (int k = 0; k < 3; k++) {
+        update_max_vertex(*objData, vertex + k * 3);
+        (*objData)->indices[i * 3 + k] = i * 3 + k + 1;
+      }
+      (*objData)->faces[i].number_vertex = (*objData)->indices + i * 3;
+      (*objData)->faces[i].count_number_vertex = 3;
+      vertex += 9;
+    }
+    (*objData)->vertexCount = count * 3;
+    (*objData)->faceCount = count;
+    result = EXIT_SUCCESS;
+  }
+
+  unmap_file(&file);
+  if (result != EXIT_SUCCESS) {
+    freeOBJData(*objData);
+    *objData = NULL;
+  }
+  return result;
+}
+
+static ply_type ply_type_from_name(const char* name) {
+  ply_type type = PLY_NONE;
+  if (!strcmp(name, "char") || !strcmp(name, "int8"))
+    type = PLY_INT8;
+  else if (!strcmp(name, "uchar") || !strcmp(name, "uint8"))
+    type = PLY_UINT8;
+  else if (!strcmp(name, "short") || !strcmp(name, "int16"))
+    type = PLY_INT16;
+  else if (!strcmp(name, "ushort") || !strcmp(name, "uint16"))
+    type = PLY_UINT16;
+  else if (!strcmp(name, "int") || !strcmp(name, "int32"))
+    type = PLY_INT32;
+  else if (!strcmp(name, "uint") || !strcmp(name, "uint32"))
+    type = PLY_UINT32;
+  else if (!strcmp(name, "float") || !strcmp(name, "float32"))
+    type = PLY_FLOAT32;
+  else if (!strcmp(name, "double") || !strcmp(name, "float64"))
+    type = PLY_FLOAT64;
+  return type;
+}
+
+static size_t ply_type_size(ply_type type) {
+  static const size_t sizes[] = {0, 1, 1, 2, 2, 4, 4, 4, 8};
+  return sizes[type];
+}
+
+static double ply_read_value(const unsigned char* src, ply_type type,
+                             int swap) {
+  double value = 0;
+  union {
+    int8_t i8;
+    uint8_t u8;
+    int16_t i16;
+    uint16_t u16;
+    int32_t i32;
+    uint32_t u32;
+    float f32;
+    double f64;
+  } raw;
+  read_bytes(src, &raw, ply_type_size(type), swap);
+  switch (type) {
+    case PLY_INT8:
+      value = raw.i8;
+      break;
+    case PLY_UINT8:
+      value = raw.u8;
+      break;
+    case PLY_INT16:
+      value = raw.i16;
+      break;
+    case PLY_UINT16:
+      value = raw.u16;
+      break;
+    case PLY_INT32:
+      value = raw.i32;
+      break;
+    case PLY_UINT32:
+      value = raw.u32;
+      break;
+    case PLY_FLOAT32:
+      value = raw.f32;
+      break;
+    case PLY_FLOAT64:
+      value = raw.f64;
+      break;
+    case PLY_NONE:
+      break;
+  }
+  return value;
+}
+
+/// @brief Размер записи элемента без списков, 0 если в элементе есть списки.
+static size_t ply_fixed_stride(const ply_element* element) {
+  size_t stride = 0;
+  for (int i = 0; i < element->property_count && stride != (size_t)-1; i++) {
+    if (element->properties[i].count_type != PLY_NONE)
+      stride = (size_t)-1;
+    else
+      stride += ply_type_size(element->properties[i].type);
+  }
+  return stride == (size_t)-1 ? 0 : stride;
+}
+
+/// @brief Наименьший размер записи: скаляры и счетчики пустых списков.
+static size_t ply_min_stride(const ply_element* element) {
+  size_t stride = 0;
+  for (int i = 0; i < element->property_count; i++) {
+    const ply_property* property = &element->properties[i];
+    stride += ply_type_size(property->count_type != PLY_NONE
+                                ? property->count_type
+                                : property->type);
+  }
+  return stride;
+}
+
+/// @brief Проверяет число записей до любых умножений: записи должны
+/// поместиться в остаток файла, а их число - в int полей OBJData.
+static int ply_count_fits(const mapped_file* file, size_t offset,
+                          const ply_element* element, size_t stride) {
+  return stride > 0 && element->count >= 0 && element->count <= INT_MAX &&
+         offset <= file->size &&
+         (size_t)element->count <= (file->size - offset) / stride;
+}
+
+/// @brief В элементе граней должен быть список индексов вершин.
+static int ply_has_indices(const ply_element* element) {
+  int found = 0;
+  for (int i = 0; i < element->property_count; i++)
+    found = found || element->properties[i].role == 3;
+  return found;
+}
+
+/// @brief Разбирает текстовый заголовок PLY.
+/// @return Смещение начала бинарных данных или 0 при ошибке.
+static size_t ply_parse_header(const mapped_file* file, ply_element* vertex,
+                               ply_element* face, int* swap) {
+  size_t offset = 0;
+  int format_ok = 0, order_ok = 1, done = 0;
+  ply_element* current = NULL;
+  char line[256];
+
+  if (file->size < 4 || memcmp(file->data, "ply", 3)) return 0;
+  while (!done && offset < file->size) {
+    size_t len = 0;
+    while (offset + len < file->size && file->data[offset + len] != '\n') len++;
+    if (offset + len >= file->size) break;
+    size_t copy = len < sizeof(line) - 1 ? len : sizeof(line) - 1;
+    memcpy(line, file->data + offset, copy);
+    line[copy] = '\0';
+    if (copy > 0 && line[copy - 1] == '\r') line[copy - 1] = '\0';
+    offset += len + 1;
+
+    char word[3][32] = {{0}};
+    char type_name[32] = {0};
+    int words = sscanf(line, "%31s %31s %31s", word[0], word[1], word[2]);
+    if (words < 1) continue;
+    if (!strcmp(word[0], "format")) {
+      if (!strcmp(word[1], "binary_little_endian")) {
+        format_ok = 1;
+        *swap = !host_is_little_endian();
+      } else if (!strcmp(word[1], "binary_big_endian")) {
+        format_ok = 1;
+        *swap = host_is_little_endian();
+      }
+    } else if (!strcmp(word[0], "element") && words == 3) {
+      long count = atol(word[2]);
+      if (!strcmp(word[1], "vertex")) {
+        current = vertex;
+      } else if (!strcmp(word[1], "face")) {
+        current = face;
+        order_ok = vertex->count >= 0;
+      } else {
+        // прочие элементы допустимы только после вершин и граней
+        current = NULL;
+        order_ok = order_ok && vertex->count >= 0 && face->count >= 0;
+      }
+      if (current) current->count = count;
+    } else if (!strcmp(word[0], "property") && current &&
+               current->property_count < PLY_MAX_PROPERTIES) {
+      ply_property* property = &current->properties[current->property_count++];
+      property->role = -1;
+      property->count_type = PLY_NONE;
+      if (!strcmp(word[1], "list")) {
+        char name[32] = {0};
+        sscanf(line, "%*s %*s %*s %31s %31s", type_name, name);
+        property->count_type = ply_type_from_name(word[2]);
+        property->type = ply_type_from_name(type_name);
+        if (current == face && (!strcmp(name, "vertex_indices") ||
+                                !strcmp(name, "vertex_index")))
+          property->role = 3;
+        if (property->count_type == PLY_NONE || property->type == PLY_NONE)
+          order_ok = 0;
+      } else {
+        property->type = ply_type_from_name(word[1]);
+        if (property->type == PLY_NONE) order_ok = 0;
+        if (current == vertex && word[2][1] == '\0' && word[2][0] >= 'x' &&
+            word[2][0] <= 'z')
+          property->role = word[2][0] - 'x';
+      }
+    } else if (!strcmp(word[0], "end_header")) {
+      done = 1;
+    }
+  }
+  return done && format_ok && order_ok && vertex->count >= 0 ? offset : 0;
+}
+
+static int ply_read_vertices(const mapped_file* file, size_t* offset,
+                             const ply_element* element, OBJData* objData,
+                             int swap) {
+  size_t stride = ply_fixed_stride(element);
+  int result = ply_count_fits(file, *offset, element, stride) ? EXIT_SUCCESS
+                                                              : EXIT_FAILURE;
+  if (result == EXIT_SUCCESS) {
+    objData->vertices = calloc(element->count > 0 ? element->count * 3 : 1,
+                               sizeof(float));
+    if (objData->vertices == NULL) result = EXIT_FAILURE;
+  }
+  if (result == EXIT_SUCCESS) {
+    const unsigned char* record = file->data + *offset;
+    int plain = !swap && element->property_count == 3 && stride == 12;
+    for (int i = 0; i < 3; i++)
+      plain = plain && element->properties[i].role == i &&
+              element->properties[i].type == PLY_FLOAT32;
+    if (plain) {
+      // раскладка совпадает с OBJData: копируем блок целиком
+      memcpy(objData->vertices, record, stride * element->count);
+    } else {
+      for (long i = 0; i < element->count; i++, record += stride) {
+        size_t field = 0;
+        for (int p = 0; p < element->property_count; p++) {
+          const ply_property* property = &element->properties[p];
+          if (property->role >= 0 && property->role < 3)
+            objData->vertices[i * 3 + property->role] =
+                ply_read_value(record + field, property->type, swap);
+          field += ply_type_size(property->type);
+        }
+      }
+    }
+    for (long i = 0; i < element->count; i++)
+      update_max_vertex(objData, objData->vertices + i * 3);
+    objData->vertexCount = element->count;
+    *offset += stride * element->count;
+  }
+  return result;
+}
+
+/// @brief Пробегает по граням, считает индексы и, если out != NULL, заполняет
+/// их.
+static int ply_walk_faces(const mapped_file* file, size_t offset,
+                          const ply_element* element, OBJData* out,
+                          long* indexCount, int swap) {
+  int result = EXIT_SUCCESS;
+  long written = 0;
+  for (long i = 0; i < element->count && result == EXIT_SUCCESS; i++) {
+    for (int p = 0; p < element->property_count && result == EXIT_SUCCESS;
+         p++) {
+      const ply_property* property = &element->properties[p];
+      size_t value_size = ply_type_size(property->type);
+      if (property->count_type == PLY_NONE) {
+        offset += value_size;
+        if (offset > file->size) result = EXIT_FAILURE;
+        continue;
+      }
+      size_t count_size = ply_type_size(property->count_type);
+      if (offset + count_size > file->size) {
+        result = EXIT_FAILURE;
+        break;
+      }
+      long n = (long)ply_read_value(file->data + offset, property->count_type,
+                                    swap);
+      offset += count_size;
+      if (n < 0 || (size_t)n > (file->size - offset) / value_size) {
+        result = EXIT_FAILURE;
+        break;
+      }
+      if (property->role == 3) {
+        if (out != NULL) {
+          out->faces[i].number_vertex = out->indices + written;
+          out->faces[i].count_number_vertex = n;
+          for (long k = 0; k < n; k++) {
+            int index = (int)ply_read_value(
+                file->data + offset + k * value_size, property->type, swap);
+            // PLY нумерует с нуля, OBJ - с единицы
+            out->indices[written + k] = index + 1;
+            if (index < 0 || index >= out->vertexCount) result = EXIT_FAILURE;
+          }
+        }
+        written += n;
+      }
+      offset += n * value_size;
+    }
+  }
+  *indexCount = written;
+  return result;
+}
+
+int parsePLYFile(const char* filename, OBJData** objData) {
+  initializeOBJData(objData);
+
+  mapped_file file;
+  if (map_file(filename, &file) != EXIT_SUCCESS) {
+    freeOBJData(*objData);
+    *objData = NULL;
+    return EXIT_FAILURE;
+  }
+
+  ply_element vertex = {.count = -1}, face = {.count = -1};
+  int swap = 0;
+  int result = EXIT_FAILURE;
+  size_t offset = ply_parse_header(&file, &vertex, &face, &swap);
+  if (offset > 0 &&
+      ply_read_vertices(&file, &offset, &vertex, *objData, swap) ==
+          EXIT_SUCCESS) {
+    long indexCount = 0;
+    if (face.count <= 0) {
+      result = EXIT_SUCCESS;
+    } else if (ply_has_indices(&face) &&
+               ply_count_fits(&file, offset, &face, ply_min_stride(&face)) &&
+               ply_walk_faces(&file, offset, &face, NULL, &indexCount, swap) ==
+                   EXIT_SUCCESS &&
+               allocate_faces(*objData, face.count, indexCount) ==
+                   EXIT_SUCCESS) {
+      (*objData)->faceCount = face.count;
+      result =
+          ply_walk_faces(&file, offset, &face, *objData, &indexCount, swap);
+    }
+  }
+
+  unmap_file(&file);
+  if (result != EXIT_SUCCESS) {
+    freeOBJData(*objData);
+    *objData = NULL;
+  }
+  return result;
+}
+
+static int has_extension(const char* filename, const char* extension) {
+  int result = 0;
+  const char* dot = strrchr(filename, '.');
+  if (dot != NULL && strlen(dot + 1) == strlen(extension)) {
+    result = 1;
+    for (int i = 0; dot[i + 1] && result; i++)
+      result = tolower((unsigned char)dot[i + 1]) == extension[i];
+  }
+  return result;
+}
+
+int parseModelFile(const char* filename, OBJData** objData) {
+  int result;
+  if (has_extension(filename, "stl"))
+    result = parseSTLFile(filename, objData);
+  else if (has_extension(filename, "ply"))
+    result = parsePLYFile(filename, objData);
+  else
+    result = parseOBJFile(filename, objData);
+  return result;
+}
@@ -0,0 +1,258 @@
+#include <float.h>
+
+#include "parser.h"
+
+#define BVH_LEAF_SIZE 4
+#define BVH_STACK_SIZE 64
+
+typedef struct {
+  float min[3];
+  float max[3];
+  float centroid[3];
+} face_bounds;
+
+static int face_vertex(const OBJData* objData, const face* f, int j) {
+  int index = f->number_vertex[j] - 1;
+  return index >= 0 && index < objData->vertexCount ? index : -1;
+}
+
+static void compute_face_bounds(const OBJData* objData, int i,
+                                face_bounds* b) {
+  const face* f = &objData->faces[i];
+  for (int k = 0; k < 3; k++) {
+    b->min[k] = FLT_MAX;
+    b->max[k] = -FLT_MAX;
+  }
+  for (int j = 0; j < f->count_number_vertex; j++) {
+    int index = face_vertex(objData, f, j);
+    if (index < 0) continue;
+    for (int k = 0; k < 3; k++) {
+      float v = objData->vertices[index * 3 + k];
+      if (v < b->min[k]) b->min[k] = v;
+      if (v > b->max[k]) b->max[k] = v;
+    }
+  }
+  for (int k = 0; k < 3; k++) b->centroid[k] = (b->min[k] + b->max[k]) / 2;
+}
+
+/// @brief Частичная сортировка: order[mid] встает на свое место по оси axis.
+static void select_median(int* order, const face_bounds* bounds, int first,
+                          int last, int mid, int axis) {
+  while (first < last) {
+    float pivot = bounds[order[(first + last) / 2]].centroid[axis];
+    int i = first, j = last;
+    while (i <= j) {
+      while (bounds[order[i]].centroid[axis] < pivot) i++;
+      while (bounds[order[j]].centroid[axis] > pivot) j--;
+      if (i <= j) {
+        int tmp = order[i];
+        order[i++] = order[j];
+        order[j--] = tmp;
+      }
+    }
+    if (mid <= j)
+      last = j;
+    else if (mid >= i)
+      first = i;
+    else
+      break;
+  }
+}
+
+static int build_node(bvh_t* bvh, const face_bounds* bounds, int first,
+                      int count) {
+  int id = bvh->nodeCount++;
+  bvh_node* node = &bvh->nodes[id];
+  float cmin[3], cmax[3];
+  for (int k = 0; k < 3; k++) {
+    node->min[k] = cmin[k] = FLT_MAX;
+    node->max[k] = cmax[k] = -FLT_MAX;
+  }
+  for (int i = first; i < first + count; i++) {
+    const face_bounds* b = &bounds[bvh->order[i]];
+    for (int k = 0; k < 3; k++) {
+      if (b->min[k] < node->min[k]) node->min[k] = b->min[k];
+      if (b->max[k] > node->max[k]) node->max[k] = b->max[k];
+      if (b->centroid[k] < cmin[k]) cmin[k] = b->centroid[k];
+      if (b->centroid[k] > cmax[k]) cmax[k] = b->centroid[k];
+    }
+  }
+  node->first = first;
+  node->count = count;
+  node->left = node->right = -1;
+  if (count > BVH_LEAF_SIZE) {
+    int axis = 0;
+    for (int k = 1; k < 3; k++)
+      if (cmax[k] - cmin[k] > cmax[axis] - cmin[axis]) axis = k;
+    int half = count / 2;
+    select_median(bvh->order, bounds, first, first + count - 1, first + half,
+                  axis);
+    // после рекурсии указатель node может устареть, поэтому работаем по id
+    int left = build_node(bvh, bounds, first, half);
+    int right = build_node(bvh, bounds, first + half, count - half);
+    bvh->nodes[id].left = left;
+    bvh->nodes[id].right = right;
+    bvh->nodes[id].count = 0;
+  }
+  return id;
+}
+
+int bvh_build(const OBJData* objData, bvh_t* bvh) {
+  bvh->nodes = NULL;
+  bvh->order = NULL;
+  bvh->nodeCount = 0;
+  bvh->faceCount = 0;
+  if (objData == NULL || objData->faceCount <= 0) return EXIT_FAILURE;
+
+  int result = EXIT_FAILURE;
+  int n = objData->faceCount;
+  face_bounds* bounds = malloc(sizeof(face_bounds) * n);
+  bvh->order = malloc(sizeof(int) * n);
+  // медианное разбиение дает не больше 2n - 1 узлов
+  bvh->nodes = malloc(sizeof(bvh_node) * (2 * n - 1));
+  if (bounds && bvh->order && bvh->nodes) {
+    for (int i = 0; i < n; i++) {
+      compute_face_bounds(objData, i, &bounds[i]);
+      bvh->order[i] = i;
+    }
+    bvh->faceCount = n;
+    build_node(bvh, bounds, 0, n);
+    result = EXIT_SUCCESS;
+  } else {
+    bvh_free(bvh);
+  }
+  free(bounds);
+  return result;
+}
+
+void bvh_free(bvh_t* bvh) {
+  free(bvh->nodes);
+  free(bvh->order);
+  bvh->nodes = NULL;
+  bvh->order = NULL;
+  bvh->nodeCount = 0;
+  bvh->faceCount = 0;
+}
+
+/// @brief Пересечение луча с AABB, возвращает входной параметр t или FLT_MAX.
+static float ray_box(const bvh_node* node, const float* origin,
+                     const float* inv_dir, float t_max) {
+  float t0 = 0, t1 = t_max;
+  for (int k = 0; k < 3 && t0 <= t1; k++) {
+    float near = (node->min[k] - origin[k]) * inv_dir[k];
+    float far = (node->max[k] - origin[k]) * inv_dir[k];
+    if (near > far) {
+      float tmp = near;
+      near = far;
+      far = tmp;
+    }
+    if (near > t0) t0 = near;
+    if (far < t1) t1 = far;
+  }
+  return t0 <= t1 ? t0 : FLT_MAX;
+}
+
+/// @brief Пересечение луча с треугольником (Моллер - Трумбор).
+static int ray_triangle(const float* origin, const float* dir, const float* a,
+                        const float* b, const float* c, float* t) {
+  float e1[3], e2[3], p[3], q[3], s[3];
+  for (int k = 0; k < 3; k++) {
+    e1[k] = b[k] - a[k];
+    e2[k] = c[k] - a[k];
+    s[k] = origin[k] - a[k];
+  }
+  p[0] = dir[1] * e2[2] - dir[2] * e2[1];
+  p[1] = dir[2] * e2[0] - dir[0] * e2[2];
+  p[2] = dir[0] * e2[1] - dir[1] * e2[0];
+  float det = e1[0] * p[0] + e1[1] * p[1] + e1[2] * p[2];
+  int hit = 0;
+  if (fabsf(det) > EPS) {
+    float inv = 1.0f / det;
+    float u = (s[0] * p[0] + s[1] * p[1] + s[2] * p[2]) * inv;
+    q[0] = s[1] * e1[2] - s[2] * e1[1];
+    q[1] = s[2] * e1[0] - s[0] * e1[2];
+    q[2] = s[0] * e1[1] - s[1] * e1[0];
+    float v = (dir[0] * q[0] + dir[1] * q[1] + dir[2] * q[2]) * inv;
+    if (u >= 0 && v >= 0 && u + v <= 1) {
+      *t = (e2[0] * q[0] + e2[1] * q[1] + e2[2] * q[2]) * inv;
+      hit = *t >= 0;
+    }
+  }
+  return hit;
+}
+
+/// @brief Пересечение луча с многоугольником, разбитым веером на треугольники.
+static int ray_face(const OBJData* objData, int i, const float* origin,
+                    const float* dir, float* t) {
+  const face* f = &objData->faces[i];
+  int hit = 0;
+  int a = f->count_number_vertex > 0 ? face_vertex(objData, f, 0) : -1;
+  for (int j = 1; a >= 0 && j + 1 < f->count_number_vertex; j++) {
+    int b = face_vertex(objData, f, j), c = face_vertex(objData, f, j + 1);
+    float t_hit;
+    if (b >= 0 && c >= 0 &&
+        ray_triangle(origin, dir, objData->vertices + a * 3,
+                     objData->vertices + b * 3, objData->vertices + c * 3,
+                     &t_hit) &&
+        (!hit || t_hit < *t)) {
+      *t = t_hit;
+      hit = 1;
+    }
+  }
+  return hit;
+}
+
+int bvh_pick(const bvh_t* bvh, const OBJData* objData, const float* origin,
+             const float* dir, pick_result* result) {
+  float inv_dir[3];
+  for (int k = 0; k < 3; k++)
+    inv_dir[k] = fabsf(dir[k]) > EPS ? 1.0f / dir[k] : 1.0f / EPS;
+
+  result->face = result->vertex = -1;
+  result->t = FLT_MAX;
+  int stack[BVH_STACK_SIZE];
+  int top = 0;
+  if (bvh->nodeCount > 0) stack[top++] = 0;
+  while (top > 0) {
+    const bvh_node* node = &bvh->nodes[stack[--top]];
+    if (ray_box(node, origin, inv_dir, result->t) == FLT_MAX) continue;
+    if (node->left < 0) {
+      for (int i = node->first; i < node->first + node->count; i++) {
+        float t = 0;
+        if (ray_face(objData, bvh->order[i], origin, dir, &t) &&
+            t < result->t) {
+          result->t = t;
+          result->face = bvh->order[i];
+        }
+      }
+    } else if (top + 2 <= BVH_STACK_SIZE) {
+      // ближний потомок кладется последним, чтобы проверяться первым
+      float tl = ray_box(&bvh->nodes[node->left], origin, inv_dir, result->t);
+      float tr = ray_box(&bvh->nodes[node->right], origin, inv_dir, result->t);
+      int near = tl <= tr ? node->left : node->right;
+      int far = tl <= tr ? node->right : node->left;
+      if ((tl <= tr ? tr : tl) != FLT_MAX) stack[top++] = far;
+      if ((tl <= tr ? tl : tr) != FLT_MAX) stack[top++] = near;
+    }
+  }
+
+  if (result->face >= 0) {
+    const face* f = &objData->faces[result->face];
+    float best = FLT_MAX;
+    for (int k = 0; k < 3; k++) result->point[k] = origin[k] + dir[k] * result->t;
+    for (int j = 0; j < f->count_number_vertex; j++) {
+      int index = face_vertex(objData, f, j);
+      if (index < 0) continue;
+      float d = 0;
+      for (int k = 0; k < 3; k++) {
+        float delta = objData->vertices[index * 3 + k] - result->point[k];
+        d += delta * delta;
+      }
+      if (d < best) {
+        best = d;
+        result->vertex = index;
+      }
+    }
+  }
+  return result->face >= 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -186,3 +186,52 @@ matrix_t matrix_alteration(float ax, float ay, float az, float da, float db,
 
   return result;
 }
+
+matrix_t s21_inverse_matrix(matrix_t* A) {
+  matrix_t result = s21_create_matrix(0, 0);
+  if (!s21_correct_matrix(A) && A->rows == A->columns) {
+    int n = A->rows;
+    matrix_t tmp = s21_create_matrix(n, n);
+    result = s21_create_matrix(n, n);
+    for (int i = 0; i < n; i++) {
+      for (int j = 0; j < n; j++) tmp.matrix[i][j] = A->matrix[i][j];
+      result.matrix[i][i] = 1.0;
+    }
+    int singular = 0;
+    for (int col = 0; col < n && !singular; col++) {
+      int pivot = col;
+      for (int i = col + 1; i < n; i++)
+        if (fabs(tmp.matrix[i][col]) > fabs(tmp.matrix[pivot][col])) pivot = i;
+      if (fabs(tmp.matrix[pivot][col]) < EPS) {
+        singular = 1;
+      } else {
+        float* swap = tmp.matrix[col];
+        tmp.matrix[col] = tmp.matrix[pivot];
+        tmp.matrix[pivot] = swap;
+        swap = result.matrix[col];
+        result.matrix[col] = result.matrix[pivot];
+        result.matrix[pivot] = swap;
+        float k = tmp.matrix[col][col];
+        for (int j = 0; j < n; j++) {
+          tmp.matrix[col][j] /= k;
+          result.matrix[col][j] /= k;
+        }
+        for (int i = 0; i < n; i++) {
+          if (i == col) continue;
+          float f = tmp.matrix[i][col];
+          for (int j = 0; j < n; j++) {
+            tmp.matrix[i][j] -= f * tmp.matrix[col][j];
+            result.matrix[i][j] -= f * result.matrix[col][j];
+          }
+        }
+      }
+    }
+    s21_remove_matrix(&tmp);
+    if (singular) {
+      s21_remove_matrix(&result);
+    } else {
+      result.matrix_type = OK;
+    }
+  }
+  return result;
+}
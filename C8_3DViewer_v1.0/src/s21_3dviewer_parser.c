@@ -1,5 +1,9 @@
 #include "parser.h"
 
+#define OBJ_LINE_SIZE 256
+#define FNV_OFFSET 14695981039346656037UL
+#define FNV_PRIME 1099511628211UL
+
 void initializeOBJData(OBJData** objData) {
   (*objData) = calloc(1, sizeof(OBJData));
   (*objData)->vertexCount = 0;
@@ -8,91 +12,279 @@ void initializeOBJData(OBJData** objData) {
   (*objData)->faces = NULL;
   (*objData)->maxVertexValue = 0.0f;
   (*objData)->maxFaceValue = 0;
+  (*objData)->indices = NULL;
+  (*objData)->marks = NULL;
+  (*objData)->markCount = 0;
+  (*objData)->checkpoint.hash = FNV_OFFSET;
+  (*objData)->checkpoint.pendingHash = FNV_OFFSET;
+}
+
+static unsigned long hash_bytes(unsigned long hash, const char* data,
+                                size_t n) {
+  for (size_t i = 0; i < n; i++) {
+    hash ^= (unsigned char)data[i];
+    hash *= FNV_PRIME;
+  }
+  return hash;
+}
+
+/// @brief Разбор одной строки OBJ (вершина или грань).
+static void parseOBJLine(char* line, OBJData** objData) {
+  if (line[0] == '#') {
+    // Это комментарий, пропустить строку
+    return;
+  } else if (line[0] == 'v' && line[1] == ' ') {
+    // Обработка вершин (v)
+    (*objData)->vertexCount++;
+    if ((*objData)->vertexCount == 1) {
+      (*objData)->vertices = calloc(1, sizeof(float) * 3);
+    } else
+      (*objData)->vertices = realloc(
+          (*objData)->vertices, (*objData)->vertexCount * 3 * sizeof(float));
+    float x, y, z;
+    sscanf(line + 2, "%f %f %f", &x, &y, &z);
+    (*objData)->vertices[((*objData)->vertexCount - 1) * 3] = x;
+    (*objData)->vertices[((*objData)->vertexCount - 1) * 3 + 1] = y;
+    (*objData)->vertices[((*objData)->vertexCount - 1) * 3 + 2] = z;
+
+    // Обновление максимальных значений
+    float maxCoord = x > y ? (x > z ? x : z) : (y > z ? y : z);
+    if (maxCoord > (*objData)->maxVertexValue) {
+      (*objData)->maxVertexValue = maxCoord;
+    }
+  } else if (line[0] == 'f' && line[1] == ' ') {
+    // Обработка граней (f)
+    (*objData)->faceCount++;
+    if ((*objData)->faceCount == 1) {
+      (*objData)->faces = calloc(1, sizeof(face));
+    } else
+      (*objData)->faces =
+          realloc((*objData)->faces, (*objData)->faceCount * sizeof(face));
+
+    int number = 0, offset = 0;
+    char* data = line + 2;
+    (*objData)->faces[(*objData)->faceCount - 1].count_number_vertex = 0;
+    (*objData)->faces[(*objData)->faceCount - 1].number_vertex = NULL;
+    int i = 0;
+    while (sscanf(data, "%d%n", &number, &offset) == 1) {
+      data += offset;
+      (*objData)->faces[(*objData)->faceCount - 1].count_number_vertex++;
+      if ((*objData)->faces[(*objData)->faceCount - 1].count_number_vertex ==
+          1)
+        (*objData)->faces[(*objData)->faceCount - 1].number_vertex =
+            calloc(1, sizeof(int));
+      else
+        (*objData)->faces[(*objData)->faceCount - 1].number_vertex = realloc(
+            (*objData)->faces[(*objData)->faceCount - 1].number_vertex,
+            (*objData)->faces[(*objData)->faceCount - 1].count_number_vertex *
+                sizeof(int));
+      (*objData)->faces[(*objData)->faceCount - 1].number_vertex[i++] =
+          number;
+      if (data[0] == '/')
+        while (data[0] != ' ' && data[0] != '\n' && data[0] != '\0') data++;
+    }
+
+    // Обновление максимального значения
+    // int maxIndex = v1 > v2 ? (v1 > v3 ? v1 : v3) : (v2 > v3 ? v2 : v3);
+    //      if (maxIndex > (*objData)->maxFaceValue)
+    //        (*objData)->maxFaceValue = maxIndex;
+  }
+}
+
+/// @brief Сохраняет текущее состояние, если после предыдущего разобрано не
+/// меньше OBJ_MARK_BYTES байт.
+static void addOBJMark(OBJData* objData) {
+  long last = objData->markCount > 0
+                  ? objData->marks[objData->markCount - 1].bytes
+                  : 0;
+  if (objData->checkpoint.bytes - last >= OBJ_MARK_BYTES) {
+    obj_checkpoint* marks =
+        realloc(objData->marks, sizeof(obj_checkpoint) *
+                                    (objData->markCount + 1));
+    // без нового состояния повторный разбор только начнется раньше
+    if (marks != NULL) {
+      objData->marks = marks;
+      objData->marks[objData->markCount++] = objData->checkpoint;
+    }
+  }
+}
+
+/// @brief Читает файл с текущей позиции и запоминает последнюю полную строку.
+static void parseOBJStream(FILE* file, OBJData** objData) {
+  obj_checkpoint* checkpoint = &(*objData)->checkpoint;
+  char* line = calloc(OBJ_LINE_SIZE, sizeof(char));
+  while (fgets(line, OBJ_LINE_SIZE, file) != NULL) {
+    size_t len = strlen(line);
+    parseOBJLine(line, objData);
+    checkpoint->pendingBytes += len;
+    checkpoint->pendingHash = hash_bytes(checkpoint->pendingHash, line, len);
+    if (len > 0 && line[len - 1] == '\n') {
+      // строка дописана до конца: с этого места можно продолжать разбор
+      checkpoint->bytes = checkpoint->pendingBytes;
+      checkpoint->hash = checkpoint->pendingHash;
+      checkpoint->vertexCount = (*objData)->vertexCount;
+      checkpoint->faceCount = (*objData)->faceCount;
+      checkpoint->maxVertexValue = (*objData)->maxVertexValue;
+      addOBJMark(*objData);
+    }
+  }
+  free(line);
 }
 
 int parseOBJFile(const char* filename, OBJData** objData) {
   initializeOBJData(objData);
 
-  FILE* file = fopen(filename, "r");
+  FILE* file = fopen(filename, "rb");
   if (file == NULL) {
     freeOBJData(*objData);
     return EXIT_FAILURE;
   }
 
-  char* line = calloc(256, sizeof(char));
-  while (fgets(line, 256, file) != NULL) {
-    if (line[0] == '#') {
-      // Это комментарий, пропустить строку
-      continue;
-    } else if (line[0] == 'v' && line[1] == ' ') {
-      // Обработка вершин (v)
-      (*objData)->vertexCount++;
-      if ((*objData)->vertexCount == 1) {
-        (*objData)->vertices = calloc(1, sizeof(float) * 3);
-      } else
-        (*objData)->vertices = realloc(
-            (*objData)->vertices, (*objData)->vertexCount * 3 * sizeof(float));
-      float x, y, z;
-      sscanf(line + 2, "%f %f %f", &x, &y, &z);
-      (*objData)->vertices[((*objData)->vertexCount - 1) * 3] = x;
-      (*objData)->vertices[((*objData)->vertexCount - 1) * 3 + 1] = y;
-      (*objData)->vertices[((*objData)->vertexCount - 1) * 3 + 2] = z;
-
-      // Обновление максимальных значений
-      float maxCoord = x > y ? (x > z ? x : z) : (y > z ? y : z);
-      if (maxCoord > (*objData)->maxVertexValue) {
-        (*objData)->maxVertexValue = maxCoord;
-      }
-    } else if (line[0] == 'f' && line[1] == ' ') {
-      // Обработка граней (f)
-      (*objData)->faceCount++;
-      if ((*objData)->faceCount == 1) {
-        (*objData)->faces = calloc(1, sizeof(face));
-      } else
-        (*objData)->faces =
-            realloc((*objData)->faces, (*objData)->faceCount * sizeof(face));
-
-      int number = 0, offset = 0;
-      char* data = line + 2;
-      (*objData)->faces[(*objData)->faceCount - 1].count_number_vertex = 0;
-      int i = 0;
-      while (sscanf(data, "%d%n", &number, &offset) == 1) {
-        data += offset;
-        (*objData)->faces[(*objData)->faceCount - 1].count_number_vertex++;
-        if ((*objData)->faces[(*objData)->faceCount - 1].count_number_vertex ==
-            1)
-          (*objData)->faces[(*objData)->faceCount - 1].number_vertex =
-              calloc(1, sizeof(int));
-        else
-          (*objData)->faces[(*objData)->faceCount - 1].number_vertex = realloc(
-              (*objData)->faces[(*objData)->faceCount - 1].number_vertex,
-              (*objData)->faces[(*objData)->faceCount - 1].count_number_vertex *
-                  sizeof(int));
-        (*objData)->faces[(*objData)->faceCount - 1].number_vertex[i++] =
-            number;
-        if (data[0] == '/')
-          //            printf("**** %c\n", data);
-          while (data[0] != ' ') data++;
-      }
+  parseOBJStream(file, objData);
+  fclose(file);
+  return EXIT_SUCCESS;
+}
 
-      // Обновление максимального значения
-      // int maxIndex = v1 > v2 ? (v1 > v3 ? v1 : v3) : (v2 > v3 ? v2 : v3);
-      //      if (maxIndex > (*objData)->maxFaceValue)
-      //        (*objData)->maxFaceValue = maxIndex;
+/// @brief Дочитывает файл до конца разобранной части checkpoint.
+/// @param read Сколько байт уже прочитано, hash - их хеш.
+/// @return 1, если прочитанное начало файла совпадает с разобранным.
+static int prefix_matches(FILE* file, const obj_checkpoint* checkpoint,
+                          long* read, unsigned long* hash) {
+  char buffer[65536];
+  int result = 1;
+  while (result && *read < checkpoint->bytes) {
+    long left = checkpoint->bytes - *read;
+    size_t chunk = left < (long)sizeof(buffer) ? (size_t)left : sizeof(buffer);
+    if (fread(buffer, 1, chunk, file) != chunk) {
+      result = 0;
+    } else {
+      *hash = hash_bytes(*hash, buffer, chunk);
+      *read += chunk;
     }
   }
-  free(line);
+  return result && *hash == checkpoint->hash;
+}
+
+/// @brief Последнее состояние previous (сохраненное или последняя полная
+/// строка), до которого файл не изменился, или NULL.
+static const obj_checkpoint* lastUnchanged(FILE* file,
+                                           const OBJData* previous) {
+  const obj_checkpoint* found = NULL;
+  long read = 0;
+  unsigned long hash = FNV_OFFSET;
+  int matches = 1;
+  for (int i = 0; i < previous->markCount && matches; i++) {
+    matches = prefix_matches(file, &previous->marks[i], &read, &hash);
+    if (matches) found = &previous->marks[i];
+  }
+  // последняя полная строка совпадает с последним состоянием, если после
+  // него ничего не дописано
+  if (matches && previous->checkpoint.bytes > read &&
+      prefix_matches(file, &previous->checkpoint, &read, &hash))
+    found = &previous->checkpoint;
+  return found != NULL && found->bytes > 0 ? found : NULL;
+}
+
+/// @brief Копия модели, обрезанная до состояния checkpoint.
+static int copyOBJCheckpoint(const OBJData* source,
+                             const obj_checkpoint* checkpoint,
+                             OBJData** objData) {
+  int result = EXIT_SUCCESS;
+  initializeOBJData(objData);
+  OBJData* copy = *objData;
+  copy->checkpoint = *checkpoint;
+  copy->checkpoint.pendingBytes = checkpoint->bytes;
+  copy->checkpoint.pendingHash = checkpoint->hash;
+  copy->maxVertexValue = checkpoint->maxVertexValue;
+  int marks = 0;
+  while (marks < source->markCount &&
+         source->marks[marks].bytes <= checkpoint->bytes)
+    marks++;
+  if (marks > 0) {
+    copy->marks = malloc(sizeof(obj_checkpoint) * marks);
+    if (copy->marks != NULL) {
+      memcpy(copy->marks, source->marks, sizeof(obj_checkpoint) * marks);
+      copy->markCount = marks;
+    } else {
+      result = EXIT_FAILURE;
+    }
+  }
+  if (result == EXIT_SUCCESS && checkpoint->vertexCount > 0) {
+    copy->vertices = malloc(sizeof(float) * 3 * checkpoint->vertexCount);
+    if (copy->vertices != NULL) {
+      memcpy(copy->vertices, source->vertices,
+             sizeof(float) * 3 * checkpoint->vertexCount);
+      copy->vertexCount = checkpoint->vertexCount;
+    } else {
+      result = EXIT_FAILURE;
+    }
+  }
+  if (result == EXIT_SUCCESS && checkpoint->faceCount > 0) {
+    copy->faces = calloc(checkpoint->faceCount, sizeof(face));
+    result = copy->faces != NULL ? EXIT_SUCCESS : EXIT_FAILURE;
+    for (int i = 0; i < checkpoint->faceCount && result == EXIT_SUCCESS; i++) {
+      const face* f = &source->faces[i];
+      copy->faces[i].number_vertex =
+          malloc(sizeof(int) * (f->count_number_vertex + 1));
+      if (copy->faces[i].number_vertex == NULL) {
+        result = EXIT_FAILURE;
+      } else {
+        memcpy(copy->faces[i].number_vertex, f->number_vertex,
+               sizeof(int) * f->count_number_vertex);
+        copy->faces[i].count_number_vertex = f->count_number_vertex;
+        copy->faceCount = i + 1;
+      }
+    }
+  }
+  if (result != EXIT_SUCCESS) {
+    freeOBJData(copy);
+    *objData = NULL;
+  }
+  return result;
+}
+
+int reparseOBJFile(const char* filename, const OBJData* previous,
+                   OBJData** objData, int* incremental) {
+  *incremental = 0;
+  FILE* file = fopen(filename, "rb");
+  if (file == NULL) {
+    *objData = NULL;
+    return EXIT_FAILURE;
+  }
+
+  const obj_checkpoint* resume =
+      previous != NULL && previous->indices == NULL
+          ? lastUnchanged(file, previous)
+          : NULL;
+  int resumed = resume != NULL &&
+                copyOBJCheckpoint(previous, resume, objData) == EXIT_SUCCESS;
+  if (resumed && fseek(file, resume->bytes, SEEK_SET) != 0) {
+    freeOBJData(*objData);
+    resumed = 0;
+  }
+  if (resumed) {
+    // до resume файл не менялся: разбираем только остаток
+    parseOBJStream(file, objData);
+    *incremental = 1;
+  } else {
+    rewind(file);
+    initializeOBJData(objData);
+    parseOBJStream(file, objData);
+  }
   fclose(file);
-  // remove_array(objData);
-  // free(objData);
   return EXIT_SUCCESS;
 }
 
 void freeOBJData(OBJData* objData) {
-  for (int i = 0; i < objData->faceCount; i++) {
-    free(objData->faces[i].number_vertex);
+  if (objData->indices != NULL) {
+    free(objData->indices);
+  } else {
+    for (int i = 0; i < objData->faceCount; i++) {
+      free(objData->faces[i].number_vertex);
+    }
   }
   free(objData->faces);
   free(objData->vertices);
+  free(objData->marks);
   free(objData);
 }
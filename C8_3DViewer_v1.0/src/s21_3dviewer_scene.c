@@ -0,0 +1,157 @@
+#include "parser.h"
+
+#define SCENE_LINE_SIZE 1024
+
+void scene_init(scene_t* scene) {
+  scene->meshes = NULL;
+  scene->meshCount = 0;
+  scene->instances = NULL;
+  scene->instanceCount = 0;
+  scene->instanceCapacity = 0;
+}
+
+void scene_free(scene_t* scene) {
+  for (int i = 0; i < scene->meshCount; i++) freeOBJData(scene->meshes[i]);
+  for (int i = 0; i < scene->instanceCount; i++)
+    s21_remove_matrix(&scene->instances[i].transform);
+  free(scene->meshes);
+  free(scene->instances);
+  scene_init(scene);
+}
+
+int scene_add_mesh(scene_t* scene, OBJData* mesh) {
+  int index = -1;
+  OBJData** meshes =
+      realloc(scene->meshes, sizeof(OBJData*) * (scene->meshCount + 1));
+  if (meshes != NULL) {
+    scene->meshes = meshes;
+    scene->meshes[scene->meshCount] = mesh;
+    index = scene->meshCount++;
+  }
+  return index;
+}
+
+int scene_add_instance(scene_t* scene, int mesh, matrix_t transform) {
+  int index = -1;
+  if (mesh >= 0 && mesh < scene->meshCount &&
+      !s21_correct_matrix(&transform) && transform.rows == 4 &&
+      transform.columns == 4) {
+    if (scene->instanceCount == scene->instanceCapacity) {
+      // рост в два раза: тысячи экземпляров без перевыделения на каждый
+      int capacity = scene->instanceCapacity ? scene->instanceCapacity * 2 : 16;
+      scene_instance* instances =
+          realloc(scene->instances, sizeof(scene_instance) * capacity);
+      if (instances != NULL) {
+        scene->instances = instances;
+        scene->instanceCapacity = capacity;
+      }
+    }
+    if (scene->instanceCount < scene->instanceCapacity) {
+      scene->instances[scene->instanceCount].mesh = mesh;
+      scene->instances[scene->instanceCount].transform = transform;
+      index = scene->instanceCount++;
+    }
+  }
+  if (index < 0) s21_remove_matrix(&transform);
+  return index;
+}
+
+int scene_instance_matrices(const scene_t* scene, int mesh, float* out) {
+  int count = 0;
+  for (int i = 0; i < scene->instanceCount; i++) {
+    if (scene->instances[i].mesh != mesh) continue;
+    if (out != NULL) {
+      // по столбцам, как их ожидает атрибут mat4
+      float** m = scene->instances[i].transform.matrix;
+      for (int column = 0; column < 4; column++)
+        for (int row = 0; row < 4; row++)
+          out[count * 16 + column * 4 + row] = m[row][column];
+    }
+    count++;
+  }
+  return count;
+}
+
+float scene_max_value(const scene_t* scene) {
+  float result = 0;
+  for (int i = 0; i < scene->instanceCount; i++) {
+    float** m = scene->instances[i].transform.matrix;
+    float scale = 0, shift = 0;
+    for (int row = 0; row < 3; row++) {
+      for (int column = 0; column < 3; column++)
+        if (fabsf(m[row][column]) > scale) scale = fabsf(m[row][column]);
+      if (fabsf(m[row][3]) > shift) shift = fabsf(m[row][3]);
+    }
+    float value =
+        scene->meshes[scene->instances[i].mesh]->maxVertexValue * scale + shift;
+    if (value > result) result = value;
+  }
+  return result;
+}
+
+/// @brief Преобразование экземпляра: масштаб, поворот и затем сдвиг.
+static matrix_t instance_transform(const float* d, const float* a, float k) {
+  matrix_t shift = shifting(d[0], d[1], d[2]);
+  matrix_t rotate = rotating(a[0], a[1], a[2]);
+  matrix_t scale = scaling(k);
+  matrix_t sr = s21_mult_matrix(&shift, &rotate);
+  matrix_t result = s21_mult_matrix(&sr, &scale);
+  s21_remove_matrix(&shift);
+  s21_remove_matrix(&rotate);
+  s21_remove_matrix(&scale);
+  s21_remove_matrix(&sr);
+  return result;
+}
+
+/// @brief Путь к модели относительно каталога файла сцены.
+static void resolve_path(const char* scene_file, const char* path, char* out,
+                         size_t size) {
+  const char* slash = strrchr(scene_file, '/');
+  if (path[0] == '/' || slash == NULL) {
+    snprintf(out, size, "%s", path);
+  } else {
+    snprintf(out, size, "%.*s/%s", (int)(slash - scene_file), scene_file, path);
+  }
+}
+
+int parseSceneFile(const char* filename, scene_t* scene) {
+  scene_init(scene);
+  FILE* file = fopen(filename, "r");
+  if (file == NULL) return EXIT_FAILURE;
+
+  int result = EXIT_SUCCESS;
+  char line[SCENE_LINE_SIZE];
+  while (result == EXIT_SUCCESS && fgets(line, sizeof(line), file) != NULL) {
+    if (line[0] == 'm' && line[1] == ' ') {
+      // m <путь к модели>
+      char path[SCENE_LINE_SIZE], full[2 * SCENE_LINE_SIZE];
+      OBJData* mesh = NULL;
+      if (sscanf(line + 2, " %1023[^\r\n]", path) != 1) {
+        result = EXIT_FAILURE;
+      } else {
+        resolve_path(filename, path, full, sizeof(full));
+        if (parseModelFile(full, &mesh) != EXIT_SUCCESS) {
+          result = EXIT_FAILURE;
+        } else if (scene_add_mesh(scene, mesh) < 0) {
+          freeOBJData(mesh);
+          result = EXIT_FAILURE;
+        }
+      }
+    } else if (line[0] == 'i' && line[1] == ' ') {
+      // i <модель> <dx dy dz> <ax ay az> <масштаб>
+      int mesh = -1;
+      float d[3] = {0}, a[3] = {0}, k = 1;
+      int n = sscanf(line + 2, "%d %f %f %f %f %f %f %f", &mesh, &d[0], &d[1],
+                     &d[2], &a[0], &a[1], &a[2], &k);
+      if (n < 1 || mesh < 0 || mesh >= scene->meshCount) {
+        result = EXIT_FAILURE;
+      } else if (scene_add_instance(scene, mesh,
+                                    instance_transform(d, a, k)) < 0) {
+        result = EXIT_FAILURE;
+      }
+    }
+  }
+  fclose(file);
+  if (result != EXIT_SUCCESS) scene_free(scene);
+  return result;
+}
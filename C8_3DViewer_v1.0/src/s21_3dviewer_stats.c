@@ -0,0 +1,94 @@
+#include "parser.h"
+
+static const char* stage_names[FRAME_STAGES] = {"upload", "transform", "draw",
+                                                "readback"};
+
+int frame_history_init(frame_history* history, int capacity) {
+  history->records = capacity > 0 ? calloc(capacity, sizeof(frame_record))
+                                  : NULL;
+  history->capacity = history->records != NULL ? capacity : 0;
+  history->count = 0;
+  history->head = 0;
+  history->frames = 0;
+  return history->records != NULL ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+void frame_history_free(frame_history* history) {
+  free(history->records);
+  history->records = NULL;
+  history->capacity = history->count = history->head = 0;
+}
+
+void frame_history_push(frame_history* history, const frame_record* record) {
+  if (history->capacity > 0) {
+    history->records[history->head] = *record;
+    history->head = (history->head + 1) % history->capacity;
+    if (history->count < history->capacity) history->count++;
+    history->frames++;
+  }
+}
+
+const frame_record* frame_history_at(const frame_history* history, int i) {
+  const frame_record* record = NULL;
+  if (i >= 0 && i < history->count) {
+    int oldest = (history->head - history->count + history->capacity) %
+                 history->capacity;
+    record = &history->records[(oldest + i) % history->capacity];
+  }
+  return record;
+}
+
+void frame_history_average(const frame_history* history, frame_record* out) {
+  int gpu_frames[FRAME_STAGES] = {0};
+  memset(out, 0, sizeof(*out));
+  for (int i = 0; i < history->count; i++) {
+    const frame_record* record = frame_history_at(history, i);
+    for (int s = 0; s < FRAME_STAGES; s++) {
+      out->cpu_ms[s] += record->cpu_ms[s];
+      if (record->gpu_ms[s] >= 0) {
+        out->gpu_ms[s] += record->gpu_ms[s];
+        gpu_frames[s]++;
+      }
+    }
+    out->total_ms += record->total_ms;
+  }
+  if (history->count > 0) {
+    for (int s = 0; s < FRAME_STAGES; s++) out->cpu_ms[s] /= history->count;
+    out->total_ms /= history->count;
+  }
+  for (int s = 0; s < FRAME_STAGES; s++)
+    out->gpu_ms[s] = gpu_frames[s] > 0 ? out->gpu_ms[s] / gpu_frames[s] : -1;
+}
+
+const char* frame_stage_name(int stage) {
+  return stage >= 0 && stage < FRAME_STAGES ? stage_names[stage] : "";
+}
+
+int frame_history_write_csv(const frame_history* history,
+                            const char* filename) {
+  FILE* file = fopen(filename, "w");
+  if (file == NULL) return EXIT_FAILURE;
+
+  long first = history->frames - history->count;
+  fprintf(file, "frame");
+  for (int s = 0; s < FRAME_STAGES; s++) fprintf(file, ",%s_ms", stage_names[s]);
+  for (int s = 0; s < FRAME_STAGES; s++)
+    fprintf(file, ",gpu_%s_ms", stage_names[s]);
+  fprintf(file, ",total_ms\n");
+  for (int i = 0; i < history->count; i++) {
+    const frame_record* record = frame_history_at(history, i);
+    fprintf(file, "%ld", first + i);
+    for (int s = 0; s < FRAME_STAGES; s++)
+      fprintf(file, ",%.4f", record->cpu_ms[s]);
+    // GPU-время недоступно без поддержки timer query
+    for (int s = 0; s < FRAME_STAGES; s++)
+      if (record->gpu_ms[s] >= 0)
+        fprintf(file, ",%.4f", record->gpu_ms[s]);
+      else
+        fprintf(file, ",");
+    fprintf(file, ",%.4f\n", record->total_ms);
+  }
+  int result = ferror(file) ? EXIT_FAILURE : EXIT_SUCCESS;
+  fclose(file);
+  return result;
+}
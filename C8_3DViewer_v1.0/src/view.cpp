@@ -1,6 +1,55 @@
 #include "view.h"
 
-View::View(QWidget *parent) : QOpenGLWidget{parent} {}
+#include <QElapsedTimer>
+#include <QMatrix4x4>
+#include <QMouseEvent>
+#include <QOpenGLExtraFunctions>
+#include <QPainter>
+
+// вершина сцены: своя матрица экземпляра, затем общая matrix_alt
+static const char *instancing_vertex =
+    "#version 330\n"
+    "layout(location = 0) in vec3 position;\n"
+    "layout(location = 1) in mat4 instance;\n"
+    "uniform mat4 view;\n"
+    "void main() { gl_Position = view * instance * vec4(position, 1.0); }\n";
+
+static const char *instancing_fragment =
+    "#version 330\n"
+    "uniform vec4 color;\n"
+    "out vec4 frag_color;\n"
+    "void main() { frag_color = color; }\n";
+
+/// @brief Пары индексов вершин для всех ребер модели.
+static void collectEdges(const OBJData *model, QVector<GLuint> &edges) {
+    edges.clear();
+    for (int i = 0; i < model->faceCount; i++) {  // перебираем полигоны
+        int count = model->faces[i].count_number_vertex;
+        for (int j = 0; j < count; j++) {  // перебираем линии в полигоне
+            int index1 = model->faces[i].number_vertex[j] - 1;
+            int index2 = model->faces[i].number_vertex[(j + 1) % count] - 1;
+            if (index1 >= 0 && index1 < model->vertexCount && index2 >= 0 &&
+                index2 < model->vertexCount) {
+                edges.append(index1);
+                edges.append(index2);
+            }
+        }
+    }
+}
+
+View::View(QWidget *parent) : QOpenGLWidget{parent} {
+    frame_history_init(&history, FRAME_HISTORY_SIZE);
+}
+
+View::~View() {
+    makeCurrent();
+    for (QOpenGLTimeMonitor *monitor : gpu_monitors) delete monitor;
+    scene_buffers.clear();
+    delete instancing;
+    doneCurrent();
+    frame_history_free(&history);
+    scene_free(&scene);
+}
 
 void View::initializeGL() {
     initializeOpenGLFunctions();
@@ -11,56 +60,409 @@ void View::initializeGL() {
     glEnable(GL_LIGHTING);
     glColorMaterial(GL_FRONT_AND_BACK, GL_AMBIENT_AND_DIFFUSE);
     glEnable(GL_COLOR_MATERIAL);
+
+    // timer query есть не везде (нужен GL 3.3 или ARB_timer_query);
+    // отметка времени ставится перед первым этапом и после каждого
+    for (int i = 0; i < 2; i++) {
+        delete gpu_monitors[i];
+        gpu_monitors[i] = new QOpenGLTimeMonitor(this);
+        gpu_monitors[i]->setSampleCount(FRAME_STAGES + 1);
+        if (!gpu_monitors[i]->create()) {
+            delete gpu_monitors[i];
+            gpu_monitors[i] = nullptr;
+        }
+        gpu_pending[i] = false;
+    }
+
+    // экземпляры рисуются одним вызовом на модель, если есть GL 3.3,
+    // иначе матрицы подгружаются через glLoadMatrixf по одной
+    delete instancing;
+    instancing = nullptr;
+    if (context()->format().version() >= qMakePair(3, 3)) {
+        instancing = new QOpenGLShaderProgram;
+        if (!instancing->addShaderFromSourceCode(QOpenGLShader::Vertex, instancing_vertex) ||
+            !instancing->addShaderFromSourceCode(QOpenGLShader::Fragment, instancing_fragment) ||
+            !instancing->link()) {
+            delete instancing;
+            instancing = nullptr;
+        }
+    }
+    scene_dirty = true;
+}
+
+void View::modelChanged() {
+    edges_dirty = true;
+}
+
+void View::sceneChanged() {
+    scene_dirty = true;
+}
+
+bool View::hasModel() const {
+    return probe != NULL || scene.meshCount > 0;
+}
+
+float View::maxVertexValue() const {
+    return probe != NULL ? probe->maxVertexValue : scene_max_value(&scene);
 }
 
 void View::paintGL() {
+    QElapsedTimer frame_timer, stage_timer;
+    frame_timer.start();
+    frame_record record = {};
+    for (double &gpu_ms : record.gpu_ms)
+        gpu_ms = -1;
+
     glClearColor(b_red, b_green, b_blue, 1);
+    glEnable(GL_DEPTH_TEST);
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
-
     if(probe != NULL) {
-        if(vert_type != 0) {
-            glColor3f(v_red, v_green, v_blue);
-            glPointSize(vertices_size);
+        bool gpu_timing = show_stats && beginGpuTimer(&record);
+        stage_timer.start();
+        if (edges_dirty)
+            uploadEdges();
+        record.cpu_ms[STAGE_UPLOAD] = stage_timer.nsecsElapsed() / 1e6;
+        endGpuStage(gpu_timing);
+
+        stage_timer.restart();
+        transformVertices();
+        record.cpu_ms[STAGE_TRANSFORM] = stage_timer.nsecsElapsed() / 1e6;
+        endGpuStage(gpu_timing);
+
+        stage_timer.restart();
+        drawModel();
+        drawPicked();
+        record.cpu_ms[STAGE_DRAW] = stage_timer.nsecsElapsed() / 1e6;
+        endGpuStage(gpu_timing);
+
+        if (show_stats) {
+            // без оверлея конвейер не синхронизируется, чтобы не тормозить кадр
+            stage_timer.restart();
+            glFinish();
+            record.cpu_ms[STAGE_READBACK] = stage_timer.nsecsElapsed() / 1e6;
+            endGpuStage(gpu_timing);
+        }
+    } else if (scene.meshCount > 0) {
+        bool gpu_timing = show_stats && beginGpuTimer(&record);
+        stage_timer.start();
+        if (scene_dirty)
+            uploadScene();
+        record.cpu_ms[STAGE_UPLOAD] = stage_timer.nsecsElapsed() / 1e6;
+        endGpuStage(gpu_timing);
+
+        // вершины преобразует шейдер или конвейер, этап transform пустой
+        endGpuStage(gpu_timing);
+
+        stage_timer.restart();
+        if (instancing != nullptr)
+            drawScene();
+        else
+            drawSceneFallback();
+        record.cpu_ms[STAGE_DRAW] = stage_timer.nsecsElapsed() / 1e6;
+        endGpuStage(gpu_timing);
+
+        if (show_stats) {
+            stage_timer.restart();
+            glFinish();
+            record.cpu_ms[STAGE_READBACK] = stage_timer.nsecsElapsed() / 1e6;
+            endGpuStage(gpu_timing);
+        }
+    }
+    record.total_ms = frame_timer.nsecsElapsed() / 1e6;
+    frame_history_push(&history, &record);
+
+    if (show_stats)
+        drawStats();
+}
+
+bool View::beginGpuTimer(frame_record *record) {
+    // мониторы чередуются: этапы прошлого кадра читаются без ожидания
+    int previous = gpu_frame;
+    gpu_frame = (gpu_frame + 1) % 2;
+    QOpenGLTimeMonitor *done = gpu_monitors[previous];
+    if (done != nullptr && gpu_pending[previous] && done->isResultAvailable()) {
+        QVector<GLuint64> intervals = done->waitForIntervals();
+        for (int s = 0; s < FRAME_STAGES && s < intervals.size(); s++)
+            record->gpu_ms[s] = intervals[s] / 1e6;
+        done->reset();
+        gpu_pending[previous] = false;
+    }
+    bool started = gpu_monitors[gpu_frame] != nullptr && !gpu_pending[gpu_frame];
+    if (started) {
+        gpu_monitors[gpu_frame]->recordSample();
+        gpu_pending[gpu_frame] = true;
+    }
+    return started;
+}
+
+void View::endGpuStage(bool timing) {
+    if (timing)
+        gpu_monitors[gpu_frame]->recordSample();
+}
+
+void View::uploadEdges() {
+    collectEdges(probe, edges);
+    edges_dirty = false;
+}
+
+void View::uploadScene() {
+    scene_buffers.clear();
+    scene_buffers.resize(scene.meshCount);
+    for (int m = 0; m < scene.meshCount; m++) {
+        const OBJData *mesh = scene.meshes[m];
+        mesh_buffers &b = scene_buffers[m];
+        collectEdges(mesh, b.edge_data);
+        b.instance_count = scene_instance_matrices(&scene, m, NULL);
+        b.matrices.resize(b.instance_count * 16);
+        scene_instance_matrices(&scene, m, b.matrices.data());
+        if (instancing == nullptr)
+            continue;
+        b.vertices.create();
+        b.vertices.bind();
+        b.vertices.allocate(mesh->vertices, mesh->vertexCount * 3 * sizeof(GLfloat));
+        b.edges.create();
+        b.edges.bind();
+        b.edges.allocate(b.edge_data.constData(), b.edge_data.size() * sizeof(GLuint));
+        b.instances.create();
+        b.instances.bind();
+        b.instances.allocate(b.matrices.constData(), b.matrices.size() * sizeof(GLfloat));
+    }
+    // клиентские массивы остальных путей работают только без привязанных буферов
+    QOpenGLBuffer::release(QOpenGLBuffer::VertexBuffer);
+    QOpenGLBuffer::release(QOpenGLBuffer::IndexBuffer);
+    scene_dirty = false;
+}
+
+void View::drawScene() {
+    QOpenGLExtraFunctions *f = context()->extraFunctions();
+    instancing->bind();
+    instancing->setUniformValue("view", QMatrix4x4(
+        matrix_alt.matrix[0][0], matrix_alt.matrix[0][1], matrix_alt.matrix[0][2], matrix_alt.matrix[0][3],
+        matrix_alt.matrix[1][0], matrix_alt.matrix[1][1], matrix_alt.matrix[1][2], matrix_alt.matrix[1][3],
+        matrix_alt.matrix[2][0], matrix_alt.matrix[2][1], matrix_alt.matrix[2][2], matrix_alt.matrix[2][3],
+        matrix_alt.matrix[3][0], matrix_alt.matrix[3][1], matrix_alt.matrix[3][2], matrix_alt.matrix[3][3]));
+    glLineWidth(lines_width);
+    glPointSize(vertices_size);
+    for (int m = 0; m < scene_buffers.size(); m++) {
+        mesh_buffers &b = scene_buffers[m];
+        if (b.instance_count == 0)
+            continue;
+        b.vertices.bind();
+        f->glEnableVertexAttribArray(0);
+        f->glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 0, nullptr);
+        // mat4 занимает четыре атрибута подряд, по столбцу на каждый
+        b.instances.bind();
+        for (int c = 0; c < 4; c++) {
+            f->glEnableVertexAttribArray(1 + c);
+            f->glVertexAttribPointer(1 + c, 4, GL_FLOAT, GL_FALSE, 16 * sizeof(GLfloat),
+                                     reinterpret_cast<void *>(c * 4 * sizeof(GLfloat)));
+            f->glVertexAttribDivisor(1 + c, 1);
+        }
+        if (vert_type != 0) {
+            instancing->setUniformValue("color", QVector4D(v_red, v_green, v_blue, 1));
             if (vert_type == 1)
                 glEnable(GL_POINT_SMOOTH);
-            glBegin(GL_POINTS);
-            for (int i = 0; i < probe->vertexCount; i++) {
-                float out_x = 0.0, out_y = 0.0, out_z = 0.0;
-                transform(probe->vertices[i * 3], probe->vertices[i * 3 + 1], probe->vertices[i * 3 + 2], &out_x, &out_y, &out_z);
-                glVertex3f(out_x, out_y, out_z);
-            }
-            glEnd();
+            f->glDrawArraysInstanced(GL_POINTS, 0, scene.meshes[m]->vertexCount, b.instance_count);
             if (vert_type == 1)
                 glDisable(GL_POINT_SMOOTH);
         }
-        int index1, index2;
-        glColor3f(f_red, f_green, f_blue);
-        glLineWidth(lines_width);
-        if (this->face_type == 1) {
+        instancing->setUniformValue("color", QVector4D(f_red, f_green, f_blue, 1));
+        if (face_type == 1) {
             glEnable(GL_LINE_STIPPLE);
             glLineStipple(1, 0x00FF);
         }
-        for (int i = 0; i < probe->faceCount; i++) {  // перебираем полигоны
-            for (int j = 0; j < probe->faces[i].count_number_vertex; j++) {  // перебираем линии в полигоне
-                index1 = probe->faces[i].number_vertex[j] - 1;
-                if (j == probe->faces[i].count_number_vertex - 1)
-                    index2 = probe->faces[i].number_vertex[0] - 1;
-                else
-                    index2 = probe->faces[i].number_vertex[j + 1] - 1;
-                glBegin(GL_LINES);
-                float out_x = 0.0, out_y = 0.0, out_z = 0.0;
-                transform(probe->vertices[index1 * 3], probe->vertices[index1 * 3 + 1], probe->vertices[index1 * 3 + 2], &out_x, &out_y, &out_z);
-                glVertex3f(out_x, out_y, out_z);
-                transform(probe->vertices[index2 * 3], probe->vertices[index2 * 3 + 1], probe->vertices[index2 * 3 + 2], &out_x, &out_y, &out_z);
-                glVertex3f(out_x, out_y, out_z);
-                glEnd();
+        b.edges.bind();
+        f->glDrawElementsInstanced(GL_LINES, b.edge_data.size(), GL_UNSIGNED_INT, nullptr,
+                                   b.instance_count);
+        if (face_type == 1)
+            glDisable(GL_LINE_STIPPLE);
+        for (int c = 0; c < 4; c++) {
+            f->glVertexAttribDivisor(1 + c, 0);
+            f->glDisableVertexAttribArray(1 + c);
+        }
+        f->glDisableVertexAttribArray(0);
+    }
+    QOpenGLBuffer::release(QOpenGLBuffer::VertexBuffer);
+    QOpenGLBuffer::release(QOpenGLBuffer::IndexBuffer);
+    instancing->release();
+}
+
+void View::drawSceneFallback() {
+    // matrix_alt хранится по строкам, glLoadMatrixf ждет столбцы
+    GLfloat view[16];
+    for (int column = 0; column < 4; column++)
+        for (int row = 0; row < 4; row++)
+            view[column * 4 + row] = matrix_alt.matrix[row][column];
+    glEnableClientState(GL_VERTEX_ARRAY);
+    glLineWidth(lines_width);
+    glPointSize(vertices_size);
+    glMatrixMode(GL_MODELVIEW);
+    for (int m = 0; m < scene_buffers.size(); m++) {
+        const mesh_buffers &b = scene_buffers[m];
+        glVertexPointer(3, GL_FLOAT, 0, scene.meshes[m]->vertices);
+        for (int i = 0; i < b.instance_count; i++) {
+            glLoadMatrixf(view);
+            glMultMatrixf(b.matrices.constData() + i * 16);
+            if (vert_type != 0) {
+                glColor3f(v_red, v_green, v_blue);
+                if (vert_type == 1)
+                    glEnable(GL_POINT_SMOOTH);
+                glDrawArrays(GL_POINTS, 0, scene.meshes[m]->vertexCount);
+                if (vert_type == 1)
+                    glDisable(GL_POINT_SMOOTH);
+            }
+            glColor3f(f_red, f_green, f_blue);
+            if (face_type == 1) {
+                glEnable(GL_LINE_STIPPLE);
+                glLineStipple(1, 0x00FF);
             }
+            glDrawElements(GL_LINES, b.edge_data.size(), GL_UNSIGNED_INT, b.edge_data.constData());
+            if (face_type == 1)
+                glDisable(GL_LINE_STIPPLE);
         }
-        if (this->face_type == 1) {
-            glDisable(GL_LINE_STIPPLE);
+    }
+    glLoadIdentity();
+    glDisableClientState(GL_VERTEX_ARRAY);
+}
+
+void View::transformVertices() {
+    float m[3][4];
+    for (int i = 0; i < 3; i++)
+        for (int j = 0; j < 4; j++)
+            m[i][j] = matrix_alt.matrix[i][j];
+    transformed.resize(probe->vertexCount * 3);
+    const float *in = probe->vertices;
+    GLfloat *out = transformed.data();
+    for (int i = 0; i < probe->vertexCount; i++, in += 3, out += 3) {
+        for (int k = 0; k < 3; k++)
+            out[k] = m[k][0] * in[0] + m[k][1] * in[1] + m[k][2] * in[2] + m[k][3];
+    }
+}
+
+void View::drawModel() {
+    glEnableClientState(GL_VERTEX_ARRAY);
+    glVertexPointer(3, GL_FLOAT, 0, transformed.constData());
+    if(vert_type != 0) {
+        glColor3f(v_red, v_green, v_blue);
+        glPointSize(vertices_size);
+        if (vert_type == 1)
+            glEnable(GL_POINT_SMOOTH);
+        glDrawArrays(GL_POINTS, 0, probe->vertexCount);
+        if (vert_type == 1)
+            glDisable(GL_POINT_SMOOTH);
+    }
+    glColor3f(f_red, f_green, f_blue);
+    glLineWidth(lines_width);
+    if (this->face_type == 1) {
+        glEnable(GL_LINE_STIPPLE);
+        glLineStipple(1, 0x00FF);
+    }
+    glDrawElements(GL_LINES, edges.size(), GL_UNSIGNED_INT, edges.constData());
+    if (this->face_type == 1) {
+        glDisable(GL_LINE_STIPPLE);
+    }
+    glDisableClientState(GL_VERTEX_ARRAY);
+}
+
+void View::drawPicked() {
+    if (picked_face < 0 || picked_face >= probe->faceCount) return;
+    const GLfloat *v = transformed.constData();
+    glColor3f(1 - f_red, 1 - f_green, 1 - f_blue);
+    glLineWidth(lines_width + 2);
+    glBegin(GL_LINE_LOOP);
+    for (int j = 0; j < probe->faces[picked_face].count_number_vertex; j++) {
+        int index = probe->faces[picked_face].number_vertex[j] - 1;
+        glVertex3fv(v + index * 3);
+    }
+    glEnd();
+    glLineWidth(lines_width);
+    if (picked_vertex >= 0) {
+        glPointSize(vertices_size + 4);
+        glBegin(GL_POINTS);
+        glVertex3fv(v + picked_vertex * 3);
+        glEnd();
+    }
+}
+
+void View::drawStats() {
+    frame_record average;
+    frame_history_average(&history, &average);
+
+    QPainter painter(this);
+    painter.setPen(QColor::fromRgbF(1 - b_red, 1 - b_green, 1 - b_blue));
+    painter.setFont(QFont("monospace", 9));
+    QStringList lines;
+    lines << QString("кадров: %1, среднее %2 мс (%3 fps)")
+                 .arg(history.frames)
+                 .arg(average.total_ms, 0, 'f', 2)
+                 .arg(average.total_ms > 0 ? 1000.0 / average.total_ms : 0, 0, 'f', 1);
+    lines << QString("загрузка модели: %1 мс").arg(load_ms, 0, 'f', 1);
+    for (int s = 0; s < FRAME_STAGES; s++) {
+        QString line = QString("%1: %2 мс").arg(QString(frame_stage_name(s)), -10)
+                           .arg(average.cpu_ms[s], 0, 'f', 3);
+        if (average.gpu_ms[s] >= 0)
+            line += QString(", gpu %1 мс").arg(average.gpu_ms[s], 0, 'f', 3);
+        lines << line;
+    }
+    if (average.gpu_ms[STAGE_DRAW] < 0)
+        lines << QString("gpu: нет timer query");
+    int y = 14;
+    for (const QString &line : lines) {
+        painter.drawText(8, y, line);
+        y += 14;
+    }
+
+    // столбики полного времени кадра, масштаб по максимуму в истории
+    double max_ms = 0;
+    for (int i = 0; i < history.count; i++)
+        max_ms = qMax(max_ms, frame_history_at(&history, i)->total_ms);
+    int bar_height = 40;
+    for (int i = 0; i < history.count && max_ms > 0; i++) {
+        int h = frame_history_at(&history, i)->total_ms / max_ms * bar_height;
+        painter.drawLine(8 + i, height() - 8, 8 + i, height() - 8 - h);
+    }
+}
+
+void View::mousePressEvent(QMouseEvent *event) {
+    if (event->button() == Qt::LeftButton && probe != NULL && bvh.nodeCount > 0) {
+        pick(2.0 * event->position().x() / width() - 1.0,
+             1.0 - 2.0 * event->position().y() / height());
+    }
+    QOpenGLWidget::mousePressEvent(event);
+}
+
+void View::pick(float ndc_x, float ndc_y) {
+    // проекция единичная, поэтому луч в NDC идет от z = -1 к z = 1,
+    // а в координаты модели его переводит обратная matrix_alt
+    matrix_t inverse = s21_inverse_matrix(&matrix_alt);
+    if (inverse.matrix_type != OK) return;
+    float ends[2][3];
+    for (int e = 0; e < 2; e++) {
+        float ndc[4] = {ndc_x, ndc_y, e == 0 ? -1.0f : 1.0f, 1.0f};
+        float w = 0;
+        for (int k = 0; k < 4; k++) w += inverse.matrix[3][k] * ndc[k];
+        for (int i = 0; i < 3; i++) {
+            ends[e][i] = 0;
+            for (int k = 0; k < 4; k++) ends[e][i] += inverse.matrix[i][k] * ndc[k];
+            ends[e][i] /= w;
         }
     }
+    s21_remove_matrix(&inverse);
+
+    float dir[3] = {ends[1][0] - ends[0][0], ends[1][1] - ends[0][1], ends[1][2] - ends[0][2]};
+    pick_result result;
+    if (bvh_pick(&bvh, probe, ends[0], dir, &result) == EXIT_SUCCESS) {
+        picked_face = result.face;
+        picked_vertex = result.vertex;
+        emit elementPicked(result.face, result.vertex,
+                           probe->vertices[result.vertex * 3],
+                           probe->vertices[result.vertex * 3 + 1],
+                           probe->vertices[result.vertex * 3 + 2]);
+    } else {
+        picked_face = picked_vertex = -1;
+    }
+    update();
 }
 
 
@@ -71,16 +473,3 @@ void View::resizeGL(int w, int h) {
   glMatrixMode(GL_MODELVIEW);
   glLoadIdentity();
 }
-
-void View::transform(float input_x, float input_y, float input_z, float *output_x, float *output_y, float *output_z) {
-    matrix_t B = s21_create_matrix(4, 1);
-    B.matrix[0][0] = input_x;
-    B.matrix[1][0] = input_y;
-    B.matrix[2][0] = input_z;
-    B.matrix[3][0] = 1.0;
-    matrix_t C = s21_mult_matrix(&matrix_alt, &B);
-    *output_x = C.matrix[0][0];
-    *output_y = C.matrix[1][0];
-    *output_z = C.matrix[2][0];
-    s21_remove_matrix(&B);
-}
@@ -4,8 +4,12 @@
 #define GL_SILENCE_DEPRECATION
 
 #include <QOpenGLWidget>
+#include <QOpenGLBuffer>
 #include <QOpenGLFunctions>
+#include <QOpenGLShaderProgram>
+#include <QOpenGLTimeMonitor>
 #include <QColor>
+#include <QVector>
 
 extern "C" {
      #include "parser.h"
@@ -17,12 +21,14 @@ extern "C" {
 #define COEFF_ROTATE 0.0628319
 #define COEFF_SHIFT 0.01
 #define COEFF_SCALE 0.6
+#define FRAME_HISTORY_SIZE 240
 
 class View: public QOpenGLWidget, public QOpenGLFunctions
 {
     Q_OBJECT
 public:
     View(QWidget *parent = nullptr);
+    ~View();
 
     OBJData *probe = {};
 
@@ -36,13 +42,71 @@ public:
     double f_red = 1, f_green = 1, f_blue = 1;
     double b_red = 0, b_green = 0, b_blue = 0;
     matrix_t matrix_alt;
+    bvh_t bvh = {};
+    int picked_face = -1;
+    int picked_vertex = -1;
+    bool show_stats = false;
+    double load_ms = 0;
+    frame_history history = {};
+    scene_t scene = {};
+
+    /// @brief Сообщает, что probe заменена и буфер ребер надо пересобрать.
+    void modelChanged();
+
+    /// @brief Сообщает, что сцена заменена и ее буферы надо пересобрать.
+    void sceneChanged();
+
+    /// @brief Открыта ли модель или сцена.
+    bool hasModel() const;
+
+    /// @brief Максимальная координата открытой модели или сцены.
+    float maxVertexValue() const;
+
+signals:
+    /// @brief Выбор грани и ближайшей к точке клика вершины.
+    /// @param face Индекс грани (с нуля).
+    /// @param vertex Индекс вершины (с нуля).
+    /// @param x, y, z Координаты вершины в системе модели.
+    void elementPicked(int face, int vertex, float x, float y, float z);
 
 protected:
     void initializeGL() override;
     void resizeGL(int w, int h) override;
     void paintGL() override;
+    void mousePressEvent(QMouseEvent *event) override;
 private:
-    void transform(float, float, float, float*, float*, float*);
+    void uploadEdges();
+    void transformVertices();
+    void drawModel();
+    void uploadScene();
+    void drawScene();
+    void drawSceneFallback();
+    void drawPicked();
+    void drawStats();
+    bool beginGpuTimer(frame_record *record);
+    void endGpuStage(bool timing);
+    void pick(float ndc_x, float ndc_y);
+
+    QVector<GLuint> edges;
+    QVector<GLfloat> transformed;
+    bool edges_dirty = true;
+
+    /// @brief Буферы одной модели сцены: вершины, ребра и матрицы экземпляров.
+    struct mesh_buffers {
+        QOpenGLBuffer vertices{QOpenGLBuffer::VertexBuffer};
+        QOpenGLBuffer edges{QOpenGLBuffer::IndexBuffer};
+        QOpenGLBuffer instances{QOpenGLBuffer::VertexBuffer};
+        QVector<GLuint> edge_data;
+        QVector<GLfloat> matrices;
+        int instance_count = 0;
+    };
+    QVector<mesh_buffers> scene_buffers;
+    QOpenGLShaderProgram *instancing = nullptr;
+    bool scene_dirty = true;
+
+    QOpenGLTimeMonitor *gpu_monitors[2] = {};
+    bool gpu_pending[2] = {};
+    int gpu_frame = 0;
 
 };
 